@@ -0,0 +1,40 @@
+#pragma once
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <format>
+#include <string>
+
+namespace HKSL::Bench {
+
+// `n_functions` small functions, about 50 tokens and 150 bytes each
+inline std::string functions(size_t n_functions) {
+    std::string source;
+    for(size_t i = 0; i < n_functions; i++) {
+        source += std::format(
+            "fn f{}(a: float, b: float3) -> float3 {{\n"
+            "    let c = a * {}.5 + 0.125;\n"
+            "    if c {{\n        return b * c - b / a;\n    }}\n"
+            "    return float3(c, a, 1.0e2);\n"
+            "}}\n", i, i % 100);
+    }
+    return source;
+}
+
+// Runs `body` for every iteration of `state`, whose first argument is the
+// thread count, and reports the speedup over the 1 thread run before it
+template<typename F>
+void thread_scaling(benchmark::State& state, F&& body) {
+    static double seconds_one_thread = 0;
+    double seconds = 0;
+    for(auto _: state) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    seconds /= state.iterations();
+    if(state.range(0) == 1) {
+        seconds_one_thread = seconds;
+    }
+    state.counters["speedup"] = seconds_one_thread / seconds;
+}
+}
@@ -0,0 +1,141 @@
+#include "BenchUtil.h"
+#include <Parse/LexerTables.h>
+#include <random>
+
+using namespace HKSL;
+
+// The dispatch Lexer::token() used before LexerTables, kept here to compare
+// against: a chain of two then one character compares for operators and of
+// string compares for keywords
+static const char* branchy_operator(const char* p, TokenKind& kind) {
+    auto two = [&] (char first, char second) { return p[0] == first && p[1] == second; };
+    if(two('+', '=')) { kind = TokenKind::PlusEqual; return p + 2; }
+    if(two('-', '=')) { kind = TokenKind::MinusEqual; return p + 2; }
+    if(two('*', '=')) { kind = TokenKind::StarEqual; return p + 2; }
+    if(two('/', '=')) { kind = TokenKind::SlashEqual; return p + 2; }
+    if(two('=', '=')) { kind = TokenKind::DoubleEquals; return p + 2; }
+    if(two('-', '>')) { kind = TokenKind::RightArrow; return p + 2; }
+    switch(*p) {
+        case '+': kind = TokenKind::Plus; break;
+        case '-': kind = TokenKind::Minus; break;
+        case '*': kind = TokenKind::Star; break;
+        case '/': kind = TokenKind::Slash; break;
+        case ',': kind = TokenKind::Comma; break;
+        case '.': kind = TokenKind::Dot; break;
+        case ';': kind = TokenKind::Semicolon; break;
+        case ':': kind = TokenKind::Colon; break;
+        case '=': kind = TokenKind::Equals; break;
+        case '(': kind = TokenKind::LeftRound; break;
+        case ')': kind = TokenKind::RightRound; break;
+        case '[': kind = TokenKind::LeftSquare; break;
+        case ']': kind = TokenKind::RightSquare; break;
+        case '{': kind = TokenKind::LeftCurly; break;
+        case '}': kind = TokenKind::RightCurly; break;
+    }
+    return p + 1;
+}
+static std::optional<TokenKind> branchy_keyword(std::string_view text) {
+    if(text == "fn") return TokenKind::KeywordFn;
+    if(text == "if") return TokenKind::KeywordIf;
+    if(text == "else") return TokenKind::KeywordElse;
+    if(text == "let") return TokenKind::KeywordLet;
+    if(text == "return") return TokenKind::KeywordReturn;
+    if(text == "struct") return TokenKind::KeywordStruct;
+    if(text == "uniform") return TokenKind::KeywordUniform;
+    return std::nullopt;
+}
+
+// Lexer::operator_token() without the Lexer around it
+static const char* table_operator(const char* p, TokenKind& kind) {
+    const auto& dfa = LexerTables::OPERATOR_DFA;
+    size_t state = dfa.next[0][(uint8_t) *p];
+    size_t accepted = state;
+    const char* accepted_end = ++p;
+    while(size_t next = dfa.next[state][(uint8_t) *p]) {
+        state = next;
+        p++;
+        if(dfa.accepting[state]) {
+            accepted = state;
+            accepted_end = p;
+        }
+    }
+    kind = dfa.accept[accepted];
+    return accepted_end;
+}
+
+// 1M operators drawn from every spelling, back to back
+static const std::string& operators() {
+    static const std::string text = [] {
+        std::mt19937 rng(1);
+        std::string text;
+        for(int i = 0; i < 1000000; i++) {
+            text += LexerTables::OPERATORS[rng() % std::size(LexerTables::OPERATORS)].text;
+            // Keeps `=` followed by `=` from lexing as `==`
+            text += ' ';
+        }
+        return text;
+    }();
+    return text;
+}
+// 64K names, a third of them keywords, views into the spellings so the
+// loop measures the lookup rather than cache misses
+static const std::vector<std::string_view>& names() {
+    static const std::vector<std::string_view> names = [] {
+        std::mt19937 rng(1);
+        const std::string_view identifiers[] = {"a", "position", "normal", "f12", "light_color", "return_value", "l", "fnord"};
+        std::vector<std::string_view> names;
+        for(int i = 0; i < 65536; i++) {
+            if(rng() % 3 == 0) {
+                names.push_back(LexerTables::KEYWORDS[rng() % std::size(LexerTables::KEYWORDS)].text);
+            } else {
+                names.push_back(identifiers[rng() % std::size(identifiers)]);
+            }
+        }
+        return names;
+    }();
+    return names;
+}
+
+template<const char* (*Operator)(const char*, TokenKind&)>
+static void BM_Operators(benchmark::State& state) {
+    const std::string& text = operators();
+    for(auto _: state) {
+        TokenKind kind = TokenKind::Eof;
+        for(const char* p = text.data(); *p; p++) {
+            p = Operator(p, kind);
+            benchmark::DoNotOptimize(kind);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 1000000);
+}
+template<std::optional<TokenKind> (*Keyword)(std::string_view)>
+static void BM_Keywords(benchmark::State& state) {
+    const auto& text = names();
+    for(auto _: state) {
+        for(std::string_view name: text) {
+            benchmark::DoNotOptimize(Keyword(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_Operators<branchy_operator>)->Name("BM_Operators/branchy");
+BENCHMARK(BM_Operators<table_operator>)->Name("BM_Operators/table");
+BENCHMARK(BM_Keywords<branchy_keyword>)->Name("BM_Keywords/branchy");
+BENCHMARK(BM_Keywords<Lexer::is_keyword>)->Name("BM_Keywords/table");
+
+// The whole lexer over generated functions, for scale
+static void BM_Lexer(benchmark::State& state) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("bench.hksl", Bench::functions(20000));
+    size_t n_tokens = 0;
+    for(auto _: state) {
+        Lexer lexer(sources.file(file), symbols);
+        while(lexer.token().kind != TokenKind::Eof) {
+            n_tokens++;
+        }
+    }
+    state.SetItemsProcessed(n_tokens);
+    state.SetBytesProcessed(state.iterations() * sources.file(file).text().size());
+}
+BENCHMARK(BM_Lexer);
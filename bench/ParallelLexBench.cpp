@@ -0,0 +1,19 @@
+#include "BenchUtil.h"
+#include <Parse/ParallelLexer.h>
+
+using namespace HKSL;
+
+// Lexing 100k functions, about 15MB, on 1 to 8 threads
+static void BM_ParallelLex(benchmark::State& state) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("bench.hksl", Bench::functions(100000));
+    ThreadPool pool(state.range(0));
+
+    Bench::thread_scaling(state, [&] {
+        TokenBuffer tokens = lex_parallel(sources.file(file), symbols, pool);
+        benchmark::DoNotOptimize(tokens);
+    });
+    state.SetBytesProcessed(state.iterations() * sources.file(file).text().size());
+}
+BENCHMARK(BM_ParallelLex)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,23 @@
+#include "BenchUtil.h"
+#include <Context.h>
+#include <Parse/ParallelParser.h>
+
+using namespace HKSL;
+
+// Parsing 40k functions, about 1.4M tokens, on 1 to 8 threads
+static void BM_ParallelParse(benchmark::State& state) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("bench.hksl", Bench::functions(40000));
+    CompilationContext context(symbols, sources);
+    Lexer lexer(sources.file(file), symbols);
+    TokenBuffer tokens = lexer.collect_tokens();
+    ThreadPool pool(state.range(0));
+
+    Bench::thread_scaling(state, [&] {
+        AST ast = parse_parallel(context, tokens, pool);
+        benchmark::DoNotOptimize(ast);
+    });
+    state.SetItemsProcessed(state.iterations() * tokens.size());
+}
+BENCHMARK(BM_ParallelParse)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,74 @@
+#include "BenchUtil.h"
+#include <Parse/Scan.h>
+#include <Source.h>
+#include <random>
+
+using namespace HKSL;
+
+static const Scanner* scanner_named(std::string_view name) {
+    if(name == "sse2") {
+        return Scanner::sse2();
+    }
+    if(name == "avx2") {
+        return Scanner::avx2();
+    }
+    return &Scanner::scalar();
+}
+// 4MB of runs of `run_chars`, each `min_run` to `max_run` long and ended
+// by `stop`, the shape of the input each scanner sees in real sources
+static std::string runs(const char* run_chars, size_t min_run, size_t max_run, char stop) {
+    std::mt19937 rng(1);
+    std::string_view chars(run_chars);
+    std::string text;
+    while(text.size() < 4 * 1024 * 1024) {
+        for(size_t n = std::uniform_int_distribution<size_t>(min_run, max_run)(rng); n > 0; n--) {
+            text += chars[rng() % chars.size()];
+        }
+        text += stop;
+    }
+    return text;
+}
+// MB/s of `scanner_name`'s `skip` over `text`, stepping over every stop byte
+static void scan(benchmark::State& state, const char* scanner_name, auto skip, const std::string& text) {
+    const Scanner* scanner = scanner_named(scanner_name);
+    if(!scanner) {
+        state.SkipWithError("not supported by this CPU");
+        return;
+    }
+    SourceManager sources;
+    std::string_view source = sources.file(sources.add_buffer("bench.hksl", text)).text();
+    const char* end = source.data() + source.size();
+
+    for(auto _: state) {
+        for(const char* p = source.data(); p < end; p++) {
+            p = (scanner->*skip)(p);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+// Indentation and the spaces between tokens
+static void BM_SkipWhiteSpace(benchmark::State& state, const char* scanner_name) {
+    static const std::string text = runs("    \n", 1, 12, 'x');
+    scan(state, scanner_name, &Scanner::skip_white_space, text);
+}
+// Comment bodies
+static void BM_SkipLine(benchmark::State& state, const char* scanner_name) {
+    static const std::string text = runs("abc xyz,.;()", 20, 80, '\n');
+    scan(state, scanner_name, &Scanner::skip_line, text);
+}
+// Names after their first character
+static void BM_SkipIdentifier(benchmark::State& state, const char* scanner_name) {
+    static const std::string text = runs("abcdefxyz_0189", 1, 16, ' ');
+    scan(state, scanner_name, &Scanner::skip_identifier, text);
+}
+BENCHMARK_CAPTURE(BM_SkipWhiteSpace, scalar, "scalar");
+BENCHMARK_CAPTURE(BM_SkipWhiteSpace, sse2, "sse2");
+BENCHMARK_CAPTURE(BM_SkipWhiteSpace, avx2, "avx2");
+BENCHMARK_CAPTURE(BM_SkipLine, scalar, "scalar");
+BENCHMARK_CAPTURE(BM_SkipLine, sse2, "sse2");
+BENCHMARK_CAPTURE(BM_SkipLine, avx2, "avx2");
+BENCHMARK_CAPTURE(BM_SkipIdentifier, scalar, "scalar");
+BENCHMARK_CAPTURE(BM_SkipIdentifier, sse2, "sse2");
+BENCHMARK_CAPTURE(BM_SkipIdentifier, avx2, "avx2");
@@ -0,0 +1,31 @@
+#include "BenchUtil.h"
+#include <Parse/Parser.h>
+#include <TypeCheck.h>
+
+using namespace HKSL;
+
+// Types `1.0 + 1.0 + ... ;` with as many terms as the argument, on one
+// thread. Inference is one bottom-up walk, the time should grow linearly.
+static void BM_InferSum(benchmark::State& state) {
+    std::string source = "1.0";
+    for(int64_t i = 1; i < state.range(0); i++) {
+        source += " + 1.0";
+    }
+    source += ";";
+
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("bench.hksl", source);
+    CompilationContext context(symbols, sources);
+    Lexer lexer(sources.file(file), symbols);
+    Parser parser(context, lexer);
+    context.set_ast(parser.program());
+    ThreadPool pool(1);
+
+    for(auto _: state) {
+        TypeInferenceVisitor type_inference(context);
+        benchmark::DoNotOptimize(type_inference.run(pool));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_InferSum)->RangeMultiplier(10)->Range(1'000, 1'000'000)->Complexity(benchmark::oN)->Unit(benchmark::kMillisecond);
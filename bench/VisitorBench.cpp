@@ -0,0 +1,214 @@
+#include "BenchUtil.h"
+#include <Parse/Parser.h>
+#include <Visitor.h>
+
+using namespace HKSL;
+
+// The Visitor before it took the pass as a template parameter, every hook
+// virtual, kept here to compare against
+class VirtualVisitor {
+    public:
+        virtual ~VirtualVisitor() = default;
+        virtual void visit(AST& ast) {
+            current_ast = &ast;
+            for(NodeId statement: ast.top_level()) {
+                visit_statement(statement);
+            }
+        }
+        virtual void visit_statement(NodeId statement) {
+            switch(ast().kind(statement)) {
+                case NodeKind::ExprStatement:
+                    return visit_expr_statement(statement, ast().expr_statement(statement));
+                case NodeKind::If:
+                    return visit_if_statement(statement, ast().if_statement(statement));
+                case NodeKind::Else:
+                    return visit_else_statement(statement, ast().else_statement(statement));
+                case NodeKind::Block:
+                    return visit_block_statement(statement, ast().block_statement(statement));
+                case NodeKind::Function:
+                    return visit_function(statement, ast().function(statement));
+                case NodeKind::Return:
+                    return visit_return_statement(statement, ast().return_statement(statement));
+                default:
+                    HKSL_TODO();
+            }
+        }
+        virtual void visit_expr_statement(NodeId, const ExprStatement& expr) {
+            visit_expr(expr.expr);
+        }
+        virtual void visit_if_statement(NodeId, const IfStatement& if_statement) {
+            visit_expr(if_statement.condition);
+            visit_block_statement(if_statement.then_block, ast().block_statement(if_statement.then_block));
+            if(if_statement.else_stmt != NO_NODE) {
+                visit_statement(if_statement.else_stmt);
+            }
+        }
+        virtual void visit_else_statement(NodeId, const ElseStatement& else_statement) {
+            visit_statement(else_statement.statement);
+        }
+        virtual void visit_block_statement(NodeId, const BlockStatement& block) {
+            for(NodeId statement: block.statements) {
+                visit_statement(statement);
+            }
+        }
+        virtual void visit_function(NodeId, const Function& function) {
+            visit_function_name(function.name);
+            for(NodeId arg: function.args) {
+                visit_function_arg(arg);
+            }
+            if(function.return_type) {
+                visit_type(function.return_type);
+            }
+            visit_block_statement(function.block, ast().block_statement(function.block));
+        }
+        virtual void visit_return_statement(NodeId, const ReturnStatement& return_statement) {
+            if(return_statement.value != NO_NODE) {
+                visit_expr(return_statement.value);
+            }
+        }
+        virtual void visit_expr(NodeId expr) {
+            switch(ast().kind(expr)) {
+                case NodeKind::BinExpr:
+                    return visit_binary_expr(expr, ast().bin_expr(expr));
+                case NodeKind::UnaryExpr:
+                    return visit_unary_expr(expr, ast().unary_expr(expr));
+                case NodeKind::Variable:
+                    return visit_variable(expr, ast().variable(expr));
+                case NodeKind::VarDecl:
+                    return visit_var_decl(expr, ast().var_decl(expr));
+                case NodeKind::NumberConstant:
+                    return visit_number_constant(expr, ast().number_constant(expr));
+                case NodeKind::CallExpr:
+                    return visit_call_expr(expr, ast().call_expr(expr));
+                case NodeKind::AssignmentExpr:
+                    return visit_assignment_expr(expr, ast().assignment_expr(expr));
+                case NodeKind::LetExpr:
+                    return visit_let_expr(expr, ast().let_expr(expr));
+                default:
+                    HKSL_UNREACHABLE();
+            }
+        }
+        virtual void visit_binary_expr(NodeId, const BinExpr& expr) {
+            visit_binary_op(expr.op);
+            visit_expr(expr.left);
+            visit_expr(expr.right);
+        }
+        virtual void visit_unary_expr(NodeId, const UnaryExpr& expr) {
+            visit_unary_op(expr.op);
+            visit_expr(expr.expr);
+        }
+        virtual void visit_variable(NodeId, const Variable& variable) {
+            visit_variable_name(variable.name);
+        }
+        virtual void visit_var_decl(NodeId, const VarDecl& var_decl) {
+            visit_variable_name(var_decl.name);
+            if(var_decl.type) {
+                visit_type(var_decl.type);
+            }
+        }
+        virtual void visit_number_constant(NodeId, const NumberConstant&) {}
+        virtual void visit_call_expr(NodeId, const CallExpr& expr) {
+            visit_function_name(expr.fn_name);
+            for(NodeId arg: expr.args) {
+                visit_call_arg(arg);
+            }
+        }
+        virtual void visit_assignment_expr(NodeId, const AssignmentExpr& expr) {
+            visit_expr(expr.lhs);
+            visit_expr(expr.rhs);
+        }
+        virtual void visit_let_expr(NodeId, const LetExpr& expr) {
+            visit_var_decl(expr.var_decl, ast().var_decl(expr.var_decl));
+            if(expr.rhs != NO_NODE) {
+                visit_expr(expr.rhs);
+            }
+        }
+        virtual void visit_binary_op(BinOp) {}
+        virtual void visit_unary_op(UnaryOp) {}
+        virtual void visit_variable_name(const Identifier& name) {
+            visit_identifier(name);
+        }
+        virtual void visit_function_name(const Identifier& name) {
+            visit_identifier(name);
+        }
+        virtual void visit_identifier(const Identifier&) {}
+        virtual void visit_type(Type*) {}
+        virtual void visit_function_arg(NodeId arg) {
+            visit_var_decl(arg, ast().var_decl(arg));
+        }
+        virtual void visit_call_arg(NodeId arg) {
+            visit_expr(arg);
+        }
+    protected:
+        AST& ast() {
+            return *current_ast;
+        }
+    private:
+        AST* current_ast = nullptr;
+};
+
+// The same pass on both: counts names and constants, every other hook is
+// the default walk
+class VirtualCounter: public VirtualVisitor {
+    public:
+        size_t count = 0;
+        void visit_identifier(const Identifier&) override {
+            count++;
+        }
+        void visit_number_constant(NodeId, const NumberConstant&) override {
+            count++;
+        }
+};
+class Counter: public Visitor<Counter> {
+    public:
+        size_t count = 0;
+        void visit_identifier(const Identifier&) {
+            count++;
+        }
+        void visit_number_constant(NodeId, const NumberConstant&) {
+            count++;
+        }
+};
+
+// 60k functions, about 9MB of source
+struct ParsedSource {
+    SymbolInterner symbols;
+    SourceManager sources;
+    CompilationContext context {symbols, sources};
+    AST ast;
+
+    ParsedSource() {
+        uint32_t file = sources.add_buffer("bench.hksl", Bench::functions(60000));
+        Lexer lexer(sources.file(file), symbols);
+        TokenBuffer tokens = lexer.collect_tokens();
+        Parser parser(context, tokens);
+        ast = parser.program();
+    }
+    static ParsedSource& get() {
+        static ParsedSource parsed;
+        return parsed;
+    }
+};
+
+static void BM_Walk_Virtual(benchmark::State& state) {
+    AST& ast = ParsedSource::get().ast;
+    for(auto _: state) {
+        VirtualCounter counter;
+        // Behind a pointer the compiler can't see through, as when passes
+        // lived in their own translation units
+        VirtualVisitor* visitor = &counter;
+        benchmark::DoNotOptimize(visitor);
+        visitor->visit(ast);
+        benchmark::DoNotOptimize(counter.count);
+    }
+}
+static void BM_Walk_CRTP(benchmark::State& state) {
+    AST& ast = ParsedSource::get().ast;
+    for(auto _: state) {
+        Counter counter;
+        counter.visit(ast);
+        benchmark::DoNotOptimize(counter.count);
+    }
+}
+BENCHMARK(BM_Walk_Virtual)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Walk_CRTP)->Unit(benchmark::kMillisecond);
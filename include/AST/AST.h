@@ -1,16 +1,16 @@
 #pragma once
+#include <span>
 #include <string>
 #include <Parse/Lexer.h>
+#include <AST/NodeId.h>
 #include <AST/Printer.h>
 #include <Typing.h>
-#include <Function.h>
+#include <ThreadPool.h>
 
 namespace HKSL {
-struct ASTNode: ASTPrint {
-    virtual ~ASTNode() = default;
-};
 
-enum class ExprKind {
+enum class NodeKind: uint8_t {
+    // Expressions
     BinExpr,
     UnaryExpr,
     NumberConstant,
@@ -19,23 +19,29 @@ enum class ExprKind {
     CallExpr,
     AssignmentExpr,
     LetExpr,
-};
-
-bool expr_kind_is_place(ExprKind kind);
-const char* expr_kind_to_string(ExprKind kind);
 
-struct Expr: public ASTNode {
-    virtual ~Expr() = default;
-    virtual ExprKind kind() const = 0;
+    // Statements
+    ExprStatement,
+    If,
+    Else,
+    Block,
+    Function,
+    Return,
+    Struct,
+    Uniform,
 };
 
-enum class UnaryOp {
+bool node_kind_is_expr(NodeKind kind);
+bool node_kind_is_place(NodeKind kind);
+const char* node_kind_to_string(NodeKind kind);
+
+enum class UnaryOp: uint8_t {
     Negate
 };
 
 std::string unary_op_to_string(UnaryOp op);
 
-enum class BinOp {
+enum class BinOp: uint8_t {
     Add,
     Subtract,
     Multiply,
@@ -45,179 +51,177 @@ enum class BinOp {
 
 std::string bin_op_to_string(BinOp op);
 
-struct UnaryExpr: public Expr {
-    UnaryExpr(UnaryOp op, std::unique_ptr<Expr> expr, Token op_token);
-
-    UnaryOp op;
-    Token op_token;
-    std::unique_ptr<Expr> expr;
-
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
+// How often the host changes a uniform, from least to most often
+enum class UpdateFrequency: uint8_t {
+    Frame,
+    Material,
+    Draw,
 };
+const char* update_frequency_to_string(UpdateFrequency frequency);
 
-struct BinExpr: public Expr {
-    BinExpr(BinOp op, std::unique_ptr<Expr> left, std::unique_ptr<Expr> right, Token op_token);
-    
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
+// Decoded views of a single node, returned by value from the AST accessors.
+// Optional children are NO_NODE when absent, child lists point into the AST
+// and stay valid as long as no nodes are added.
+struct BinExpr {
     BinOp op;
-    Token op_token;
-    std::unique_ptr<Expr> left;
-    std::unique_ptr<Expr> right;
+    NodeId left;
+    NodeId right;
+    Span op_span;
 };
-
-struct NumberConstant: public Expr {
-    NumberConstant(NumberLiteral literal);
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
+struct UnaryExpr {
+    UnaryOp op;
+    NodeId expr;
+    Span op_span;
+};
+struct NumberConstant {
     NumberLiteral number_literal;
 };
-
-struct Variable: public Expr {
-    Variable(const Identifier& name);
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
+struct Variable {
     Identifier name;
 };
-struct VarDecl: public Expr {
-    VarDecl(const Identifier& name);
-    VarDecl(const Identifier& name, std::optional<Type*>& type);
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
+struct VarDecl {
     Identifier name;
-    std::optional<Type*> type;
+    // nullptr until given explicitly or inferred
+    Type* type;
 };
-
-using CallArgs = std::vector<std::unique_ptr<Expr>>;
-struct CallExpr: public Expr {
-    CallExpr(const Identifier& fn_name, std::vector<std::unique_ptr<Expr>>& args);
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
+struct CallExpr {
     Identifier fn_name;
-    std::vector<std::unique_ptr<Expr>> args;
+    std::span<const NodeId> args;
 };
-
-struct AssignmentExpr: public Expr {
-    AssignmentExpr(std::unique_ptr<Expr> lhs, std::unique_ptr<Expr> rhs, Token eq_token);
-
-    std::unique_ptr<Expr> lhs;
-    std::unique_ptr<Expr> rhs;
-    Token eq_token;
-
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
+struct AssignmentExpr {
+    NodeId lhs;
+    NodeId rhs;
+    Span eq_span;
 };
-
-struct LetExpr: public Expr {
-    LetExpr(std::unique_ptr<VarDecl> var_decl, const std::optional<Identifier>& type, std::optional<std::unique_ptr<Expr>> rhs);
-
-    std::unique_ptr<VarDecl> var_decl;
-    std::optional<std::unique_ptr<Expr>> rhs;
-
-    ExprKind kind() const override;
-    void print(ASTPrinter& printer) const override;
+struct LetExpr {
+    NodeId var_decl;
+    NodeId rhs;
 };
-
-enum class StatementKind {
-    Expr,
-    If,
-    Else,
-    Block,
-    Function,
-    Return,
+struct ExprStatement {
+    NodeId expr;
 };
-
-struct Statement: public ASTNode {
-    virtual ~Statement() = default;
-
-    virtual StatementKind kind() const = 0;
+struct BlockStatement {
+    std::span<const NodeId> statements;
 };
-
-struct ExprStatement: public Statement {
-    ExprStatement(std::unique_ptr<Expr> expr);
-    std::unique_ptr<Expr> expr;
-    
-    StatementKind kind() const override;
-    void print(ASTPrinter& printer) const override;
+struct IfStatement {
+    NodeId condition;
+    NodeId then_block;
+    NodeId else_stmt;
 };
-struct BlockStatement: public Statement {
-    BlockStatement(std::vector<std::unique_ptr<Statement>>& statements);
-    std::vector<std::unique_ptr<Statement>> statements;
-
-    StatementKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-};
-
-struct ElseStatement;
-
-struct IfStatement: public Statement {
-    IfStatement(std::unique_ptr<Expr> condtion, std::unique_ptr<BlockStatement> block, std::optional<std::unique_ptr<ElseStatement>> else_stmt);
-    StatementKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<BlockStatement> then_block;
-    std::optional<std::unique_ptr<ElseStatement>> else_stmt;
-};
-
-struct ElseStatement: public Statement {
-    ElseStatement(std::unique_ptr<Statement> statement);
-    StatementKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
-    std::unique_ptr<Statement> statement;
+struct ElseStatement {
+    NodeId statement;
 };
-
-// struct FunctionArg: ASTPrint {
-//     std::unique_ptr<Variable> variable;
-//     Identifier type;    
-//     FunctionArg(std::unique_ptr<Variable> name, const Identifier& type);
-
-//     void print(ASTPrinter& printer) const override; 
-// };
-
-using FunctionArgs = std::vector<VarDecl>;
-struct Function: public Statement, public FunctionDef {
-    Function(const Identifier& name, FunctionArgs& args, std::unique_ptr<BlockStatement> block, Type* return_type);
-    Identifier m_name;
-    FunctionArgs m_args;
-    std::unique_ptr<BlockStatement> m_block;
-    Type* m_return_type;
-
-    const char* name() const override;
-    Type* arg_at(size_t i) const override;
-    Type* return_type() const override;
-    size_t n_args() const override;
-
-    StatementKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
-};
-
-struct ReturnStatement: public Statement {
-    ReturnStatement(std::optional<std::unique_ptr<Expr>> value, Token ret_token);
-    
-    StatementKind kind() const override;
-    void print(ASTPrinter& printer) const override;
-
-    Token ret_token;
-    std::optional<std::unique_ptr<Expr>> value;
+struct Function {
+    Identifier name;
+    // VarDecl nodes
+    std::span<const NodeId> args;
+    NodeId block;
+    Type* return_type;
 };
-
-
-struct AST: ASTNode {
+struct StructDecl {
+    Identifier name;
+    // VarDecl nodes, in declaration order
+    std::span<const NodeId> fields;
+    Type* type;
+};
+struct UniformDecl {
+    NodeId var_decl;
+    UpdateFrequency frequency;
+};
+struct ReturnStatement {
+    NodeId value;
+    Span ret_span;
+};
+
+// Flat syntax tree of one source file. Node kinds, spans and up to three
+// 32-bit fields per node sit in parallel arrays, child lists and the few
+// nodes needing more fields spill into `extra`.
+// The arrays are the AST's arena: adding a node allocates only when one
+// of them grows, and dropping the tree frees a handful of buffers without
+// visiting any node.
+class AST: public ASTPrint {
     public:
-        AST(std::vector<std::unique_ptr<Statement>>& statements);
-        friend class ASTPrinter;
-        friend class Visitor;
+        AST(uint32_t file = 0);
+        // Joins ASTs parsed from consecutive parts of one file, node ids of
+        // each part are shifted past the parts before it. Each part is
+        // copied into place by its own task.
+        static AST concatenate(uint32_t file, std::span<const AST> parts, ThreadPool& pool);
+        size_t size() const;
+        NodeKind kind(NodeId node) const;
+        Span span(NodeId node) const;
+        std::span<const NodeId> top_level() const;
+
+        BinExpr bin_expr(NodeId node) const;
+        UnaryExpr unary_expr(NodeId node) const;
+        NumberConstant number_constant(NodeId node) const;
+        Variable variable(NodeId node) const;
+        VarDecl var_decl(NodeId node) const;
+        CallExpr call_expr(NodeId node) const;
+        AssignmentExpr assignment_expr(NodeId node) const;
+        LetExpr let_expr(NodeId node) const;
+        ExprStatement expr_statement(NodeId node) const;
+        BlockStatement block_statement(NodeId node) const;
+        IfStatement if_statement(NodeId node) const;
+        ElseStatement else_statement(NodeId node) const;
+        Function function(NodeId node) const;
+        ReturnStatement return_statement(NodeId node) const;
+        StructDecl struct_decl(NodeId node) const;
+        UniformDecl uniform_decl(NodeId node) const;
+        // Filled in by type inference for declarations without a type
+        void set_var_type(NodeId var_decl, Type* type);
+
+        // Children must be added before their parents
+        NodeId add_bin_expr(BinOp op, NodeId left, NodeId right, Span op_span);
+        NodeId add_unary_expr(UnaryOp op, NodeId expr, Span op_span);
+        NodeId add_number_constant(NumberLiteral literal, Span span);
+        NodeId add_variable(const Identifier& name);
+        NodeId add_var_decl(const Identifier& name, Type* type);
+        NodeId add_call_expr(const Identifier& fn_name, std::span<const NodeId> args);
+        NodeId add_assignment_expr(NodeId lhs, NodeId rhs, Span eq_span);
+        NodeId add_let_expr(NodeId var_decl, NodeId rhs, Span let_span);
+        NodeId add_expr_statement(NodeId expr);
+        NodeId add_block_statement(std::span<const NodeId> statements, Span span);
+        NodeId add_if_statement(NodeId condition, NodeId then_block, NodeId else_stmt, Span if_span);
+        NodeId add_else_statement(NodeId statement, Span else_span);
+        NodeId add_function(const Identifier& name, std::span<const NodeId> args, NodeId block, Type* return_type);
+        NodeId add_return_statement(NodeId value, Span ret_span);
+        NodeId add_struct_decl(const Identifier& name, std::span<const NodeId> fields, Type* type);
+        NodeId add_uniform_decl(NodeId var_decl, UpdateFrequency frequency, Span uniform_span);
+        void set_top_level(std::span<const NodeId> statements);
+
         void print(ASTPrinter& printer) const override;
+        void print_node(ASTPrinter& printer, NodeId node) const;
     private:
-        std::vector<std::unique_ptr<Statement>> statements;
+        struct NodeData {
+            uint32_t a;
+            uint32_t b;
+            uint32_t c;
+        };
+        struct NodeSpan {
+            uint32_t offset;
+            uint32_t length;
+        };
+        NodeId add(NodeKind kind, Span span, NodeData data);
+        uint32_t add_list(std::span<const NodeId> nodes);
+        std::span<const NodeId> list(uint32_t start, uint32_t count) const;
+        uint32_t add_type(Type* type);
+
+        uint32_t file;
+        std::vector<NodeKind> kinds;
+        std::vector<NodeSpan> spans;
+        std::vector<NodeData> data;
+        std::vector<uint32_t> extra;
+        // Declared types of variables and functions, referenced by slot
+        std::vector<Type*> types;
+        std::vector<NodeId> top_level_statements;
+};
+
+// A node of an AST as something NodePrinter can print
+struct NodeRef: public ASTPrint {
+    NodeRef(const AST& ast, NodeId node);
+    void print(ASTPrinter& printer) const override;
+
+    const AST& ast;
+    NodeId node;
 };
-}
\ No newline at end of file
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+namespace HKSL {
+// Index of a node in its AST. Ids are dense and handed out in parse order,
+// children before their parents, so per-node data can live in plain
+// vectors indexed by id.
+using NodeId = uint32_t;
+constexpr NodeId NO_NODE = UINT32_MAX;
+}
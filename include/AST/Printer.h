@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <Symbol.h>
 
 namespace HKSL {
 
@@ -12,7 +13,8 @@ struct ASTPrint {
 
 class ASTPrinter {
     public:
-        ASTPrinter();
+        ASTPrinter(const SymbolInterner& symbols);
+        std::string_view name_of(Symbol symbol) const;
         void print(const std::string& text);
         void println(const std::string& text);
         void println();
@@ -22,15 +24,16 @@ class ASTPrinter {
         void decrease_depth();
     private:
         uint32_t indent;
+        const SymbolInterner& symbols;
 };
 class NodePrinter {
     public:
         NodePrinter(const std::string& name, ASTPrinter& printer);
         ~NodePrinter();
         NodePrinter& field(const std::string& name, const std::string& value);
-        NodePrinter& field(const std::string& name, const ASTPrint* node);
+        NodePrinter& field(const std::string& name, const ASTPrint& node);
         NodePrinter& name(const std::string& name);
-        NodePrinter& value(const ASTPrint* node);
+        NodePrinter& value(const ASTPrint& node);
     private:
         ASTPrinter& printer;
 };
@@ -40,7 +43,7 @@ class ArrayPrinter {
     public:
         ArrayPrinter(size_t n, ASTPrinter& printer);
         ~ArrayPrinter();
-        void print_item(const ASTPrint* item);
+        void print_item(const ASTPrint& item);
     private:
         ASTPrinter& printer;
         size_t i;
@@ -3,9 +3,10 @@
 #include <AST.h>
 #include <Context.h>
 #include <Visitor.h>
+#include <ThreadPool.h>
+#include <Analysis/TypeCheck.h>
 #include <vector>
-#include <unordered_map>
-#include <functional>
+#include <span>
 
 namespace HKSL {
 
@@ -16,59 +17,141 @@ enum class ScopeKind {
 };
 
 struct VariableData {
-    const VarDecl* decl;
+    NodeId decl;
     Span span;
     bool initialized = false;
 };
 
-class Scope {
+// Bindings of all open scopes in one table. Every name has a chain of its
+// bindings, innermost first, and leaving a scope pops the bindings it added
+// off the end. Lookups cost the same at any nesting depth and opening a
+// scope allocates nothing.
+class SymbolTable {
     public:
-        Scope(ScopeKind kind);
-        bool is_block() const;
-        bool is_function() const;
-        bool is_global() const;
-        VariableData* push_var_decl(const VarDecl* var);
-        void push_function(const Function* func);
-        bool var_exists(const std::string& name);
-        bool func_exists(const std::string& name);
-        VariableData* find_var_decl(const std::string& name);
-        const Function* find_func_decl(const std::string& name);
-        void for_each_var(std::function<void (const std::string&, const VariableData&)> fn) const;
+        struct VariableBinding {
+            Symbol name;
+            // Index of the scope declaring it, the global scope is 0
+            uint32_t depth;
+            // Binding of the same name this one hides
+            uint32_t shadowed;
+            VariableData data;
+        };
+        // Chain heads are indexed by symbol id and grow to the highest id
+        // bound, not to every symbol interned
+        SymbolTable();
+        void push_scope(ScopeKind kind);
+        void pop_scope();
+        ScopeKind innermost_kind() const;
+        // Stays valid until the next variable is pushed
+        VariableData* push_variable(NodeId decl, const Identifier& name);
+        // nullptr if there's none, variables of enclosing functions and of
+        // the global scope are out of reach
+        VariableData* find_variable(Symbol name);
+        // Declaration order
+        std::span<const VariableBinding> innermost_variables() const;
+        void push_function(NodeId func, Symbol name);
+        // NO_NODE if there's none
+        NodeId find_function(Symbol name) const;
+        // Same, but only looking at the innermost scope
+        NodeId find_innermost_function(Symbol name) const;
+        // Uniforms are global and never go out of scope
+        void push_uniform(NodeId var_decl, Symbol name);
+        // The uniform's VarDecl, NO_NODE if there's none
+        NodeId find_uniform(Symbol name) const;
     private:
+        struct FunctionBinding {
+            Symbol name;
+            uint32_t depth;
+            uint32_t shadowed;
+            NodeId decl;
+        };
+        // Where a scope's bindings start, popping it truncates back to here
+        struct ScopeMark {
+            ScopeKind kind;
+            uint32_t first_variable;
+            uint32_t first_function;
+            uint32_t visible_from;
+        };
+        static constexpr uint32_t NO_BINDING = UINT32_MAX;
 
-    ScopeKind kind;
-    std::unordered_map<std::string, VariableData> variables;
-    std::unordered_map<std::string, const Function*> functions; 
+        uint32_t head(const std::vector<uint32_t>& heads, Symbol name) const;
+        uint32_t& head(std::vector<uint32_t>& heads, Symbol name);
+        uint32_t depth() const;
+
+        std::vector<uint32_t> variable_heads;
+        std::vector<uint32_t> function_heads;
+        std::vector<VariableBinding> variables;
+        std::vector<FunctionBinding> functions;
+        std::vector<ScopeMark> scopes;
+        // Indexed by symbol id, grown on demand
+        std::vector<NodeId> uniforms;
+        // Depth of the innermost function scope, variables of scopes below
+        // it can't be seen
+        uint32_t visible_from;
 };
 
-class SemanticsVisitor: private Visitor {
+class SemanticsVisitor: private Visitor<SemanticsVisitor> {
     public:
         SemanticsVisitor(CompilationContext& context);
-        bool run();
+        // Declares the top level functions first, then checks the other top
+        // level statements in order and the function bodies on `pool`
+        bool run(ThreadPool& pool);
+        // Same as run followed by TypeInferenceVisitor::run, but types every
+        // expression right after resolving its names, in the same traversal.
+        // Type errors are only reported if all names resolved.
+        bool run_fused(ThreadPool& pool);
     private:
-        void visit(AST& ast) override;
-        void visit_function(Function* func) override;
-        void visit_block_statement(BlockStatement* block) override;
-        void visit_var_decl(VarDecl* var_decl) override;
-        void visit_let_expr(LetExpr* let_expr) override;
-        void visit_call_expr(CallExpr* call_expr) override;
-        void visit_assignment_expr(AssignmentExpr* assignment_expr) override;
-        void visit_variable(Variable* variable) override;
+        friend class Visitor<SemanticsVisitor>;
+
+        bool check(ThreadPool& pool);
+
+        // Checks one function body, with `globals` as the read-only table
+        // of top level functions
+        SemanticsVisitor(CompilationContext& context, const SymbolTable& globals);
+
+        void visit_function(NodeId node, const Function& func);
+        void visit_expr_statement(NodeId node, const ExprStatement& expr);
+        void visit_if_statement(NodeId node, const IfStatement& if_statement);
+        void visit_return_statement(NodeId node, const ReturnStatement& ret);
+        void visit_struct_decl(NodeId node, const StructDecl& struct_decl);
+        void visit_block_statement(NodeId node, const BlockStatement& block);
+        void visit_var_decl(NodeId node, const VarDecl& var_decl);
+        void visit_let_expr(NodeId node, const LetExpr& let_expr);
+        void visit_call_expr(NodeId node, const CallExpr& call_expr);
+        void visit_assignment_expr(NodeId node, const AssignmentExpr& assignment_expr);
+        void visit_variable(NodeId node, const Variable& variable);
         
-        VariableData* check_variable(const Variable* variable);
+        VariableData* check_variable(NodeId node, const Variable& variable);
+        // False if a function of the same name is already in the current scope
+        bool declare_function(NodeId node, const Function& function);
+        void declare_uniform(NodeId node, const UniformDecl& uniform);
+        void check_function_body(NodeId node, const Function& function);
         
-        Scope& current_scope();
         void push_block();
         void pop_block();
-        void push_function(const Function* function);
+        void push_function();
         void pop_function();
-        bool var_exists(const std::string& name);
-        bool func_exists(const std::string& name);
-        VariableData* find_var_decl(const std::string& name);
-        const Function* find_func_decl(const std::string& name);
+        bool var_exists(Symbol name);
+        VariableData* find_var_decl(Symbol name);
+        NodeId find_func_decl(Symbol name);
+        NodeId find_uniform(Symbol name);
         void check_uninitialized();
+        // Fused mode only, skipped once the statement has name errors
+        void infer_types(NodeId expr);
+        void infer_return_type(const ReturnStatement& ret);
+        bool can_infer_types();
 
         CompilationContext& context;
-        std::vector<Scope> scope_stack;
+        SymbolTable table;
+        // Searched for functions and uniforms after `table`, if set
+        const SymbolTable* globals;
+
+        bool fused;
+        TypeInferenceVisitor types;
+        std::optional<Function> outer_fn;
+        // Errors of the statement being checked, and its type errors kept
+        // apart until the names of all statements are known to resolve
+        ErrorBuffer* statement_errors = nullptr;
+        std::vector<std::string>* statement_type_errors = nullptr;
 };
 }
\ No newline at end of file
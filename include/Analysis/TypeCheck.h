@@ -2,36 +2,59 @@
 #include <Visitor.h>
 #include <Context.h>
 #include <Typing.h>
+#include <ThreadPool.h>
 
 namespace HKSL {
-// class TypeExistsVisitor: public Visitor {
+// class TypeExistsVisitor: public Visitor<TypeExistsVisitor> {
 //     public:
 //         TypeExistsVisitor(CompilationContext& context);
 //         bool check_all_types_exists();
 //     private:
-//         void visit_type(Identifier&) override;
+//         void visit_type(Identifier&);
 //         CompilationContext& context;
 // };
-class TypeInferenceVisitor: public Visitor {
+class TypeInferenceVisitor: public Visitor<TypeInferenceVisitor> {
     public:
         TypeInferenceVisitor(CompilationContext& context);
-        bool run();
+        // Top level statements share no inferred types, each one is typed
+        // by its own task on `pool`
+        bool run(ThreadPool& pool);
+        // Types `expr` of `ast`, for SemanticsVisitor checking names and
+        // types in one traversal. Names in `expr` must be resolved.
+        Type* infer(AST& ast, NodeId expr);
+        // Types the value of `ret` and checks it against `function`
+        void infer_return(AST& ast, const Function& function, const ReturnStatement& ret);
+        // Nodes this visitor typed so far, a node typed twice counts twice
+        size_t typed_nodes() const;
     private:
-        void visit_let_expr(LetExpr* expr) override;
-        void visit_expr(Expr* expr) override;
-        void visit_function(Function* function) override;
-        void visit_return_statement(ReturnStatement* ret) override;
-        Type* type_of(const Expr* expr);
-        Type* type_of_expr(const Expr* expr);
-        Type* type_of_variable(const Variable* var);
-        Type* type_of_let_expr(const LetExpr* expr);
-        Type* type_of_assignment_expr(const AssignmentExpr* expr);
-        Type* type_of_call_expr(const CallExpr* expr);
-        Type* type_of_var_decl(const VarDecl* decl);
-        Type* type_of_unary_expr(const UnaryExpr* expr);
-        Type* type_of_binary_expr(const BinExpr* expr);
-        Type* type_of_number_constant(const NumberConstant* expr);
+        friend class Visitor<TypeInferenceVisitor>;
+
+        void visit_expr(NodeId expr);
+        void visit_function(NodeId node, const Function& function);
+        void visit_return_statement(NodeId node, const ReturnStatement& ret);
+        void check_return(const Function& function, const ReturnStatement& ret);
+        // Infers and registers the types of `expr` and all its subexpressions
+        Type* type_of(NodeId expr);
+        // Earliest parsed child, NO_NODE for leaves
+        NodeId first_child(NodeId expr);
+        // Type of an already typed expression, nullptr if inference failed
+        Type* inferred(NodeId expr);
+        // Types a single node from the types of its children
+        Type* type_of_expr(NodeId expr);
+        void infer_let(const LetExpr& expr);
+        Type* type_of_variable(NodeId node, const Variable& var);
+        Type* type_of_let_expr(NodeId node, const LetExpr& expr);
+        Type* type_of_assignment_expr(NodeId node, const AssignmentExpr& expr);
+        Type* type_of_call_expr(NodeId node, const CallExpr& expr);
+        // Calls of vector types, which take scalars and vectors adding up
+        // to the vector's width
+        Type* type_of_constructor(NodeId node, const CallExpr& expr);
+        Type* type_of_var_decl(NodeId node, const VarDecl& decl);
+        Type* type_of_unary_expr(NodeId node, const UnaryExpr& expr);
+        Type* type_of_binary_expr(NodeId node, const BinExpr& expr);
+        Type* type_of_number_constant(NodeId node, const NumberConstant& expr);
         CompilationContext& context;
-        std::optional<Function*> outer_fn;
+        std::optional<Function> outer_fn;
+        size_t typed = 0;
 };
 }
\ No newline at end of file
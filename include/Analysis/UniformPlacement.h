@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Context.h>
+#include <Layout.h>
+
+namespace HKSL {
+// Vulkan guarantees at least 128 bytes of push constants
+constexpr uint32_t DEFAULT_PUSH_CONSTANT_BUDGET = 128;
+
+enum class BlockKind: uint8_t {
+    PushConstant,
+    UniformBuffer,
+};
+const char* block_kind_to_string(BlockKind kind);
+
+struct PlacedUniform {
+    // Uniform node of the compiled AST
+    NodeId decl;
+    std::string name;
+    UpdateFrequency frequency;
+    // Reads of the uniform in the source
+    uint32_t accesses;
+    uint32_t offset;
+    uint32_t size;
+};
+struct UniformBlock {
+    BlockKind kind;
+    // Shared by all members of a uniform buffer, Draw for push constants
+    UpdateFrequency frequency;
+    // Descriptor binding of a uniform buffer, 0 for push constants
+    uint32_t binding;
+    uint32_t size;
+    // By offset
+    std::vector<PlacedUniform> members;
+};
+
+// Places the uniforms of the checked AST of `context`. The most read
+// uniforms per byte go into a std430 push constant block of at most
+// `push_constant_budget` bytes, the rest into one std140 uniform buffer per
+// update frequency. Buffers are bound from the least to the most often
+// updated, and members are reordered to save padding. Struct uniforms keep
+// the layout their reflection reports, reordered only with
+// `reorder_struct_fields`.
+//
+// The push constant block comes first if there is one, frequencies without
+// uniforms get no buffer.
+std::vector<UniformBlock> place_uniforms(CompilationContext& context, uint32_t push_constant_budget = DEFAULT_PUSH_CONSTANT_BUDGET, bool reorder_struct_fields = false);
+}
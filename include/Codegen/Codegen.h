@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <Context.h>
+#include <UniformPlacement.h>
+
+namespace HKSL {
+// SPIR-V binary of the checked AST of `context`, see MLIRGen.h and
+// LowerToSPIRV.h. Errors go to `context`, the binary is empty then.
+// `reorder_struct_fields` as passed to place_uniforms.
+std::vector<uint32_t> generate_spirv(CompilationContext& context, std::span<const UniformBlock> uniform_blocks, bool reorder_struct_fields);
+}
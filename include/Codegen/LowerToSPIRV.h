@@ -0,0 +1,15 @@
+#pragma once
+#include <memory>
+#include "mlir/Pass/Pass.h"
+
+namespace HKSL {
+// Lowers a module in the HKSL dialect to a spirv.module for Vulkan, which
+// spirv::serialize turns into a binary. Runs in two steps, first to arith,
+// func and scf, then to SPIR-V with the upstream conversions.
+//
+// Entry points get a wrapper loading their parameters from Input variables
+// and storing their result to an Output variable, both at the locations
+// the reflection reports. Uniform blocks become push constant and uniform
+// buffer variables.
+std::unique_ptr<mlir::Pass> create_lower_to_spirv_pass();
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "mlir/Bytecode/BytecodeOpInterface.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Dialect.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Interfaces/FunctionInterfaces.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+
+// Generated from Ops.td, see there for the ops
+#include "Dialect.h.inc"
+
+#define GET_OP_CLASSES
+#include "Ops.h.inc"
@@ -0,0 +1,21 @@
+#pragma once
+#include <span>
+#include <Context.h>
+#include <UniformPlacement.h>
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OwningOpRef.h"
+
+namespace HKSL {
+// Emits the checked AST of `context` in the HKSL dialect, a hksl.func per
+// function and a hksl.uniform_block per block of `uniform_blocks`. Top
+// level statements outside functions never run in a shader and are left
+// out. Variables become SSA values, types come from the TypeResolver.
+//
+// Struct uniforms are laid out as place_uniforms placed them, with
+// `reorder_struct_fields` as passed to it.
+//
+// Constructs codegen can't handle yet, like struct values, are reported
+// to `context` and give a null module.
+mlir::OwningOpRef<mlir::ModuleOp> generate_mlir(CompilationContext& context, mlir::MLIRContext& mlir_context, std::span<const UniformBlock> uniform_blocks, bool reorder_struct_fields);
+}
@@ -1,17 +1,60 @@
 
 #pragma once
 #include <Context.h>
+#include <ThreadPool.h>
+#include <Layout.h>
+#include <UniformPlacement.h>
 
 namespace HKSL {
 using Errors = std::vector<std::string>;
+// Buffer layouts of a declared struct, with the padding each rule wastes
+struct StructReport {
+    std::string name;
+    // Declaration order, FieldLayout::field indexes into it
+    std::vector<std::string> fields;
+    // Indexed by LayoutRule
+    StructLayout layouts[LAYOUT_RULE_COUNT];
+};
 struct CompilationResult {
     bool is_success();
     Errors errors;
+    std::vector<StructReport> structs;
+    // See place_uniforms
+    std::vector<UniformBlock> uniform_blocks;
+    // See Reflection.h
+    std::vector<uint8_t> reflection;
+    // SPIR-V words, if enabled with set_emit_spirv
+    std::vector<uint32_t> spirv;
 };
 class Compiler {
     public:
         Compiler();
-        CompilationResult compile(const std::string& filename, const std::string& source);
+        // Compilers sharing an interner can run on different threads
+        Compiler(SymbolInterner& symbols);
+        // n_threads as for ThreadPool, 1 compiles on the calling thread only
+        Compiler(SymbolInterner& symbols, size_t n_threads);
+        SourceManager& sources();
+        // Resolve names and infer types in one traversal instead of two
+        // passes, with the same errors
+        void set_fused_frontend(bool fused);
+        // Lay out struct fields to minimize padding instead of in declaration order
+        void set_reorder_struct_fields(bool reorder);
+        // Bytes of uniforms that may go into push constants instead of
+        // uniform buffers, 0 to use uniform buffers only
+        void set_push_constant_budget(uint32_t bytes);
+        // Generate a SPIR-V binary for Vulkan, see Codegen.h. Fails to
+        // compile unless built with HKSL_SPIRV, the backend is experimental
+        // and its output not yet validated.
+        void set_emit_spirv(bool emit);
+        CompilationResult compile(uint32_t file);
+        CompilationResult compile(const std::string& filename, std::string source);
     private:
+        SymbolInterner& symbols;
+        SourceManager source_manager;
+        ThreadPool thread_pool;
+        bool fused_frontend = false;
+        bool reorder_struct_fields = false;
+        uint32_t push_constant_budget = DEFAULT_PUSH_CONSTANT_BUDGET;
+        bool emit_spirv = false;
 };
 }
\ No newline at end of file
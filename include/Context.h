@@ -1,43 +1,77 @@
 #pragma once
 #include <AST.h>
-#include <unordered_map>
 #include <Typing.h>
+#include <Source.h>
 
 namespace HKSL {
 
+// Resolved declarations and types live in tables presized to the AST, so
+// tasks working on different nodes can register them concurrently.
 class SymbolResolver {
     public: 
         SymbolResolver() = default;
+        // Makes room for every node of an AST with `node_count` nodes
+        void resize(size_t node_count);
         // void register_function(const FunctionDef* function);
-        void register_variable_ref(const Variable* variable, const VarDecl* decl);
-        void register_function_ref(const CallExpr* call_expr, const Function* decl);
+        void register_variable_ref(NodeId variable, NodeId decl);
+        void register_function_ref(NodeId call_expr, NodeId decl);
 
-        const Function* get_function(const CallExpr* expr);
-        const VarDecl* get_var_decl(const Variable* var);
+        // NO_NODE if unresolved
+        NodeId get_function(NodeId call_expr);
+        NodeId get_var_decl(NodeId variable);
     private:
-        std::unordered_map<const Variable*, const VarDecl*> ref_to_decl;
-        std::unordered_map<const CallExpr*, const Function*> call_to_func_decl;
+        // Declaration of each Variable and CallExpr node, NO_NODE elsewhere
+        std::vector<NodeId> decls;
 };
 
 class CompilationContext {
     public:
-        CompilationContext();
-        void set_ast(std::unique_ptr<AST> ast);
+        CompilationContext(SymbolInterner& symbols, SourceManager& sources);
+        void set_ast(AST ast);
         AST& get_ast();
+        SymbolInterner& symbols();
         SymbolResolver& symbol_resolver();
         TypeRegistry& type_registry();
         TypeResolver& type_resolver();
+        SourceManager& sources();
+        SourceLocation locate(Span span);
+        // Goes to this thread's ErrorBuffer for the context if there's one
         void error(Span location, const std::string& message);
+        // Appends errors collected by an ErrorBuffer
+        void append_errors(std::vector<std::string>&& errors);
         const std::vector<std::string>& errors();
+        // Moves the errors out, is_success() still counts them
+        std::vector<std::string> take_errors();
         void print_errors();
         bool is_success();
         void abort_if_failure();
     private:
         bool is_failing;
+        SymbolInterner& interner;
+        SourceManager& source_manager;
         SymbolResolver sym_resolver;
         TypeRegistry ty_registry;
         TypeResolver ty_resolver;
         std::vector<std::string> m_errors;
-        std::unique_ptr<AST> ast;
+        bool has_ast;
+        AST ast;
+};
+
+// Collects the errors a task reports for a context on the current thread,
+// so tasks running in parallel can have their errors merged in a
+// deterministic order afterwards. Buffers nest, the innermost one wins.
+class ErrorBuffer {
+    public:
+        ErrorBuffer(CompilationContext& context);
+        ErrorBuffer(const ErrorBuffer& other) = delete;
+        ErrorBuffer& operator=(const ErrorBuffer& other) = delete;
+        ~ErrorBuffer();
+
+        std::vector<std::string> errors;
+    private:
+        friend class CompilationContext;
+
+        CompilationContext& context;
+        ErrorBuffer* previous;
 };
 }
\ No newline at end of file
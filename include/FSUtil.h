@@ -1,6 +1,24 @@
 #pragma once
 #include <string>
+#include <cstddef>
 
 namespace HKSL {
 std::string read_to_string(const char* path);
-}
\ No newline at end of file
+
+// Read-only memory mapping of a whole file, followed by at least `padding`
+// zero bytes that can be read like the rest of the file.
+class MappedFile {
+    public:
+        MappedFile(const char* path, size_t padding);
+        MappedFile(MappedFile&& other);
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+        ~MappedFile();
+        const char* data() const;
+        size_t size() const;
+    private:
+        void* base;
+        size_t mapped_size;
+        size_t file_size;
+};
+}
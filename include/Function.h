@@ -1,13 +1,13 @@
 #pragma once
 #include <vector>
 #include <Typing.h>
-#include <string>
+#include <Symbol.h>
 
 namespace HKSL {
 class FunctionDef {
     public:
         virtual ~FunctionDef() = default;
-        virtual const char* name() const = 0;
+        virtual Symbol name() const = 0;
         virtual Type* arg_at(size_t i) const = 0;
         virtual size_t n_args() const = 0;
         virtual Type* return_type() const = 0;
@@ -15,14 +15,14 @@ class FunctionDef {
 
 class LibraryFunction: public FunctionDef {
     public:
-        LibraryFunction(const std::string& name, std::initializer_list<Type*> args, Type* return_type);
+        LibraryFunction(Symbol name, std::initializer_list<Type*> args, Type* return_type);
         virtual ~LibraryFunction() = default;
-        const char* name() const override;
+        Symbol name() const override;
         Type* arg_at(size_t i) const override;
         size_t n_args() const override;
         Type* return_type() const override;
     private:
-        std::string m_name;
+        Symbol m_name;
         std::vector<Type*> m_args;
         Type* m_return_type;
 };
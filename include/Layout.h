@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <Typing.h>
+
+namespace HKSL {
+// Rules for placing values in uniform and storage buffers
+enum class LayoutRule: uint8_t {
+    // Uniform buffers, struct and matrix column alignment rounded up to 16
+    Std140,
+    // Storage buffers and push constants
+    Std430,
+    // VK_EXT_scalar_block_layout, everything aligned to its component size
+    Scalar,
+};
+constexpr size_t LAYOUT_RULE_COUNT = 3;
+const char* layout_rule_to_string(LayoutRule rule);
+
+struct FieldLayout {
+    // Position of the field in its struct's declaration
+    uint32_t field;
+    uint32_t offset;
+    uint32_t size;
+};
+struct StructLayout {
+    // By offset, the same as declaration order unless fields were reordered
+    std::vector<FieldLayout> fields;
+    uint32_t size;
+    uint32_t alignment;
+    // Bytes of `size` not covered by any field
+    uint32_t padding;
+};
+
+uint32_t layout_align_of(const TypeRegistry& registry, const Type* type, LayoutRule rule);
+// Bytes a value of `type` occupies in a buffer, matrices include their
+// column padding and structs their tail padding
+uint32_t layout_size_of(const TypeRegistry& registry, const Type* type, LayoutRule rule, bool reorder_fields = false);
+// With `reorder_fields` the fields are placed greedily, each time picking
+// the one needing the least padding at the current offset, so small fields
+// fill the holes after float3s. Nested structs are reordered as well.
+StructLayout layout_struct(const TypeRegistry& registry, const Type* type, LayoutRule rule, bool reorder_fields = false);
+// Same for a block whose members have the types `fields`
+StructLayout layout_members(const TypeRegistry& registry, std::span<const Type* const> fields, LayoutRule rule, bool reorder_fields = false);
+// A uniform block, whose own members are always reordered. Struct members
+// are laid out as layout_struct does with `reorder_struct_fields`, so they
+// match the struct's reflection.
+StructLayout layout_block(const TypeRegistry& registry, std::span<const Type* const> members, LayoutRule rule, bool reorder_struct_fields);
+}
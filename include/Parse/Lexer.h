@@ -3,17 +3,24 @@
 #include <vector>
 #include <variant>
 #include <optional>
+#include <span>
 
 #include <Util.h>
+#include <Symbol.h>
+#include <Parse/Scan.h>
+#include <Source.h>
+#include <ThreadPool.h>
 
 namespace HKSL {
 
+// Byte range in a source file, turned into line:col only when rendered
+// through CompilationContext::locate
 struct Span {
-    uint32_t line;
-    uint32_t col;
-    std::string to_string() const;
+    uint32_t file;
+    uint32_t offset;
+    uint32_t length;
 };
-enum class TokenKind {
+enum class TokenKind: uint8_t {
     Plus, 
     Minus,
     Slash,
@@ -44,6 +51,8 @@ enum class TokenKind {
     KeywordFn,
     KeywordLet,
     KeywordReturn,
+    KeywordStruct,
+    KeywordUniform,
     Eof,
 };
 
@@ -51,11 +60,23 @@ std::string token_kind_to_debug_string(TokenKind token);
 std::string token_kind_to_string(TokenKind token);
 
 struct Identifier {
-    std::string name;
+    Symbol symbol;
     Span span;
 };
+enum class NumberKind: uint8_t {
+    // No suffix or `f`
+    Float,
+    // `h` suffix
+    Half,
+};
 struct NumberLiteral {
-    double value;
+    NumberKind kind;
+    // Exact bit pattern at the literal's precision: binary32 for Float,
+    // binary16 in the low bits for Half. Already correctly rounded, so
+    // later stages never round again.
+    uint32_t bits;
+    // Exact in both cases, every binary16 value is representable as a float
+    float value() const;
 };
 struct NoTokenData {};
 using TokenData = std::variant<Identifier, NumberLiteral, NoTokenData>;
@@ -66,37 +87,117 @@ struct Token {
     Span span;
     const Identifier& unwrap_identifier() const;
     const NumberLiteral& unwrap_number_literal() const;
-    std::string to_string() const;
+    std::string to_string(const SymbolInterner& symbols) const;
+};
+
+// Packed token stream, stored as parallel arrays so the parser's linear
+// scan only touches a byte of kind and a few bytes of payload per token.
+// Lengths of identifiers and numbers live in their side tables, every other
+// kind has a fixed length.
+class TokenBuffer {
+    public:
+        TokenBuffer(uint32_t file);
+        void push(const Token& token);
+        // Joins buffers lexed from consecutive ranges of one file, each part
+        // is copied into place by its own task
+        static TokenBuffer concatenate(uint32_t file, std::span<const TokenBuffer> parts, ThreadPool& pool);
+        size_t size() const;
+        TokenKind kind(size_t i) const;
+        uint32_t offset(size_t i) const;
+        Span span(size_t i) const;
+        Identifier identifier(size_t i) const;
+        const NumberLiteral& number_literal(size_t i) const;
+        Token token(size_t i) const;
+    private:
+        struct IdentifierEntry {
+            Symbol symbol;
+            uint32_t length;
+        };
+        struct LiteralEntry {
+            NumberLiteral value;
+            uint32_t length;
+        };
+        uint32_t file;
+        std::vector<TokenKind> kinds;
+        std::vector<uint32_t> offsets;
+        // Index into `identifiers` or `literals`, unused for other kinds
+        std::vector<uint32_t> payloads;
+        std::vector<IdentifierEntry> identifiers;
+        std::vector<LiteralEntry> literals;
+};
+
+struct LexError {
+    // Byte offset into the file
+    uint32_t offset;
+    std::string message;
 };
 
 class Lexer {
     public:
-        Lexer(const char* code);
+        // The source must come from a SourceManager, the lexer relies on its zero padding
+        Lexer(const SourceFile& source, SymbolInterner& symbols);
+        // Lexes only the bytes in [begin, end), then returns Eof. Both bounds
+        // must be at the start of a line or at the end of the source, no
+        // token or comment crosses a line break.
+        Lexer(const SourceFile& source, SymbolInterner& symbols, uint32_t begin, uint32_t end);
         Lexer(const Lexer& other) = default;
         Lexer& operator=(Lexer& other) = default;
         bool is_eof();
+        // Exits on a malformed token
         Token token();
-        std::vector<Token> collect_tokens();
+        // Returns the error instead of exiting, `token` is only set on success
+        std::optional<LexError> try_token(Token& token);
+        TokenBuffer collect_tokens();
+        // The keyword spelled `identifier`, nullopt for any other name
+        static std::optional<TokenKind> is_keyword(std::string_view identifier);
     private:
         char current();
         char next();
         void advance();
+        void advance_to(const char* target);
         bool matches(char ch);
         bool consume(char ch);
         bool consume_two(char first, char second);
         void white_space();
         void skip_to_next_line();
         bool is_digit(char ch);
-        bool is_identifier_start(char ch);
-        bool is_identifier(char ch);
-        std::optional<TokenKind> is_keyword(const std::string& identifier);
+        TokenKind operator_token();
         std::pair<TokenKind, TokenData> identifier();
-        double to_digit(char ch);
-        double number_literal();
-        Span current_span();
+        NumberLiteral number_literal();
+        Span span_from(const char* token_start);
+        // Throws LexError for try_token to catch
+        Token next_token();
+        [[noreturn]] void lex_error(const char* at, std::string message);
     private:
+        const char* start;
         const char* remaining;
-        uint32_t line;
-        uint32_t col;
+        const char* end;
+        uint32_t file;
+        SymbolInterner& symbols;
+        const Scanner& scanner;
+};
+
+// Window over the tokens the parser is looking at: the current one and the
+// one after it. Pulling from a Lexer lexes on demand, so parsing holds a
+// constant number of tokens however long the source is. Past the end the
+// stream keeps returning Eof.
+class TokenStream {
+    public:
+        TokenStream(Lexer& lexer);
+        TokenStream(const TokenBuffer& tokens);
+        // Starts at token `begin` of the buffer
+        TokenStream(const TokenBuffer& tokens, size_t begin);
+        const Token& current() const;
+        const Token& next() const;
+        void advance();
+    private:
+        Token pull();
+        static constexpr size_t WINDOW_SIZE = 2;
+        Token window[WINDOW_SIZE];
+        size_t head;
+        // Exactly one of the two sources is set
+        Lexer* lexer;
+        const TokenBuffer* tokens;
+        size_t position;
 };
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#include <Parse/Lexer.h>
+
+// Lookup tables driving Lexer::token(), all generated at compile time from
+// the spelling lists below. Adding an operator or keyword only means adding
+// it to a list, the per-token cost stays one class lookup plus a short DFA
+// walk or a single hashed compare.
+namespace HKSL::LexerTables {
+
+struct Spelling {
+    std::string_view text;
+    TokenKind kind;
+};
+
+constexpr Spelling OPERATORS[] = {
+    {"+", TokenKind::Plus},
+    {"-", TokenKind::Minus},
+    {"/", TokenKind::Slash},
+    {"*", TokenKind::Star},
+    {",", TokenKind::Comma},
+    {".", TokenKind::Dot},
+    {":", TokenKind::Colon},
+    {";", TokenKind::Semicolon},
+    {"=", TokenKind::Equals},
+    {"[", TokenKind::LeftSquare},
+    {"]", TokenKind::RightSquare},
+    {"{", TokenKind::LeftCurly},
+    {"}", TokenKind::RightCurly},
+    {"(", TokenKind::LeftRound},
+    {")", TokenKind::RightRound},
+    {"==", TokenKind::DoubleEquals},
+    {"+=", TokenKind::PlusEqual},
+    {"-=", TokenKind::MinusEqual},
+    {"*=", TokenKind::StarEqual},
+    {"/=", TokenKind::SlashEqual},
+    {"->", TokenKind::RightArrow},
+};
+
+constexpr Spelling KEYWORDS[] = {
+    {"fn", TokenKind::KeywordFn},
+    {"if", TokenKind::KeywordIf},
+    {"else", TokenKind::KeywordElse},
+    {"let", TokenKind::KeywordLet},
+    {"return", TokenKind::KeywordReturn},
+    {"struct", TokenKind::KeywordStruct},
+    {"uniform", TokenKind::KeywordUniform},
+};
+
+enum class CharClass: uint8_t {
+    Invalid,
+    // The zero byte terminating every source
+    End,
+    Digit,
+    IdentifierStart,
+    Operator,
+};
+
+constexpr std::array<CharClass, 256> make_char_classes() {
+    std::array<CharClass, 256> classes {};
+    classes['\0'] = CharClass::End;
+    for(int ch = '0'; ch <= '9'; ch++) {
+        classes[ch] = CharClass::Digit;
+    }
+    for(int ch = 'a'; ch <= 'z'; ch++) {
+        classes[ch] = CharClass::IdentifierStart;
+        classes[ch - 'a' + 'A'] = CharClass::IdentifierStart;
+    }
+    classes['_'] = CharClass::IdentifierStart;
+    for(const auto& op: OPERATORS) {
+        classes[(uint8_t) op.text[0]] = CharClass::Operator;
+    }
+    return classes;
+}
+constexpr std::array<CharClass, 256> CHAR_CLASSES = make_char_classes();
+
+// Trie over the operator spellings, walked with maximal munch. State 0 is
+// the start state, a transition to 0 means there's no longer operator.
+constexpr size_t count_operator_states() {
+    // Upper bound: one state per operator character plus the start state
+    size_t n = 1;
+    for(const auto& op: OPERATORS) {
+        n += op.text.size();
+    }
+    return n;
+}
+struct OperatorDFA {
+    static constexpr size_t MAX_STATES = count_operator_states();
+    uint8_t next[MAX_STATES][256];
+    TokenKind accept[MAX_STATES];
+    bool accepting[MAX_STATES];
+};
+constexpr OperatorDFA make_operator_dfa() {
+    static_assert(OperatorDFA::MAX_STATES < 256, "Operator states must fit in a byte");
+
+    OperatorDFA dfa {};
+    size_t n_states = 1;
+    for(const auto& op: OPERATORS) {
+        size_t state = 0;
+        for(char ch: op.text) {
+            uint8_t& next = dfa.next[state][(uint8_t) ch];
+            if(next == 0) {
+                next = n_states++;
+            }
+            state = next;
+        }
+        dfa.accept[state] = op.kind;
+        dfa.accepting[state] = true;
+    }
+    return dfa;
+}
+constexpr OperatorDFA OPERATOR_DFA = make_operator_dfa();
+
+// Perfect hash over (first char, last char, length). The seed is searched at
+// compile time, so a new keyword that collides just picks another seed.
+constexpr size_t KEYWORD_TABLE_SIZE = std::bit_ceil(std::size(KEYWORDS)) * 2;
+
+constexpr size_t keyword_hash(uint32_t seed, std::string_view text) {
+    return ((uint8_t) text.front() * seed + (uint8_t) text.back() + text.size()) & (KEYWORD_TABLE_SIZE - 1);
+}
+constexpr uint32_t find_keyword_seed() {
+    for(uint32_t seed = 1; seed < 256; seed++) {
+        bool used[KEYWORD_TABLE_SIZE] {};
+        bool collides = false;
+        for(const auto& keyword: KEYWORDS) {
+            size_t slot = keyword_hash(seed, keyword.text);
+            collides |= used[slot];
+            used[slot] = true;
+        }
+        if(!collides) {
+            return seed;
+        }
+    }
+    return 0;
+}
+constexpr uint32_t KEYWORD_SEED = find_keyword_seed();
+static_assert(KEYWORD_SEED != 0, "No perfect hash seed found for the keywords");
+
+constexpr std::array<Spelling, KEYWORD_TABLE_SIZE> make_keyword_table() {
+    // Empty slots hold an empty spelling, which never matches an identifier
+    std::array<Spelling, KEYWORD_TABLE_SIZE> table {};
+    for(const auto& keyword: KEYWORDS) {
+        table[keyword_hash(KEYWORD_SEED, keyword.text)] = keyword;
+    }
+    return table;
+}
+constexpr std::array<Spelling, KEYWORD_TABLE_SIZE> KEYWORD_TABLE = make_keyword_table();
+}
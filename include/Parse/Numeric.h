@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <Parse/Lexer.h>
+
+namespace HKSL {
+// Correctly rounded (round to nearest, ties to even) conversion of a literal
+// to the precision of `kind`. `digits` has no 0x prefix and no suffix.
+// Returns nullopt if the value overflows the target precision, literals too
+// small for it round to zero.
+std::optional<NumberLiteral> parse_number(std::string_view digits, bool hex, NumberKind kind);
+
+uint16_t double_to_half_bits(double value);
+float half_bits_to_float(uint16_t bits);
+}
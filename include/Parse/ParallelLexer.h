@@ -0,0 +1,20 @@
+#pragma once
+#include <Parse/Lexer.h>
+#include <ThreadPool.h>
+
+namespace HKSL {
+
+// Sources below this size are lexed on the calling thread, splitting them
+// costs more than it saves
+constexpr size_t PARALLEL_LEX_MIN_CHUNK = 256 * 1024;
+
+// Lexes `source` in chunks on `pool` and stitches them into one buffer, the
+// same tokens with the same spans Lexer::collect_tokens() produces. Chunks
+// are split right after a newline: tokens never span lines and the only
+// comments are line comments, so every chunk starts outside any token or
+// comment. Symbols are interned in whatever order the chunks get to them,
+// so their ids (but not their names) can differ between runs. Each chunk
+// stops at its first malformed token, and once all are done the one
+// earliest in the file is reported.
+TokenBuffer lex_parallel(const SourceFile& source, SymbolInterner& symbols, ThreadPool& pool);
+}
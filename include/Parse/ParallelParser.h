@@ -0,0 +1,17 @@
+#pragma once
+#include <Parse/Parser.h>
+#include <ThreadPool.h>
+
+namespace HKSL {
+
+// Token counts below this are parsed on the calling thread
+constexpr size_t PARALLEL_PARSE_MIN_CHUNK = 16 * 1024;
+
+// Parses `tokens` in chunks on `pool` and joins them into one AST in source
+// order, the same tree Parser::program() builds. Chunks are split before
+// `fn` keywords outside of any braces or parentheses, which can only start a
+// top level statement, and each chunk is parsed into its own AST. Each chunk
+// stops at its first syntax error, and once all are done the one earliest in
+// the file is reported.
+AST parse_parallel(CompilationContext& context, const TokenBuffer& tokens, ThreadPool& pool);
+}
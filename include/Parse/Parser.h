@@ -6,44 +6,91 @@
 
 namespace HKSL {
 
+struct SyntaxError {
+    // Byte offset into the file
+    uint32_t offset;
+    std::string message;
+};
+
 class Parser {
     public:
-        Parser(CompilationContext&, const Token* tokens);
-        std::unique_ptr<AST> program();
-        std::unique_ptr<Statement> statement();
-        std::unique_ptr<Statement> expr_statement();
-        std::unique_ptr<BlockStatement> block();
-        std::unique_ptr<Statement> function();
-        FunctionArgs function_args();
-        std::unique_ptr<Statement> return_statement();
-        std::unique_ptr<Statement> if_statement();
-        std::unique_ptr<ElseStatement> else_statement();
+        // Lexes while parsing
+        Parser(CompilationContext&, Lexer& lexer);
+        Parser(CompilationContext&, const TokenBuffer& tokens);
+        // Parses the top level statements starting at token `begin`, up to the
+        // first one that starts at or after token `end`
+        Parser(CompilationContext&, const TokenBuffer& tokens, size_t begin, size_t end);
+        // Exits on the first syntax error
+        AST program();
+        // Returns the first syntax error instead of exiting, `program` is only
+        // set on success
+        std::optional<SyntaxError> try_program(AST& program);
+        NodeId statement();
+        NodeId expr_statement();
+        NodeId block();
+        NodeId function();
+        // Pushes the argument declarations onto `scratch`, returns where they start
+        size_t function_args();
+        // Declares the struct's type, so it can be used by everything after it
+        NodeId struct_decl();
+        // `uniform name: type;`, or `uniform(frequency) name: type;` with
+        // frequency one of frame, material or draw, the default
+        NodeId uniform_decl();
+        NodeId return_statement();
+        NodeId if_statement();
+        NodeId else_statement();
         
-        std::unique_ptr<Expr> let();
-        std::unique_ptr<Expr> assignment();
-        std::unique_ptr<Expr> expr();
-        std::unique_ptr<Expr> equality();
-        std::unique_ptr<Expr> term();
-        std::unique_ptr<Expr> factor();
-        std::unique_ptr<Expr> unary();
-        std::unique_ptr<Expr> primary();
-        std::unique_ptr<Expr> place();
-        std::unique_ptr<Expr> call_expr();
-        std::unique_ptr<Variable> variable();
-        std::unique_ptr<VarDecl> var_decl();
+        NodeId expr();
+        // Operators, parentheses and operands, parsed iteratively against the
+        // operator tables, so long or deeply nested expressions don't recurse
+        NodeId operator_expr();
+        NodeId operand();
+        NodeId place();
+        NodeId call_expr();
+        NodeId variable();
+        NodeId var_decl();
         Identifier identifier();
         Type* type();
     private:
-        const Token& current() const;
-        const Token& next() const;
+        // Top level statements, throws SyntaxError for try_program to catch
+        AST statements();
+        [[noreturn]] void syntax_error(Span span, std::string message);
+        TokenKind current() const;
+        TokenKind next() const;
+        Span current_span() const;
         void advance();
         bool is_eof();
         bool matches(TokenKind kind) const;
-        bool consume(std::initializer_list<TokenKind> kinds, Token* out_consumed = nullptr);
-        bool consume(TokenKind kind, Token* out_consumed = nullptr);  
+        bool consume(TokenKind kind, Span* out_span = nullptr);
         void unexpected_token();
-        void expect(TokenKind kind, Token* out_consumed = nullptr, const char* error = nullptr);
-        const Token* remaining;
+        void expect(TokenKind kind, Span* out_span = nullptr, const char* error = nullptr);
+        // Like expect() but leaves the token current, so its payload can be read in place
+        void require(TokenKind kind, const char* error = nullptr);
+        // Pushes comma separated `name: type` declarations between `open`
+        // and `close` onto `scratch`, returns where they start
+        size_t typed_names(TokenKind open, TokenKind close);
+
+        // An operator or '(' waiting for its operands in operator_expr()
+        struct PendingOperator {
+            enum class Kind: uint8_t {
+                Infix,
+                Prefix,
+                Group,
+            };
+            Kind kind;
+            TokenKind token;
+            Span span;
+        };
+        // Pops the top pending operator and its operands, pushes the new node
+        void reduce();
+        TokenStream tokens;
+        // Byte offset program() stops at
+        uint32_t stop_offset;
+        AST ast;
+        // Child lists under construction, each production pops what it pushed
+        std::vector<NodeId> scratch;
+        std::vector<PendingOperator> operators;
+        std::vector<NodeId> operands;
         CompilationContext& context;
 };
 
@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include <Parse/Lexer.h>
+#include <AST/AST.h>
+
+// Operator tables driving the expression parser, generated at compile time
+// from the lists below. A new operator is one more line here, it doesn't
+// add a level to the parser's call chain.
+namespace HKSL::ParserTables {
+
+// Higher binds tighter
+enum class Precedence: uint8_t {
+    None,
+    Assignment,
+    Equality,
+    Term,
+    Factor,
+    Prefix,
+};
+
+enum class Associativity: uint8_t {
+    Left,
+    Right,
+    // Can't be chained, `a == b == c` ends the expression after `a == b`
+    None,
+};
+
+enum class InfixKind: uint8_t {
+    // Not an infix operator
+    None,
+    Binary,
+    // Right hand side is stored into the left, which must be a place
+    Assignment,
+};
+
+struct InfixOperator {
+    TokenKind token;
+    InfixKind kind;
+    // Only for InfixKind::Binary
+    BinOp op;
+    Precedence precedence;
+    Associativity associativity;
+};
+
+struct PrefixOperator {
+    TokenKind token;
+    UnaryOp op;
+};
+
+constexpr InfixOperator INFIX_OPERATORS[] = {
+    {TokenKind::Equals, InfixKind::Assignment, BinOp::Equals, Precedence::Assignment, Associativity::Right},
+    {TokenKind::DoubleEquals, InfixKind::Binary, BinOp::Equals, Precedence::Equality, Associativity::None},
+    {TokenKind::Plus, InfixKind::Binary, BinOp::Add, Precedence::Term, Associativity::Left},
+    {TokenKind::Minus, InfixKind::Binary, BinOp::Subtract, Precedence::Term, Associativity::Left},
+    {TokenKind::Star, InfixKind::Binary, BinOp::Multiply, Precedence::Factor, Associativity::Left},
+    {TokenKind::Slash, InfixKind::Binary, BinOp::Divide, Precedence::Factor, Associativity::Left},
+};
+
+constexpr PrefixOperator PREFIX_OPERATORS[] = {
+    {TokenKind::Minus, UnaryOp::Negate},
+};
+
+constexpr size_t TOKEN_KIND_COUNT = (size_t) TokenKind::Eof + 1;
+
+constexpr std::array<InfixOperator, TOKEN_KIND_COUNT> make_infix_table() {
+    // Tokens that aren't operators keep InfixKind::None and Precedence::None
+    std::array<InfixOperator, TOKEN_KIND_COUNT> table {};
+    for(const auto& op: INFIX_OPERATORS) {
+        table[(size_t) op.token] = op;
+    }
+    return table;
+}
+constexpr std::array<InfixOperator, TOKEN_KIND_COUNT> INFIX_TABLE = make_infix_table();
+
+struct PrefixEntry {
+    bool is_prefix;
+    UnaryOp op;
+};
+constexpr std::array<PrefixEntry, TOKEN_KIND_COUNT> make_prefix_table() {
+    std::array<PrefixEntry, TOKEN_KIND_COUNT> table {};
+    for(const auto& op: PREFIX_OPERATORS) {
+        table[(size_t) op.token] = {.is_prefix = true, .op = op.op};
+    }
+    return table;
+}
+constexpr std::array<PrefixEntry, TOKEN_KIND_COUNT> PREFIX_TABLE = make_prefix_table();
+
+constexpr const InfixOperator& infix(TokenKind token) {
+    return INFIX_TABLE[(size_t) token];
+}
+constexpr const PrefixEntry& prefix(TokenKind token) {
+    return PREFIX_TABLE[(size_t) token];
+}
+}
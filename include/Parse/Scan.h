@@ -0,0 +1,25 @@
+#pragma once
+
+namespace HKSL {
+
+// Bulk scanners for the runs of bytes the lexer skips over: white space,
+// comment bodies and identifier characters. Every function returns the
+// first byte at or after `p` that doesn't belong to the run. The input must
+// be followed by SourceManager::PADDING zero bytes: the terminating zero
+// ends every run, and vector loads may read into the padding.
+struct Scanner {
+    const char* name;
+    const char* (*skip_white_space)(const char* p);
+    // Stops at the newline or at the end of the source
+    const char* (*skip_line)(const char* p);
+    const char* (*skip_identifier)(const char* p);
+
+    // Byte at a time, always available
+    static const Scanner& scalar();
+    // nullptr if the CPU (or the target) doesn't support the instruction set
+    static const Scanner* sse2();
+    static const Scanner* avx2();
+    // Widest implementation supported by the running CPU, picked once
+    static const Scanner& best();
+};
+}
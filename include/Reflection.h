@@ -0,0 +1,289 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Reflection blob written next to a compiled shader. A header, a table of
+// sections, then flat arrays of fixed-size little-endian records. Names are
+// offsets into a string section of null terminated strings.
+//
+// Standalone on purpose, the engine includes this header and reads the
+// blob in place, e.g. straight out of an mmap-ed file.
+namespace HKSL::Reflection {
+
+// "HKRF"
+constexpr uint32_t MAGIC = 0x46524B48;
+// Bumped when records change, new sections only append to Section
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+enum class Section: uint32_t {
+    // Count is in bytes
+    Strings,
+    Types,
+    Structs,
+    Fields,
+    EntryPoints,
+    Inputs,
+    UniformBlocks,
+    Uniforms,
+    Count,
+};
+
+struct SectionRecord {
+    // From the start of the blob, a multiple of 4
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    // Of the whole blob
+    uint32_t size;
+    // Sections the writer knew, readers ignore those past Section::Count
+    uint32_t section_count;
+    SectionRecord sections[(size_t) Section::Count];
+};
+
+enum class TypeKind: uint8_t {
+    Void,
+    Scalar,
+    Vector,
+    Matrix,
+    Struct,
+};
+enum class ScalarKind: uint8_t {
+    None,
+    Float,
+    Half,
+};
+struct TypeRecord {
+    uint32_t name;
+    TypeKind kind;
+    ScalarKind scalar;
+    // Vector width or matrix columns
+    uint8_t columns;
+    uint8_t rows;
+    // Into structs(), NO_INDEX unless kind is Struct
+    uint32_t struct_index;
+    // Tightly packed
+    uint32_t size;
+};
+
+// Indexes the per-layout arrays of struct and field records
+enum class Layout: uint32_t {
+    Std140,
+    Std430,
+    Scalar,
+    Count,
+};
+constexpr size_t LAYOUT_COUNT = (size_t) Layout::Count;
+
+struct StructRecord {
+    uint32_t name;
+    // Fields are contiguous in fields(), in declaration order
+    uint32_t first_field;
+    uint32_t field_count;
+    uint32_t size[LAYOUT_COUNT];
+    uint32_t alignment[LAYOUT_COUNT];
+    // Bytes of size not covered by fields
+    uint32_t padding[LAYOUT_COUNT];
+};
+
+struct FieldRecord {
+    uint32_t name;
+    // Into types()
+    uint32_t type;
+    uint32_t offset[LAYOUT_COUNT];
+};
+
+enum class Stage: uint32_t {
+    Vertex,
+    Fragment,
+    Compute,
+};
+struct EntryPointRecord {
+    uint32_t name;
+    Stage stage;
+    // Inputs are contiguous in inputs(), in parameter order
+    uint32_t first_input;
+    uint32_t input_count;
+    // Into types(), the void type for no output
+    uint32_t output_type;
+};
+
+struct InputRecord {
+    uint32_t name;
+    uint32_t type;
+    uint32_t location;
+};
+
+enum class BlockKind: uint32_t {
+    PushConstant,
+    UniformBuffer,
+};
+// How often the host updates a uniform, from least to most often
+enum class UpdateFrequency: uint32_t {
+    Frame,
+    Material,
+    Draw,
+};
+struct BlockRecord {
+    BlockKind kind;
+    // Of every member of a uniform buffer, Draw for push constants
+    UpdateFrequency frequency;
+    // Descriptor binding of a uniform buffer, 0 for push constants
+    uint32_t binding;
+    // Push constants are std430, uniform buffers std140
+    uint32_t size;
+    // Members are contiguous in uniforms(), by offset
+    uint32_t first_member;
+    uint32_t member_count;
+};
+
+struct UniformRecord {
+    uint32_t name;
+    uint32_t type;
+    // Into uniform_blocks()
+    uint32_t block;
+    uint32_t offset;
+    // Reads in the source, which decided the placement
+    uint32_t accesses;
+    UpdateFrequency frequency;
+};
+
+// Typed views over a blob, no parsing and no copies. The blob must outlive
+// the reader and be 4 byte aligned, which mmap-ed and malloc-ed memory is.
+class Reader {
+    public:
+        Reader(const void* data, size_t size) {
+            this->data = static_cast<const uint8_t*>(data);
+            this->size = size;
+        }
+        // Checks the header, that every section lies inside the blob, and
+        // that every name, index and record range points inside its
+        // section. The accessors below assume it passed, enum values are
+        // not checked.
+        bool valid() const {
+            if(size < sizeof(Header) || reinterpret_cast<uintptr_t>(data) % 4 != 0) {
+                return false;
+            }
+            const Header& h = header();
+            if(h.magic != MAGIC || h.version != VERSION || h.size > size || h.section_count < (uint32_t) Section::Count) {
+                return false;
+            }
+            return section_fits(Section::Strings, 1)
+                && section_fits(Section::Types, sizeof(TypeRecord))
+                && section_fits(Section::Structs, sizeof(StructRecord))
+                && section_fits(Section::Fields, sizeof(FieldRecord))
+                && section_fits(Section::EntryPoints, sizeof(EntryPointRecord))
+                && section_fits(Section::Inputs, sizeof(InputRecord))
+                && section_fits(Section::UniformBlocks, sizeof(BlockRecord))
+                && section_fits(Section::Uniforms, sizeof(UniformRecord))
+                && (strings().empty() || strings().back() == '\0')
+                && references_fit();
+        }
+        const Header& header() const {
+            return *reinterpret_cast<const Header*>(data);
+        }
+        std::span<const char> strings() const {
+            return section<char>(Section::Strings);
+        }
+        const char* string(uint32_t offset) const {
+            return strings().data() + offset;
+        }
+        std::span<const TypeRecord> types() const {
+            return section<TypeRecord>(Section::Types);
+        }
+        std::span<const StructRecord> structs() const {
+            return section<StructRecord>(Section::Structs);
+        }
+        std::span<const FieldRecord> fields() const {
+            return section<FieldRecord>(Section::Fields);
+        }
+        std::span<const FieldRecord> fields(const StructRecord& record) const {
+            return fields().subspan(record.first_field, record.field_count);
+        }
+        std::span<const EntryPointRecord> entry_points() const {
+            return section<EntryPointRecord>(Section::EntryPoints);
+        }
+        std::span<const InputRecord> inputs() const {
+            return section<InputRecord>(Section::Inputs);
+        }
+        std::span<const InputRecord> inputs(const EntryPointRecord& record) const {
+            return inputs().subspan(record.first_input, record.input_count);
+        }
+        // The push constant block first if there is one
+        std::span<const BlockRecord> uniform_blocks() const {
+            return section<BlockRecord>(Section::UniformBlocks);
+        }
+        std::span<const UniformRecord> uniforms() const {
+            return section<UniformRecord>(Section::Uniforms);
+        }
+        std::span<const UniformRecord> uniforms(const BlockRecord& record) const {
+            return uniforms().subspan(record.first_member, record.member_count);
+        }
+    private:
+        template<typename T>
+        std::span<const T> section(Section section) const {
+            const SectionRecord& record = header().sections[(size_t) section];
+            return std::span<const T>(reinterpret_cast<const T*>(data + record.offset), record.count);
+        }
+        bool section_fits(Section section, size_t record_size) const {
+            const SectionRecord& record = header().sections[(size_t) section];
+            return record.offset % 4 == 0 && record.offset <= header().size
+                && record.count <= (header().size - record.offset) / record_size;
+        }
+        // The strings end in a null, so any offset inside starts one
+        bool string_fits(uint32_t offset) const {
+            return offset < strings().size();
+        }
+        static bool range_fits(uint32_t first, uint32_t count, size_t size) {
+            return first <= size && count <= size - first;
+        }
+        bool references_fit() const {
+            size_t n_types = types().size();
+            for(const auto& type: types()) {
+                if(!string_fits(type.name) || (type.struct_index != NO_INDEX && type.struct_index >= structs().size())) {
+                    return false;
+                }
+            }
+            for(const auto& record: structs()) {
+                if(!string_fits(record.name) || !range_fits(record.first_field, record.field_count, fields().size())) {
+                    return false;
+                }
+            }
+            for(const auto& field: fields()) {
+                if(!string_fits(field.name) || field.type >= n_types) {
+                    return false;
+                }
+            }
+            for(const auto& entry_point: entry_points()) {
+                if(!string_fits(entry_point.name) || entry_point.output_type >= n_types
+                    || !range_fits(entry_point.first_input, entry_point.input_count, inputs().size())) {
+                    return false;
+                }
+            }
+            for(const auto& input: inputs()) {
+                if(!string_fits(input.name) || input.type >= n_types) {
+                    return false;
+                }
+            }
+            for(const auto& block: uniform_blocks()) {
+                if(!range_fits(block.first_member, block.member_count, uniforms().size())) {
+                    return false;
+                }
+            }
+            for(const auto& uniform: uniforms()) {
+                if(!string_fits(uniform.name) || uniform.type >= n_types || uniform.block >= uniform_blocks().size()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        const uint8_t* data;
+        size_t size;
+};
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <Context.h>
+#include <Compiler.h>
+#include <Reflection.h>
+
+namespace HKSL {
+// Stage of the entry point named `name`, entry points are the top level
+// functions named vertex_main, fragment_main or compute_main
+std::optional<Reflection::Stage> entry_point_stage(std::string_view name);
+// Entry point parameters are the inputs
+std::vector<uint8_t> write_reflection(CompilationContext& context, std::span<const StructReport> structs, std::span<const UniformBlock> uniform_blocks);
+// Readable dump of a valid blob, for debugging
+std::string reflection_to_json(const Reflection::Reader& reader);
+}
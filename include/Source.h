@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <FSUtil.h>
+
+namespace HKSL {
+
+// Human readable position, only computed when a diagnostic is rendered
+struct SourceLocation {
+    uint32_t line;
+    uint32_t col;
+    std::string to_string() const;
+};
+
+// Maps byte offsets to line:col. The newline index is built the first time
+// a location is asked for, so sources that compile cleanly never pay for it.
+class LineTable {
+    public:
+        LineTable(std::string_view text);
+        SourceLocation locate(uint32_t offset);
+    private:
+        void build();
+        std::string_view text;
+        // Built on the first locate(), which may come from several threads
+        std::once_flag built;
+        // Offset of the first byte of every line
+        std::vector<uint32_t> line_starts;
+};
+
+// A source owned by the SourceManager, either memory mapped or an in-memory
+// buffer. text() is always followed by SourceManager::PADDING zero bytes.
+class SourceFile {
+    public:
+        SourceFile(uint32_t id, const std::string& name, MappedFile mapping);
+        SourceFile(uint32_t id, const std::string& name, std::string buffer);
+        uint32_t id() const;
+        const std::string& name() const;
+        std::string_view text() const;
+        SourceLocation locate(uint32_t offset);
+    private:
+        uint32_t m_id;
+        std::string m_name;
+        std::optional<MappedFile> mapping;
+        std::string buffer;
+        std::string_view m_text;
+        LineTable lines;
+};
+
+// Owns every source of a compilation (or a batch of them). File IDs are
+// indices handed out in order and stay valid for the manager's lifetime.
+class SourceManager {
+    public:
+        // Zero bytes guaranteed after every source, enough for the widest
+        // vector load the lexer does, so its hot loops need no EOF checks
+        static constexpr size_t PADDING = 64;
+
+        SourceManager() = default;
+        SourceManager(const SourceManager& other) = delete;
+        SourceManager& operator=(const SourceManager& other) = delete;
+
+        uint32_t load_file(const std::string& path);
+        // Takes ownership of the buffer and pads it in place
+        uint32_t add_buffer(const std::string& name, std::string text);
+        SourceFile& file(uint32_t id);
+        size_t size();
+        SourceLocation locate(uint32_t file, uint32_t offset);
+    private:
+        std::mutex mutex;
+        std::vector<std::unique_ptr<SourceFile>> files;
+};
+}
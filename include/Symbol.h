@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace HKSL {
+
+// An interned name. Two symbols are equal iff their names are equal, so
+// scopes and registries can compare and hash them as plain integers.
+struct Symbol {
+    uint32_t id;
+    bool operator==(const Symbol& other) const = default;
+};
+
+// Maps names to dense 32-bit symbol IDs. Each distinct name is copied once
+// (null terminated) into interner-owned blocks, every later occurrence is
+// just a lookup. Safe to share between several compilations running on
+// different threads.
+class SymbolInterner {
+    public:
+        SymbolInterner();
+        SymbolInterner(const SymbolInterner& other) = delete;
+        SymbolInterner& operator=(const SymbolInterner& other) = delete;
+
+        // Process wide interner used when a compilation isn't given its own
+        static SymbolInterner& global();
+
+        Symbol intern(std::string_view name);
+        std::string_view str(Symbol symbol) const;
+        const char* c_str(Symbol symbol) const;
+        size_t size() const;
+    private:
+        std::string_view store(std::string_view name);
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string_view, Symbol> lookup;
+        std::vector<std::string_view> names;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t block_used;
+        size_t block_capacity;
+};
+}
+
+template<>
+struct std::hash<HKSL::Symbol> {
+    size_t operator()(const HKSL::Symbol& symbol) const noexcept {
+        return std::hash<uint32_t>{}(symbol.id);
+    }
+};
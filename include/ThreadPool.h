@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace HKSL {
+
+// Fixed set of worker threads running one batch of indexed tasks at a time.
+// The calling thread works on the batch too, so a pool of size 1 spawns no
+// threads and runs everything inline.
+class ThreadPool {
+    public:
+        // n_threads counts the calling thread, 0 means one per hardware thread
+        ThreadPool(size_t n_threads = 0);
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+        ~ThreadPool();
+        size_t size() const;
+        // Runs task(0) .. task(n_tasks - 1) and returns once all of them are
+        // done. Not reentrant, tasks must not call back into the pool.
+        void parallel_for(size_t n_tasks, const std::function<void(size_t)>& task);
+    private:
+        void worker();
+        void run_tasks();
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+        // Current batch, replaced only while no worker is inside it
+        const std::function<void(size_t)>* task = nullptr;
+        size_t n_tasks = 0;
+        std::atomic<size_t> next_task = 0;
+        std::atomic<size_t> n_finished = 0;
+        // Bumped for every batch so sleeping workers can tell a new one came in
+        uint64_t generation = 0;
+        size_t n_active = 0;
+        bool stopping = false;
+};
+}
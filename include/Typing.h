@@ -1,91 +1,126 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <unordered_map>
+#include <vector>
 #include <string>
-
-#define HKSL_VOID_TYPE_ID 0
-#define HKSL_FLOAT_TYPE_ID 1
-#define HKSL_FLOAT2_TYPE_ID 2
-#define HKSL_FLOAT3_TYPE_ID 3
-#define HKSL_FLOAT4_TYPE_ID 4
+#include <Symbol.h>
+#include <AST/NodeId.h>
 
 namespace HKSL {
-enum class TypeKind {
-    Float,
-    Float2,
-    Float3,
-    Float4,
+enum class TypeKind: uint8_t {
     Void,
+    Scalar,
+    Vector,
+    Matrix,
     Struct
 };
-class Type {
-    public:
-        virtual ~Type() = default;
-        virtual uint64_t id() const = 0; 
-        virtual const char* name() const = 0;
-        virtual size_t size_of() const = 0;
-        virtual TypeKind kind() const = 0;
+enum class ScalarKind: uint8_t {
+    // Void and struct types
+    None,
+    Float,
+    Half,
 };
-struct Void: public Type {
-    uint64_t id() const override;
-    const char* name() const override;
-    virtual size_t size_of() const override;
-    TypeKind kind() const override;
+// Plain description of a type. Every distinct descriptor is interned once
+// by TypeRegistry, so types compare by pointer or id.
+struct TypeDesc {
+    TypeKind kind;
+    ScalarKind scalar;
+    // Vector width or matrix columns, 1 otherwise
+    uint8_t columns;
+    // Matrix rows, 1 otherwise
+    uint8_t rows;
+    // Only for TypeKind::Struct
+    uint32_t struct_id;
+    bool operator==(const TypeDesc& other) const = default;
 };
+class Type {
+    public:
+        // Dense index in the registry that made the type
+        uint32_t id() const;
+        const char* name() const;
+        // Tightly packed size, see Layout.h for the buffer layout rules
+        size_t size_of() const;
+        TypeKind kind() const;
+        ScalarKind scalar() const;
+        const TypeDesc& desc() const;
+    private:
+        friend class TypeRegistry;
+        Type(const TypeDesc& desc, uint32_t id, const char* name, uint32_t size);
 
-struct Float: public Type {
-    uint64_t id() const override;
-    const char* name() const override;
-    virtual size_t size_of() const override;
-    TypeKind kind() const override;
+        TypeDesc m_desc;
+        uint32_t m_id;
+        const char* m_name;
+        uint32_t m_size;
 };
-
-struct Float2: public Type {
-    uint64_t id() const override;
-    const char* name() const override;
-    virtual size_t size_of() const override;
-    TypeKind kind() const override;
+// Bytes of one component, 0 for ScalarKind::None
+uint32_t scalar_size_of(ScalarKind scalar);
+struct TypeDescHash {
+    size_t operator()(const TypeDesc& desc) const noexcept;
 };
 
-struct Float3: public Type {
-    uint64_t id() const override;
-    const char* name() const override;
-    virtual size_t size_of() const override;
-    TypeKind kind() const override;
+struct StructField {
+    Symbol name;
+    Type* type;
 };
-
-struct Float4: public Type {
-    uint64_t id() const override;
-    const char* name() const override;
-    virtual size_t size_of() const override;
-    TypeKind kind() const override;
+struct StructInfo {
+    Symbol name;
+    // Declaration order
+    std::vector<StructField> fields;
 };
 
 class TypeRegistry {
     public:
-        TypeRegistry();
-        bool register_type(std::unique_ptr<Type> ty);
+        TypeRegistry(SymbolInterner& symbols);
+        // Looks up a type by the name it's written as, nullptr if unknown
+        Type* get(Symbol name);
         Type* get(const char* name);
         Type* get(const std::string& name);
+        // The one type described by `desc`, created on first use. Not
+        // synchronized: only the constructor and add_struct create types, and
+        // both run before the parallel passes, which only look types up.
+        Type* intern(const TypeDesc& desc);
+        Type* scalar(ScalarKind scalar);
+        Type* vector(ScalarKind scalar, uint8_t width);
+        // Column major, named float{columns}x{rows}
+        Type* matrix(ScalarKind scalar, uint8_t columns, uint8_t rows);
+        // Declares a struct type named `name`, nullptr if a type of that name
+        // already exists. Not synchronized, see intern.
+        Type* add_struct(Symbol name, std::vector<StructField> fields);
+        const StructInfo& struct_info(const Type* type) const;
         Type* get_float();
         Type* get_float2();
         Type* get_float3();
+        Type* get_half();
         Type* get_void();
 
     private:
-        bool is_primitive(const Type& type);
-        std::unordered_map<std::string, std::unique_ptr<Type>> types;
+        // Makes `type` nameable in source
+        void add_name(Type* type);
+        std::string make_name(const TypeDesc& desc);
+        Type* create(const TypeDesc& desc, const char* name, uint32_t size);
+        SymbolInterner& symbols;
+        // Deque keeps Type pointers stable as types are added
+        std::deque<Type> types;
+        std::unordered_map<TypeDesc, Type*, TypeDescHash> interned;
+        std::unordered_map<Symbol, Type*> names;
+        // Indexed by TypeDesc::struct_id
+        std::vector<StructInfo> structs;
+        Type* void_type;
+        Type* float_type;
+        Type* half_type;
 };
 
-class Expr;
-
 class TypeResolver {
     public:
         TypeResolver() = default;
-        void register_expr(const Expr* expr, Type* type);
-        Type* type_of(const Expr* expr);
+        // Makes room for every node of an AST with `node_count` nodes
+        void resize(size_t node_count);
+        void register_expr(NodeId expr, Type* type);
+        // nullptr if the expression has no inferred type
+        Type* type_of(NodeId expr);
     private:
-        std::unordered_map<const Expr*, Type*> type_map;
+        std::vector<Type*> types;
 };
 }
\ No newline at end of file
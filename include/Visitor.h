@@ -3,34 +3,230 @@
 #include <AST/AST.h>
 
 namespace HKSL {
+// Walks an AST by node id. Every hook gets the node's id and its decoded
+// view, the default implementations visit the children in source order.
+//
+// Passes derive as `class Pass: public Visitor<Pass>` and hide the hooks
+// they care about, calls are resolved at compile time so hooks a pass
+// doesn't define inline away. Passes with private hooks must befriend
+// their Visitor base.
+template<typename Derived>
 class Visitor {
     public:
-        virtual ~Visitor() = default;
-        virtual void visit(AST& ast);
-        virtual void visit_statement(Statement* statement);
-        virtual void visit_expr_statement(ExprStatement* expr);
-        virtual void visit_if_statement(IfStatement* if_statement);
-        virtual void visit_else_statement(ElseStatement* if_statement);
-        virtual void visit_block_statement(BlockStatement* block);
-        virtual void visit_function(Function* function);
-        virtual void visit_return_statement(ReturnStatement* return_statement);
-        virtual void visit_expr(Expr* expr);
-        virtual void visit_binary_expr(BinExpr* expr);
-        virtual void visit_unary_expr(UnaryExpr* expr);
-        virtual void visit_variable(Variable* variable);
-        virtual void visit_var_decl(VarDecl* var_decl);
-        virtual void visit_number_constant(NumberConstant* expr);
-        virtual void visit_call_expr(CallExpr* expr);
-        virtual void visit_assignment_expr(AssignmentExpr* expr);
-        virtual void visit_let_expr(LetExpr* expr);
-
-        virtual void visit_binary_op(BinOp op);
-        virtual void visit_unary_op(UnaryOp op);
-        virtual void visit_variable_name(Identifier& name);
-        virtual void visit_function_name(Identifier& name);
-        virtual void visit_identifier(Identifier& identifier);
-        virtual void visit_type(Type* type);
-        virtual void visit_function_arg(VarDecl* arg);
-        virtual void visit_call_arg(Expr* arg);
+        void visit(AST& ast);
+        void visit_statement(NodeId statement);
+        void visit_expr_statement(NodeId node, const ExprStatement& expr);
+        void visit_if_statement(NodeId node, const IfStatement& if_statement);
+        void visit_else_statement(NodeId node, const ElseStatement& else_statement);
+        void visit_block_statement(NodeId node, const BlockStatement& block);
+        void visit_function(NodeId node, const Function& function);
+        void visit_return_statement(NodeId node, const ReturnStatement& return_statement);
+        void visit_struct_decl(NodeId node, const StructDecl& struct_decl);
+        void visit_uniform_decl(NodeId node, const UniformDecl& uniform_decl);
+        void visit_expr(NodeId expr);
+        void visit_binary_expr(NodeId node, const BinExpr& expr);
+        void visit_unary_expr(NodeId node, const UnaryExpr& expr);
+        void visit_variable(NodeId node, const Variable& variable);
+        void visit_var_decl(NodeId node, const VarDecl& var_decl);
+        void visit_number_constant(NodeId node, const NumberConstant& expr);
+        void visit_call_expr(NodeId node, const CallExpr& expr);
+        void visit_assignment_expr(NodeId node, const AssignmentExpr& expr);
+        void visit_let_expr(NodeId node, const LetExpr& expr);
+
+        void visit_binary_op(BinOp) {}
+        void visit_unary_op(UnaryOp) {}
+        void visit_variable_name(const Identifier& name);
+        void visit_function_name(const Identifier& name);
+        void visit_identifier(const Identifier&) {}
+        void visit_type(Type*) {}
+        void visit_function_arg(NodeId arg);
+        void visit_call_arg(NodeId arg);
+    protected:
+        // The AST being visited, set by visit()
+        AST& ast() {
+            return *current_ast;
+        }
+        // For passes visiting single nodes of an AST instead of all of it
+        void set_ast(AST& ast) {
+            current_ast = &ast;
+        }
+    private:
+        Derived& derived() {
+            return static_cast<Derived&>(*this);
+        }
+
+        AST* current_ast = nullptr;
 };
+
+template<typename Derived>
+void Visitor<Derived>::visit(AST& ast) {
+    set_ast(ast);
+    for(NodeId statement: ast.top_level()) {
+        derived().visit_statement(statement);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_statement(NodeId statement) {
+    switch(ast().kind(statement)) {
+        case NodeKind::ExprStatement:
+            return derived().visit_expr_statement(statement, ast().expr_statement(statement));
+        case NodeKind::If:
+            return derived().visit_if_statement(statement, ast().if_statement(statement));
+        case NodeKind::Else:
+            return derived().visit_else_statement(statement, ast().else_statement(statement));
+        case NodeKind::Block:
+            return derived().visit_block_statement(statement, ast().block_statement(statement));
+        case NodeKind::Function:
+            return derived().visit_function(statement, ast().function(statement));
+        case NodeKind::Return:
+            return derived().visit_return_statement(statement, ast().return_statement(statement));
+        case NodeKind::Struct:
+            return derived().visit_struct_decl(statement, ast().struct_decl(statement));
+        case NodeKind::Uniform:
+            return derived().visit_uniform_decl(statement, ast().uniform_decl(statement));
+        default:
+            HKSL_TODO();
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_expr_statement(NodeId, const ExprStatement& expr) {
+    derived().visit_expr(expr.expr);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_if_statement(NodeId, const IfStatement& if_statement) {
+    derived().visit_expr(if_statement.condition);
+    derived().visit_block_statement(if_statement.then_block, ast().block_statement(if_statement.then_block));
+    if(if_statement.else_stmt != NO_NODE) {
+        derived().visit_statement(if_statement.else_stmt);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_else_statement(NodeId, const ElseStatement& else_statement) {
+    derived().visit_statement(else_statement.statement);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_block_statement(NodeId, const BlockStatement& block) {
+    for(NodeId statement: block.statements) {
+        derived().visit_statement(statement);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_function(NodeId, const Function& function) {
+    derived().visit_function_name(function.name);
+
+    for(NodeId arg: function.args) {
+        derived().visit_function_arg(arg);
+    }
+
+    if(function.return_type) {
+        derived().visit_type(function.return_type);
+    }
+
+    derived().visit_block_statement(function.block, ast().block_statement(function.block));
+}
+template<typename Derived>
+void Visitor<Derived>::visit_return_statement(NodeId, const ReturnStatement& return_statement) {
+    if(return_statement.value != NO_NODE) {
+        derived().visit_expr(return_statement.value);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_struct_decl(NodeId, const StructDecl& struct_decl) {
+    derived().visit_identifier(struct_decl.name);
+
+    for(NodeId field: struct_decl.fields) {
+        derived().visit_type(ast().var_decl(field).type);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_uniform_decl(NodeId, const UniformDecl& uniform_decl) {
+    // Not a local variable, so it doesn't go through visit_var_decl
+    auto var_decl = ast().var_decl(uniform_decl.var_decl);
+    derived().visit_variable_name(var_decl.name);
+    derived().visit_type(var_decl.type);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_expr(NodeId expr) {
+    switch(ast().kind(expr)) {
+        case NodeKind::BinExpr:
+            return derived().visit_binary_expr(expr, ast().bin_expr(expr));
+        case NodeKind::UnaryExpr:
+            return derived().visit_unary_expr(expr, ast().unary_expr(expr));
+        case NodeKind::Variable:
+            return derived().visit_variable(expr, ast().variable(expr));
+        case NodeKind::VarDecl:
+            return derived().visit_var_decl(expr, ast().var_decl(expr));
+        case NodeKind::NumberConstant:
+            return derived().visit_number_constant(expr, ast().number_constant(expr));
+        case NodeKind::CallExpr:
+            return derived().visit_call_expr(expr, ast().call_expr(expr));
+        case NodeKind::AssignmentExpr:
+            return derived().visit_assignment_expr(expr, ast().assignment_expr(expr));
+        case NodeKind::LetExpr:
+            return derived().visit_let_expr(expr, ast().let_expr(expr));
+        default:
+            HKSL_UNREACHABLE();
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_binary_expr(NodeId, const BinExpr& expr) {
+    derived().visit_binary_op(expr.op);
+    derived().visit_expr(expr.left);
+    derived().visit_expr(expr.right);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_unary_expr(NodeId, const UnaryExpr& expr) {
+    derived().visit_unary_op(expr.op);
+    derived().visit_expr(expr.expr);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_variable(NodeId, const Variable& variable) {
+    derived().visit_variable_name(variable.name);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_var_decl(NodeId, const VarDecl& var_decl) {
+    derived().visit_variable_name(var_decl.name);
+
+    if(var_decl.type) {
+        derived().visit_type(var_decl.type);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_number_constant(NodeId, const NumberConstant&) {}
+template<typename Derived>
+void Visitor<Derived>::visit_call_expr(NodeId, const CallExpr& expr) {
+    derived().visit_function_name(expr.fn_name);
+    for(NodeId arg: expr.args) {
+        derived().visit_call_arg(arg);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_assignment_expr(NodeId, const AssignmentExpr& expr) {
+    derived().visit_expr(expr.lhs);
+    derived().visit_expr(expr.rhs);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_let_expr(NodeId, const LetExpr& expr) {
+    derived().visit_var_decl(expr.var_decl, ast().var_decl(expr.var_decl));
+
+    if(expr.rhs != NO_NODE) {
+        derived().visit_expr(expr.rhs);
+    }
+}
+template<typename Derived>
+void Visitor<Derived>::visit_variable_name(const Identifier& name) {
+    derived().visit_identifier(name);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_function_name(const Identifier& name) {
+    derived().visit_identifier(name);
+}
+template<typename Derived>
+void Visitor<Derived>::visit_function_arg(NodeId arg) {
+    derived().visit_var_decl(arg, ast().var_decl(arg));
+}
+template<typename Derived>
+void Visitor<Derived>::visit_call_arg(NodeId arg) {
+    derived().visit_expr(arg);
+}
 }
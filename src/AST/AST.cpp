@@ -1,28 +1,48 @@
 #include <AST/AST.h>
 #include <format>
 namespace HKSL {
-bool expr_kind_is_place(ExprKind kind) {
-    return kind == ExprKind::Variable || kind == ExprKind::CallExpr;
+bool node_kind_is_expr(NodeKind kind) {
+    return kind <= NodeKind::LetExpr;
 }
-const char* expr_kind_to_string(ExprKind kind) {
+bool node_kind_is_place(NodeKind kind) {
+    return kind == NodeKind::Variable || kind == NodeKind::CallExpr;
+}
+const char* node_kind_to_string(NodeKind kind) {
     switch(kind) {
-        case ExprKind::BinExpr:
+        case NodeKind::BinExpr:
             return "BinExpr";
-        case ExprKind::UnaryExpr:
+        case NodeKind::UnaryExpr:
             return "UnaryExpr";
-        case ExprKind::NumberConstant:
+        case NodeKind::NumberConstant:
             return "NumberConstant";
-        case ExprKind::Variable:
+        case NodeKind::Variable:
             return "Variable";
-        case ExprKind::VarDecl:
+        case NodeKind::VarDecl:
             return "VarDecl";
-        case ExprKind::CallExpr:
+        case NodeKind::CallExpr:
             return "CallExpr";
-        case ExprKind::AssignmentExpr:
+        case NodeKind::AssignmentExpr:
             return "AssignmentExpr";
-        case ExprKind::LetExpr:
+        case NodeKind::LetExpr:
             return "LetExpr";
+        case NodeKind::ExprStatement:
+            return "ExprStatement";
+        case NodeKind::If:
+            return "IfStatement";
+        case NodeKind::Else:
+            return "ElseStatement";
+        case NodeKind::Block:
+            return "BlockStatement";
+        case NodeKind::Function:
+            return "Function";
+        case NodeKind::Return:
+            return "ReturnStatement";
+        case NodeKind::Struct:
+            return "StructDecl";
+        case NodeKind::Uniform:
+            return "UniformDecl";
     }
+    HKSL_UNREACHABLE();
 }
 std::string unary_op_to_string(UnaryOp op) {
     switch(op) {
@@ -32,19 +52,16 @@ std::string unary_op_to_string(UnaryOp op) {
             HKSL_ERROR("Unimplemented");
     }
 }
-UnaryExpr::UnaryExpr(UnaryOp op, std::unique_ptr<Expr> expr, Token op_token) {
-    this->op = op;
-    this->expr = std::move(expr);
-    this->op_token = op_token;
-}
-ExprKind UnaryExpr::kind() const {
-    return ExprKind::UnaryExpr;
-}
-
-void UnaryExpr::print(ASTPrinter& printer) const {
-    NodePrinter node("UnaryExpr", printer);
-    node.field("op", unary_op_to_string(op));
-    node.field("expr", expr.get());
+const char* update_frequency_to_string(UpdateFrequency frequency) {
+    switch(frequency) {
+        case UpdateFrequency::Frame:
+            return "frame";
+        case UpdateFrequency::Material:
+            return "material";
+        case UpdateFrequency::Draw:
+            return "draw";
+    }
+    HKSL_UNREACHABLE();
 }
 std::string bin_op_to_string(BinOp op) {
     switch(op) {
@@ -59,230 +76,443 @@ std::string bin_op_to_string(BinOp op) {
             case BinOp::Equals:
                 return "==";
     }
+    HKSL_UNREACHABLE();
 }
-BinExpr::BinExpr(BinOp op, std::unique_ptr<Expr> left, std::unique_ptr<Expr> right, Token op_token) {
-    this->op = op;
-    this->left = std::move(left);
-    this->right = std::move(right);
-    this->op_token = op_token;
+
+AST::AST(uint32_t file) {
+    this->file = file;
 }
-ExprKind BinExpr::kind() const {
-    return ExprKind::BinExpr;
+size_t AST::size() const {
+    return kinds.size();
 }
-void BinExpr::print(ASTPrinter& printer) const {
-    NodePrinter node("BinExpr", printer);
-    node.field("op", bin_op_to_string(op));
-    node.field("left", left.get());
-    node.field("right", right.get());
+NodeKind AST::kind(NodeId node) const {
+    return kinds[node];
 }
-
-NumberConstant::NumberConstant(NumberLiteral literal) {
-    this->number_literal = literal;
+Span AST::span(NodeId node) const {
+    return Span {.file = file, .offset = spans[node].offset, .length = spans[node].length};
 }
-ExprKind NumberConstant::kind() const {
-    return ExprKind::NumberConstant;
+std::span<const NodeId> AST::top_level() const {
+    return top_level_statements;
 }
-
-void NumberConstant::print(ASTPrinter& printer) const {
-    printer.print(std::format("NumberConstant({})", number_literal.value));
+std::span<const NodeId> AST::list(uint32_t start, uint32_t count) const {
+    return std::span<const NodeId>(extra.data() + start, count);
 }
 
-Variable::Variable(const Identifier& name) {
-    this->name = name;
-}
-ExprKind Variable::kind() const {
-    return ExprKind::Variable;
+// Field layout per kind, mirrored by the add_ functions below:
+//   BinExpr         a: left, b: right, c: op
+//   UnaryExpr       a: expr, c: op
+//   NumberConstant  a: bits, c: number kind
+//   Variable        a: symbol
+//   VarDecl         a: symbol, b: type slot
+//   CallExpr        a: symbol, b: args start in extra, c: n args
+//   AssignmentExpr  a: lhs, b: rhs
+//   LetExpr         a: var decl, b: rhs
+//   ExprStatement   a: expr
+//   Block           b: statements start in extra, c: n statements
+//   If              a: condition, b: then block, c: else
+//   Else            a: statement
+//   Function        a: symbol, b: start in extra of [block, return type slot, args...], c: n args
+//   Return          a: value
+//   Struct          a: symbol, b: start in extra of [type slot, fields...], c: n fields
+//   Uniform         a: var decl, c: update frequency
+BinExpr AST::bin_expr(NodeId node) const {
+    const NodeData& d = data[node];
+    return BinExpr {.op = (BinOp) d.c, .left = d.a, .right = d.b, .op_span = span(node)};
+}
+UnaryExpr AST::unary_expr(NodeId node) const {
+    const NodeData& d = data[node];
+    return UnaryExpr {.op = (UnaryOp) d.c, .expr = d.a, .op_span = span(node)};
+}
+NumberConstant AST::number_constant(NodeId node) const {
+    const NodeData& d = data[node];
+    return NumberConstant {.number_literal = NumberLiteral {.kind = (NumberKind) d.c, .bits = d.a}};
+}
+Variable AST::variable(NodeId node) const {
+    return Variable {.name = Identifier {.symbol = Symbol {data[node].a}, .span = span(node)}};
+}
+VarDecl AST::var_decl(NodeId node) const {
+    const NodeData& d = data[node];
+    return VarDecl {.name = Identifier {.symbol = Symbol {d.a}, .span = span(node)}, .type = types[d.b]};
+}
+CallExpr AST::call_expr(NodeId node) const {
+    const NodeData& d = data[node];
+    return CallExpr {.fn_name = Identifier {.symbol = Symbol {d.a}, .span = span(node)}, .args = list(d.b, d.c)};
+}
+AssignmentExpr AST::assignment_expr(NodeId node) const {
+    const NodeData& d = data[node];
+    return AssignmentExpr {.lhs = d.a, .rhs = d.b, .eq_span = span(node)};
+}
+LetExpr AST::let_expr(NodeId node) const {
+    const NodeData& d = data[node];
+    return LetExpr {.var_decl = d.a, .rhs = d.b};
+}
+ExprStatement AST::expr_statement(NodeId node) const {
+    return ExprStatement {.expr = data[node].a};
+}
+BlockStatement AST::block_statement(NodeId node) const {
+    const NodeData& d = data[node];
+    return BlockStatement {.statements = list(d.b, d.c)};
+}
+IfStatement AST::if_statement(NodeId node) const {
+    const NodeData& d = data[node];
+    return IfStatement {.condition = d.a, .then_block = d.b, .else_stmt = d.c};
+}
+ElseStatement AST::else_statement(NodeId node) const {
+    return ElseStatement {.statement = data[node].a};
+}
+Function AST::function(NodeId node) const {
+    const NodeData& d = data[node];
+    return Function {
+        .name = Identifier {.symbol = Symbol {d.a}, .span = span(node)},
+        .args = list(d.b + 2, d.c),
+        .block = extra[d.b],
+        .return_type = types[extra[d.b + 1]],
+    };
+}
+ReturnStatement AST::return_statement(NodeId node) const {
+    return ReturnStatement {.value = data[node].a, .ret_span = span(node)};
+}
+StructDecl AST::struct_decl(NodeId node) const {
+    const NodeData& d = data[node];
+    return StructDecl {
+        .name = Identifier {.symbol = Symbol {d.a}, .span = span(node)},
+        .fields = list(d.b + 1, d.c),
+        .type = types[extra[d.b]],
+    };
+}
+UniformDecl AST::uniform_decl(NodeId node) const {
+    const NodeData& d = data[node];
+    return UniformDecl {.var_decl = d.a, .frequency = (UpdateFrequency) d.c};
+}
+void AST::set_var_type(NodeId var_decl, Type* type) {
+    types[data[var_decl].b] = type;
 }
 
-void Variable::print(ASTPrinter& printer) const {
-    printer.print(std::format("Variable({})", name.name));
+NodeId AST::add(NodeKind kind, Span span, NodeData node_data) {
+    NodeId node = kinds.size();
+    kinds.push_back(kind);
+    spans.push_back(NodeSpan {.offset = span.offset, .length = span.length});
+    data.push_back(node_data);
+    return node;
 }
-
-VarDecl::VarDecl(const Identifier& name) {
-    this->name = name;
-    this->type = std::nullopt;
+uint32_t AST::add_list(std::span<const NodeId> nodes) {
+    uint32_t start = extra.size();
+    extra.insert(extra.end(), nodes.begin(), nodes.end());
+    return start;
 }
-VarDecl::VarDecl(const Identifier& name, std::optional<Type*>& type) {
-    this->name = name;
-    this->type = type;
+uint32_t AST::add_type(Type* type) {
+    types.push_back(type);
+    return types.size() - 1;
 }
-ExprKind VarDecl::kind() const {
-    return ExprKind::VarDecl;
+NodeId AST::add_bin_expr(BinOp op, NodeId left, NodeId right, Span op_span) {
+    return add(NodeKind::BinExpr, op_span, {.a = left, .b = right, .c = (uint32_t) op});
 }
-void VarDecl::print(ASTPrinter& printer) const {
-    printer.print(std::format("VarDecl({})", name.name));
+NodeId AST::add_unary_expr(UnaryOp op, NodeId expr, Span op_span) {
+    return add(NodeKind::UnaryExpr, op_span, {.a = expr, .b = 0, .c = (uint32_t) op});
 }
-CallExpr::CallExpr(const Identifier& fn_name, std::vector<std::unique_ptr<Expr>>& args) {
-    this->fn_name = fn_name;
-    this->args = std::move(args);
+NodeId AST::add_number_constant(NumberLiteral literal, Span span) {
+    return add(NodeKind::NumberConstant, span, {.a = literal.bits, .b = 0, .c = (uint32_t) literal.kind});
 }
-ExprKind CallExpr::kind() const {
-    return ExprKind::CallExpr;
+NodeId AST::add_variable(const Identifier& name) {
+    return add(NodeKind::Variable, name.span, {.a = name.symbol.id, .b = 0, .c = 0});
 }
-void CallExpr::print(ASTPrinter& printer) const {
-    NodePrinter node("CallExpr", printer);
-    node.field("fn_name", fn_name.name);
-
-    node.name("args");
-
-    {
-        ArrayPrinter array(args.size(), printer);
-        for(size_t i = 0; i < args.size(); i++) {
-            array.print_item(args[i].get());
-        }
-    }
+NodeId AST::add_var_decl(const Identifier& name, Type* type) {
+    return add(NodeKind::VarDecl, name.span, {.a = name.symbol.id, .b = add_type(type), .c = 0});
 }
-AssignmentExpr::AssignmentExpr(std::unique_ptr<Expr> lhs, std::unique_ptr<Expr> rhs, Token eq_token) {
-    this->lhs = std::move(lhs);
-    this->rhs = std::move(rhs);
-    this->eq_token = eq_token;
+NodeId AST::add_call_expr(const Identifier& fn_name, std::span<const NodeId> args) {
+    return add(NodeKind::CallExpr, fn_name.span, {.a = fn_name.symbol.id, .b = add_list(args), .c = (uint32_t) args.size()});
 }
-
-ExprKind AssignmentExpr::kind() const {
-    return ExprKind::AssignmentExpr;
+NodeId AST::add_assignment_expr(NodeId lhs, NodeId rhs, Span eq_span) {
+    return add(NodeKind::AssignmentExpr, eq_span, {.a = lhs, .b = rhs, .c = 0});
 }
-
-void AssignmentExpr::print(ASTPrinter &printer) const {
-    NodePrinter node("AssignmentExpr", printer);
-    node.field("lhs", lhs.get());
-    node.field("lhs", rhs.get());
+NodeId AST::add_let_expr(NodeId var_decl, NodeId rhs, Span let_span) {
+    return add(NodeKind::LetExpr, let_span, {.a = var_decl, .b = rhs, .c = 0});
 }
-LetExpr::LetExpr(std::unique_ptr<VarDecl> var_decl, const std::optional<Identifier>& type, std::optional<std::unique_ptr<Expr>> rhs) {
-    this->var_decl = std::move(var_decl);
-    this->rhs = std::move(rhs);
+NodeId AST::add_expr_statement(NodeId expr) {
+    return add(NodeKind::ExprStatement, span(expr), {.a = expr, .b = 0, .c = 0});
 }
-ExprKind LetExpr::kind() const {
-    return ExprKind::LetExpr;
+NodeId AST::add_block_statement(std::span<const NodeId> statements, Span span) {
+    return add(NodeKind::Block, span, {.a = 0, .b = add_list(statements), .c = (uint32_t) statements.size()});
 }
-void LetExpr::print(ASTPrinter& printer) const {
-    NodePrinter node("LetExpr", printer);
-    node.field("var_decl", var_decl.get());
-
-    if(rhs) {
-        node.field("rhs", rhs->get());
-    }
+NodeId AST::add_if_statement(NodeId condition, NodeId then_block, NodeId else_stmt, Span if_span) {
+    return add(NodeKind::If, if_span, {.a = condition, .b = then_block, .c = else_stmt});
 }
-
-ExprStatement::ExprStatement(std::unique_ptr<Expr> expr) {
-    this->expr = std::move(expr);
+NodeId AST::add_else_statement(NodeId statement, Span else_span) {
+    return add(NodeKind::Else, else_span, {.a = statement, .b = 0, .c = 0});
 }
-
-StatementKind ExprStatement::kind() const {
-    return StatementKind::Expr;
+NodeId AST::add_function(const Identifier& name, std::span<const NodeId> args, NodeId block, Type* return_type) {
+    NodeId header[] = {block, add_type(return_type)};
+    uint32_t start = add_list(header);
+    add_list(args);
+    return add(NodeKind::Function, name.span, {.a = name.symbol.id, .b = start, .c = (uint32_t) args.size()});
 }
-
-void ExprStatement::print(ASTPrinter& printer) const {
-    NodePrinter node("ExprStatement", printer);
-    node.field("expr", expr.get());
+NodeId AST::add_return_statement(NodeId value, Span ret_span) {
+    return add(NodeKind::Return, ret_span, {.a = value, .b = 0, .c = 0});
 }
-BlockStatement::BlockStatement(std::vector<std::unique_ptr<Statement>>& statements) {
-    this->statements = std::move(statements);
+NodeId AST::add_struct_decl(const Identifier& name, std::span<const NodeId> fields, Type* type) {
+    NodeId header[] = {add_type(type)};
+    uint32_t start = add_list(header);
+    add_list(fields);
+    return add(NodeKind::Struct, name.span, {.a = name.symbol.id, .b = start, .c = (uint32_t) fields.size()});
 }
-
-StatementKind BlockStatement::kind() const {
-    return StatementKind::Block;
+NodeId AST::add_uniform_decl(NodeId var_decl, UpdateFrequency frequency, Span uniform_span) {
+    return add(NodeKind::Uniform, uniform_span, {.a = var_decl, .b = 0, .c = (uint32_t) frequency});
+}
+void AST::set_top_level(std::span<const NodeId> statements) {
+    top_level_statements.assign(statements.begin(), statements.end());
 }
 
-void BlockStatement::print(ASTPrinter& printer) const {
-    NodePrinter node("BlockStatement", printer);
-    node.name("statements");
-    {
-        ArrayPrinter array(statements.size(), printer);
-        for(size_t i = 0; i < statements.size(); i++) {
-            array.print_item(statements[i].get());
-        }
+AST AST::concatenate(uint32_t file, std::span<const AST> parts, ThreadPool& pool) {
+    struct Base {
+        uint32_t node;
+        uint32_t extra;
+        uint32_t type;
+        uint32_t top_level;
+    };
+    std::vector<Base> bases;
+    Base total = {0, 0, 0, 0};
+    for(const auto& part: parts) {
+        bases.push_back(total);
+        total.node += part.size();
+        total.extra += part.extra.size();
+        total.type += part.types.size();
+        total.top_level += part.top_level_statements.size();
     }
-}
-// FunctionArg::FunctionArg(std::unique_ptr<Variable> variable, const Identifier& _type): type(_type){
-//     this->variable = std::move(variable);
-// }
-// void FunctionArg::print(ASTPrinter& printer) const {
-//     printer.print(std::format("{}: {}", variable->name.name, type.name));
-// }
-Function::Function(const Identifier& name, FunctionArgs& args, std::unique_ptr<BlockStatement> block, Type* return_type) {
-    this->m_name = name;
-    this->m_args = std::move(args);
-    this->m_block = std::move(block);
-    this->m_return_type = return_type;
-}
-StatementKind Function::kind() const {
-    return StatementKind::Function;
-}
-void Function::print(ASTPrinter& printer) const {
-    NodePrinter node("Function", printer);
-    node.field("name", m_name.name);
-    node.name("args");
 
-    {
-        ArrayPrinter array(m_args.size(), printer);
-        for(size_t i = 0; i < m_args.size(); i++) {
-            array.print_item(&m_args[i]);
+    AST ast(file);
+    ast.kinds.resize(total.node);
+    ast.spans.resize(total.node);
+    ast.data.resize(total.node);
+    ast.extra.resize(total.extra);
+    ast.types.resize(total.type);
+    ast.top_level_statements.resize(total.top_level);
+
+    pool.parallel_for(parts.size(), [&] (size_t i) {
+        const AST& part = parts[i];
+        Base base = bases[i];
+        auto node = [&] (NodeId id) {
+            return id == NO_NODE ? NO_NODE : id + base.node;
+        };
+        auto list = [&] (uint32_t start, uint32_t count) {
+            for(uint32_t j = start; j < start + count; j++) {
+                ast.extra[base.extra + j] = node(part.extra[j]);
+            }
+            return start + base.extra;
+        };
+
+        std::copy(part.kinds.begin(), part.kinds.end(), ast.kinds.begin() + base.node);
+        std::copy(part.spans.begin(), part.spans.end(), ast.spans.begin() + base.node);
+        std::copy(part.types.begin(), part.types.end(), ast.types.begin() + base.type);
+
+        // Shift every field holding a node id, extra index or type slot,
+        // following the layout above
+        for(size_t j = 0; j < part.size(); j++) {
+            NodeData d = part.data[j];
+            switch(part.kinds[j]) {
+                case NodeKind::BinExpr:
+                case NodeKind::AssignmentExpr:
+                case NodeKind::LetExpr:
+                    d.a = node(d.a);
+                    d.b = node(d.b);
+                    break;
+                case NodeKind::UnaryExpr:
+                case NodeKind::ExprStatement:
+                case NodeKind::Else:
+                case NodeKind::Return:
+                case NodeKind::Uniform:
+                    d.a = node(d.a);
+                    break;
+                case NodeKind::If:
+                    d.a = node(d.a);
+                    d.b = node(d.b);
+                    d.c = node(d.c);
+                    break;
+                case NodeKind::VarDecl:
+                    d.b += base.type;
+                    break;
+                case NodeKind::CallExpr:
+                case NodeKind::Block:
+                    d.b = list(d.b, d.c);
+                    break;
+                case NodeKind::Function:
+                    ast.extra[base.extra + d.b + 1] = part.extra[d.b + 1] + base.type;
+                    list(d.b, 1);
+                    d.b = list(d.b + 2, d.c) - 2;
+                    break;
+                case NodeKind::Struct:
+                    ast.extra[base.extra + d.b] = part.extra[d.b] + base.type;
+                    d.b = list(d.b + 1, d.c) - 1;
+                    break;
+                case NodeKind::NumberConstant:
+                case NodeKind::Variable:
+                    break;
+            }
+            ast.data[base.node + j] = d;
         }
-    }
 
-    node.name("block");
-    {
-        ArrayPrinter array(m_block->statements.size(), printer);
-        for(size_t i = 0; i < m_block->statements.size(); i++) {
-            array.print_item(m_block->statements[i].get());
+        for(size_t j = 0; j < part.top_level_statements.size(); j++) {
+            ast.top_level_statements[base.top_level + j] = node(part.top_level_statements[j]);
         }
-    }
+    });
 
-    node.field("return_type", m_return_type->name());
+    return ast;
 }
 
-ReturnStatement::ReturnStatement(std::optional<std::unique_ptr<Expr>> value, Token ret_token) {
-    this->value = std::move(value);
-    this->ret_token = ret_token;
-}
-StatementKind ReturnStatement::kind() const {
-    return StatementKind::Return;
-}
-void ReturnStatement::print(ASTPrinter& printer) const {
-    if(!value) {
-        printer.println("ReturnStatement");
-    } else {
-        NodePrinter node("ReturnStatement", printer);
+void AST::print(ASTPrinter& printer) const {
+    ArrayPrinter array(top_level_statements.size(), printer);
 
-        node.field("value", value->get());
+    for(NodeId statement: top_level_statements) {
+        array.print_item(NodeRef(*this, statement));
     }
 }
+void AST::print_node(ASTPrinter& printer, NodeId node) const {
+    switch(kind(node)) {
+        case NodeKind::BinExpr: {
+            auto expr = bin_expr(node);
+            NodePrinter node_printer("BinExpr", printer);
+            node_printer.field("op", bin_op_to_string(expr.op));
+            node_printer.field("left", NodeRef(*this, expr.left));
+            node_printer.field("right", NodeRef(*this, expr.right));
+            break;
+        }
+        case NodeKind::UnaryExpr: {
+            auto expr = unary_expr(node);
+            NodePrinter node_printer("UnaryExpr", printer);
+            node_printer.field("op", unary_op_to_string(expr.op));
+            node_printer.field("expr", NodeRef(*this, expr.expr));
+            break;
+        }
+        case NodeKind::NumberConstant:
+            printer.print(std::format("NumberConstant({})", number_constant(node).number_literal.value()));
+            break;
+        case NodeKind::Variable:
+            printer.print(std::format("Variable({})", printer.name_of(variable(node).name.symbol)));
+            break;
+        case NodeKind::VarDecl:
+            printer.print(std::format("VarDecl({})", printer.name_of(var_decl(node).name.symbol)));
+            break;
+        case NodeKind::CallExpr: {
+            auto expr = call_expr(node);
+            NodePrinter node_printer("CallExpr", printer);
+            node_printer.field("fn_name", std::string(printer.name_of(expr.fn_name.symbol)));
+
+            node_printer.name("args");
+            ArrayPrinter array(expr.args.size(), printer);
+            for(NodeId arg: expr.args) {
+                array.print_item(NodeRef(*this, arg));
+            }
+            break;
+        }
+        case NodeKind::AssignmentExpr: {
+            auto expr = assignment_expr(node);
+            NodePrinter node_printer("AssignmentExpr", printer);
+            node_printer.field("lhs", NodeRef(*this, expr.lhs));
+            node_printer.field("rhs", NodeRef(*this, expr.rhs));
+            break;
+        }
+        case NodeKind::LetExpr: {
+            auto expr = let_expr(node);
+            NodePrinter node_printer("LetExpr", printer);
+            node_printer.field("var_decl", NodeRef(*this, expr.var_decl));
+
+            if(expr.rhs != NO_NODE) {
+                node_printer.field("rhs", NodeRef(*this, expr.rhs));
+            }
+            break;
+        }
+        case NodeKind::ExprStatement: {
+            NodePrinter node_printer("ExprStatement", printer);
+            node_printer.field("expr", NodeRef(*this, expr_statement(node).expr));
+            break;
+        }
+        case NodeKind::Block: {
+            auto block = block_statement(node);
+            NodePrinter node_printer("BlockStatement", printer);
+            node_printer.name("statements");
+
+            ArrayPrinter array(block.statements.size(), printer);
+            for(NodeId statement: block.statements) {
+                array.print_item(NodeRef(*this, statement));
+            }
+            break;
+        }
+        case NodeKind::Function: {
+            auto func = function(node);
+            NodePrinter node_printer("Function", printer);
+            node_printer.field("name", std::string(printer.name_of(func.name.symbol)));
+            node_printer.name("args");
+
+            {
+                ArrayPrinter array(func.args.size(), printer);
+                for(NodeId arg: func.args) {
+                    array.print_item(NodeRef(*this, arg));
+                }
+            }
 
-IfStatement::IfStatement(std::unique_ptr<Expr> condition, std::unique_ptr<BlockStatement> block, std::optional<std::unique_ptr<ElseStatement>> else_stmt) {
-    this->condition = std::move(condition);
-    this->then_block = std::move(block);
-    this->else_stmt = std::move(else_stmt);
-}
-StatementKind IfStatement::kind() const {
-    return StatementKind::If;
-}
-void IfStatement::print(ASTPrinter &printer) const {
-    NodePrinter node("IfStatement", printer);
-    node.field("condition", condition.get());
-    node.field("condition", then_block.get());
+            node_printer.name("block");
+            {
+                auto block = block_statement(func.block);
+                ArrayPrinter array(block.statements.size(), printer);
+                for(NodeId statement: block.statements) {
+                    array.print_item(NodeRef(*this, statement));
+                }
+            }
 
-    if(else_stmt) {
-        node.field("else", else_stmt->get());
+            node_printer.field("return_type", func.return_type->name());
+            break;
+        }
+        case NodeKind::Return: {
+            auto ret = return_statement(node);
+            if(ret.value == NO_NODE) {
+                printer.println("ReturnStatement");
+            } else {
+                NodePrinter node_printer("ReturnStatement", printer);
+                node_printer.field("value", NodeRef(*this, ret.value));
+            }
+            break;
+        }
+        case NodeKind::If: {
+            auto if_stmt = if_statement(node);
+            NodePrinter node_printer("IfStatement", printer);
+            node_printer.field("condition", NodeRef(*this, if_stmt.condition));
+            node_printer.field("then_block", NodeRef(*this, if_stmt.then_block));
+
+            if(if_stmt.else_stmt != NO_NODE) {
+                node_printer.field("else", NodeRef(*this, if_stmt.else_stmt));
+            }
+            break;
+        }
+        case NodeKind::Else: {
+            NodePrinter node_printer("ElseStatement", printer);
+            node_printer.field("statement", NodeRef(*this, else_statement(node).statement));
+            break;
+        }
+        case NodeKind::Uniform: {
+            auto decl = uniform_decl(node);
+            NodePrinter node_printer("UniformDecl", printer);
+            node_printer.field("var_decl", NodeRef(*this, decl.var_decl));
+            node_printer.field("frequency", update_frequency_to_string(decl.frequency));
+            break;
+        }
+        case NodeKind::Struct: {
+            auto decl = struct_decl(node);
+            NodePrinter node_printer("StructDecl", printer);
+            node_printer.field("name", std::string(printer.name_of(decl.name.symbol)));
+            node_printer.name("fields");
+
+            ArrayPrinter array(decl.fields.size(), printer);
+            for(NodeId field: decl.fields) {
+                array.print_item(NodeRef(*this, field));
+            }
+            break;
+        }
     }
 }
-ElseStatement::ElseStatement(std::unique_ptr<Statement> statement) {
-    this->statement = std::move(statement);
-}
-StatementKind ElseStatement::kind() const {
-    return StatementKind::Else;
-}
-void ElseStatement::print(ASTPrinter& printer) const {
-    NodePrinter node("ElseStatement", printer);
-    node.field("statement", statement.get());
+
+NodeRef::NodeRef(const AST& ast, NodeId node): ast(ast) {
+    this->node = node;
 }
-AST::AST(std::vector<std::unique_ptr<Statement>>& statements) {
-    this->statements = std::move(statements);
+void NodeRef::print(ASTPrinter& printer) const {
+    ast.print_node(printer, node);
 }
-void AST::print(ASTPrinter &printer) const {
-    ArrayPrinter array(statements.size(), printer);
-
-    for(size_t i = 0; i < statements.size(); i++) {
-        array.print_item(statements[i].get());
-    }
 }
-}
\ No newline at end of file
@@ -4,9 +4,12 @@
 #include <iostream>
 
 namespace HKSL {
-ASTPrinter::ASTPrinter() {
+ASTPrinter::ASTPrinter(const SymbolInterner& _symbols): symbols(_symbols) {
     indent = 0;
 }
+std::string_view ASTPrinter::name_of(Symbol symbol) const {
+    return symbols.str(symbol);
+}
 void ASTPrinter::increase_depth() {
     indent++;
 }
@@ -51,8 +54,8 @@ NodePrinter& NodePrinter::name(const std::string& name) {
 
     return *this;
 }
-NodePrinter& NodePrinter::value(const ASTPrint* node) {
-    node->print(printer);
+NodePrinter& NodePrinter::value(const ASTPrint& node) {
+    node.print(printer);
     printer.println();
 
     return *this;
@@ -62,9 +65,9 @@ NodePrinter& NodePrinter::field(const std::string &name, const std::string &valu
 
     return *this;
 }
-NodePrinter& NodePrinter::field(const std::string &name, const ASTPrint* value) {
+NodePrinter& NodePrinter::field(const std::string &name, const ASTPrint& value) {
     printer.print_with_indent(std::format("{}: ", name));
-    value->print(printer);
+    value.print(printer);
     printer.println();
     return *this;
 }
@@ -79,9 +82,9 @@ ArrayPrinter::~ArrayPrinter() {
     printer.decrease_depth();
     printer.println_with_indent("]");
 }
-void ArrayPrinter::print_item(const ASTPrint* item) {
+void ArrayPrinter::print_item(const ASTPrint& item) {
     printer.print_with_indent("");
-    item->print(printer);
+    item.print(printer);
     
     assert(i < n);
 
@@ -2,219 +2,434 @@
 #include <__format/format_functions.h>
 #include <format>
 #include <cassert>
+#include <iterator>
+#include <utility>
 
 namespace HKSL {
 
-Scope::Scope(ScopeKind _kind): kind(_kind)  {
+SymbolTable::SymbolTable() {
+    this->visible_from = 1;
 }
-bool Scope::is_block() const {
-    return kind == ScopeKind::Block;
+uint32_t SymbolTable::head(const std::vector<uint32_t>& heads, Symbol name) const {
+    return name.id < heads.size() ? heads[name.id] : NO_BINDING;
 }
-bool Scope::is_function() const {
-    return kind == ScopeKind::Function;
+uint32_t& SymbolTable::head(std::vector<uint32_t>& heads, Symbol name) {
+    if(name.id >= heads.size()) {
+        heads.resize(name.id + 1, NO_BINDING);
+    }
+    return heads[name.id];
+}
+uint32_t SymbolTable::depth() const {
+    return scopes.size() - 1;
 }
-bool Scope::is_global() const {
-    return kind == ScopeKind::Global;
+void SymbolTable::push_scope(ScopeKind kind) {
+    scopes.push_back(ScopeMark {
+        .kind = kind,
+        .first_variable = (uint32_t) variables.size(),
+        .first_function = (uint32_t) functions.size(),
+        .visible_from = visible_from,
+    });
+    if(kind == ScopeKind::Function) {
+        visible_from = depth();
+    }
 }
-VariableData* Scope::push_var_decl(const VarDecl* var) {
-    variables[var->name.name] = VariableData {
-        .decl = var,
-        .span = var->name.span,
+void SymbolTable::pop_scope() {
+    const ScopeMark& scope = scopes.back();
+    while(variables.size() > scope.first_variable) {
+        variable_heads[variables.back().name.id] = variables.back().shadowed;
+        variables.pop_back();
+    }
+    while(functions.size() > scope.first_function) {
+        function_heads[functions.back().name.id] = functions.back().shadowed;
+        functions.pop_back();
+    }
+    visible_from = scope.visible_from;
+    scopes.pop_back();
+}
+ScopeKind SymbolTable::innermost_kind() const {
+    return scopes.back().kind;
+}
+VariableData* SymbolTable::push_variable(NodeId decl, const Identifier& name) {
+    uint32_t& chain = head(variable_heads, name.symbol);
+    auto data = VariableData {
+        .decl = decl,
+        .span = name.span,
         .initialized = false,
     };
+    // Declaring a name twice in one scope replaces the earlier binding
+    if(chain != NO_BINDING && variables[chain].depth == depth()) {
+        variables[chain].data = data;
+        return &variables[chain].data;
+    }
+    variables.push_back(VariableBinding {
+        .name = name.symbol,
+        .depth = depth(),
+        .shadowed = chain,
+        .data = data,
+    });
+    chain = variables.size() - 1;
 
-    return &variables[var->name.name];
-}
-void Scope::push_function(const Function* func) {
-    functions[func->m_name.name] = func;
+    return &variables.back().data;
 }
-bool Scope::var_exists(const std::string& name) {
-    return find_var_decl(name) != nullptr;
-}
-VariableData* Scope::find_var_decl(const std::string& name) {
-    auto it = variables.find(name);
-    if(it == variables.end()) {
+VariableData* SymbolTable::find_variable(Symbol name) {
+    // Bindings further down the chain are in outer scopes, so if the
+    // innermost one is out of reach all of them are
+    uint32_t binding = head(std::as_const(variable_heads), name);
+    if(binding == NO_BINDING || variables[binding].depth < visible_from) {
         return nullptr;
     }
 
-    return &it->second;
+    return &variables[binding].data;
 }
-const Function* Scope::find_func_decl(const std::string& name) {
-    auto it = functions.find(name);
-    if(it == functions.end()) {
-        return nullptr;
+std::span<const SymbolTable::VariableBinding> SymbolTable::innermost_variables() const {
+    return std::span(variables).subspan(scopes.back().first_variable);
+}
+void SymbolTable::push_uniform(NodeId var_decl, Symbol name) {
+    if(name.id >= uniforms.size()) {
+        uniforms.resize(name.id + 1, NO_NODE);
+    }
+    uniforms[name.id] = var_decl;
+}
+NodeId SymbolTable::find_uniform(Symbol name) const {
+    return name.id < uniforms.size() ? uniforms[name.id] : NO_NODE;
+}
+void SymbolTable::push_function(NodeId func, Symbol name) {
+    uint32_t& chain = head(function_heads, name);
+    functions.push_back(FunctionBinding {
+        .name = name,
+        .depth = depth(),
+        .shadowed = chain,
+        .decl = func,
+    });
+    chain = functions.size() - 1;
+}
+NodeId SymbolTable::find_function(Symbol name) const {
+    uint32_t binding = head(function_heads, name);
+    if(binding == NO_BINDING) {
+        return NO_NODE;
     }
 
-    return it->second;
+    return functions[binding].decl;
 }
-void Scope::for_each_var(std::function<void (const std::string &, const VariableData &)> fn) const {
-    for(const auto& [name, data]: variables) {
-        fn(name, data);
+NodeId SymbolTable::find_innermost_function(Symbol name) const {
+    uint32_t binding = head(function_heads, name);
+    if(binding == NO_BINDING || functions[binding].depth != depth()) {
+        return NO_NODE;
     }
+
+    return functions[binding].decl;
 }
-bool SemanticsVisitor::run() {
-    visit(context.get_ast());
-    return context.is_success();
+bool SemanticsVisitor::run(ThreadPool& pool) {
+    fused = false;
+    return check(pool);
 }
-SemanticsVisitor::SemanticsVisitor(CompilationContext& _context): context(_context) {
-    scope_stack.push_back(Scope(ScopeKind::Global));
+bool SemanticsVisitor::run_fused(ThreadPool& pool) {
+    fused = true;
+    return check(pool);
 }
-void SemanticsVisitor::visit(AST& ast) {
-    Visitor::visit(ast);
+bool SemanticsVisitor::check(ThreadPool& pool) {
+    AST& ast = context.get_ast();
+    set_ast(ast);
+    auto statements = ast.top_level();
+    // Errors of every top level statement, merged in source order
+    std::vector<std::vector<std::string>> errors(statements.size());
+    std::vector<std::vector<std::string>> type_errors(statements.size());
+    std::vector<size_t> functions;
+
+    // Every function body can call any top level function and read any
+    // uniform, and the global scope stays read-only while the bodies are
+    // checked
+    for(size_t i = 0; i < statements.size(); i++) {
+        if(ast.kind(statements[i]) == NodeKind::Function) {
+            ErrorBuffer buffer(context);
+            if(declare_function(statements[i], ast.function(statements[i]))) {
+                functions.push_back(i);
+            }
+            errors[i] = std::move(buffer.errors);
+        } else if(ast.kind(statements[i]) == NodeKind::Uniform) {
+            ErrorBuffer buffer(context);
+            declare_uniform(statements[i], ast.uniform_decl(statements[i]));
+            errors[i] = std::move(buffer.errors);
+        }
+    }
+    for(size_t i = 0; i < statements.size(); i++) {
+        NodeKind kind = ast.kind(statements[i]);
+        if(kind != NodeKind::Function && kind != NodeKind::Uniform) {
+            ErrorBuffer buffer(context);
+            statement_errors = &buffer;
+            statement_type_errors = &type_errors[i];
+            visit_statement(statements[i]);
+            errors[i] = std::move(buffer.errors);
+        }
+    }
+
+    const SymbolTable& globals = table;
+    // Runs of consecutive functions, a few per thread, each checked by one visitor
+    size_t n_batches = std::min(functions.size(), pool.size() * 8);
+    pool.parallel_for(n_batches, [&] (size_t batch) {
+        SemanticsVisitor body(context, globals);
+        body.set_ast(ast);
+        body.fused = fused;
+        size_t begin = functions.size() * batch / n_batches;
+        size_t end = functions.size() * (batch + 1) / n_batches;
+        for(size_t j = begin; j < end; j++) {
+            size_t i = functions[j];
+            ErrorBuffer buffer(context);
+            body.statement_errors = &buffer;
+            body.statement_type_errors = &type_errors[i];
+            body.check_function_body(statements[i], ast.function(statements[i]));
+            std::move(buffer.errors.begin(), buffer.errors.end(), std::back_inserter(errors[i]));
+        }
+    });
+
+    for(auto& statement_errors: errors) {
+        context.append_errors(std::move(statement_errors));
+    }
     // Check for unitialized variables in the global scope
     check_uninitialized();
+
+    // A separate inference pass wouldn't run after name errors
+    if(fused && context.is_success()) {
+        for(auto& statement_errors: type_errors) {
+            context.append_errors(std::move(statement_errors));
+        }
+    }
+
+    return context.is_success();
 }
-void SemanticsVisitor::visit_function(Function* function) {
-    if(current_scope().find_func_decl(function->m_name.name)) {
-        context.error(function->m_name.span, std::format("Redefinition of function {}", function->m_name.span.to_string()));
+SemanticsVisitor::SemanticsVisitor(CompilationContext& _context): context(_context), types(_context) {
+    this->globals = nullptr;
+    this->fused = false;
+    table.push_scope(ScopeKind::Global);
+}
+SemanticsVisitor::SemanticsVisitor(CompilationContext& _context, const SymbolTable& globals): context(_context), types(_context) {
+    this->globals = &globals;
+    this->fused = false;
+    table.push_scope(ScopeKind::Global);
+}
+void SemanticsVisitor::visit_function(NodeId node, const Function& function) {
+    if(declare_function(node, function)) {
+        check_function_body(node, function);
+    }
+}
+bool SemanticsVisitor::declare_function(NodeId node, const Function& function) {
+    if(table.find_innermost_function(function.name.symbol) != NO_NODE) {
+        context.error(function.name.span, std::format("Redefinition of function {}", context.locate(function.name.span).to_string()));
+        return false;
+    }
+    table.push_function(node, function.name.symbol);
+    return true;
+}
+void SemanticsVisitor::declare_uniform(NodeId, const UniformDecl& uniform) {
+    auto var_decl = ast().var_decl(uniform.var_decl);
+    auto name = context.symbols().str(var_decl.name.symbol);
+    if(table.find_uniform(var_decl.name.symbol) != NO_NODE) {
+        context.error(var_decl.name.span, std::format("Redefinition of uniform {}", name));
         return;
     }
-    push_function(function);
-    for(const auto& decl: function->m_args) {
-        auto var = current_scope().push_var_decl(&decl);
+    if(var_decl.type->kind() == TypeKind::Void) {
+        context.error(var_decl.name.span, std::format("Uniform {} can't be void", name));
+    }
+    table.push_uniform(uniform.var_decl, var_decl.name.symbol);
+}
+void SemanticsVisitor::check_function_body(NodeId, const Function& function) {
+    outer_fn = function;
+    push_function();
+    for(NodeId arg: function.args) {
+        auto var = table.push_variable(arg, ast().var_decl(arg).name);
         var->initialized = true;
     }
-    Visitor::visit_block_statement(function->m_block.get());
-    if(function->m_return_type) {
-        Visitor::visit_type(function->m_return_type);
+    Visitor::visit_block_statement(function.block, ast().block_statement(function.block));
+    if(function.return_type) {
+        Visitor::visit_type(function.return_type);
     }
     pop_function();
+    outer_fn = std::nullopt;
+}
+void SemanticsVisitor::visit_expr_statement(NodeId, const ExprStatement& expr) {
+    visit_expr(expr.expr);
+    infer_types(expr.expr);
+}
+void SemanticsVisitor::visit_if_statement(NodeId, const IfStatement& if_statement) {
+    visit_expr(if_statement.condition);
+    infer_types(if_statement.condition);
+    visit_block_statement(if_statement.then_block, ast().block_statement(if_statement.then_block));
+    if(if_statement.else_stmt != NO_NODE) {
+        visit_statement(if_statement.else_stmt);
+    }
 }
-void SemanticsVisitor::visit_call_expr(CallExpr* call_expr) {
-    auto function_decl = find_func_decl(call_expr->fn_name.name);
-    if(!function_decl) {
-        Span current_span = call_expr->fn_name.span;
+void SemanticsVisitor::visit_return_statement(NodeId node, const ReturnStatement& ret) {
+    Visitor::visit_return_statement(node, ret);
+    infer_return_type(ret);
+}
+void SemanticsVisitor::visit_struct_decl(NodeId, const StructDecl& struct_decl) {
+    if(struct_decl.fields.empty()) {
+        context.error(struct_decl.name.span, std::format("Struct {} has no fields", context.symbols().str(struct_decl.name.symbol)));
+    }
+    for(size_t i = 0; i < struct_decl.fields.size(); i++) {
+        auto field = ast().var_decl(struct_decl.fields[i]);
+        if(field.type->kind() == TypeKind::Void) {
+            context.error(field.name.span, std::format("Field {} can't be void", context.symbols().str(field.name.symbol)));
+        }
+        for(size_t j = 0; j < i; j++) {
+            if(ast().var_decl(struct_decl.fields[j]).name.symbol == field.name.symbol) {
+                context.error(field.name.span, std::format("Redefinition of field {}", context.symbols().str(field.name.symbol)));
+                break;
+            }
+        }
+    }
+}
+void SemanticsVisitor::visit_call_expr(NodeId node, const CallExpr& call_expr) {
+    auto function_decl = find_func_decl(call_expr.fn_name.symbol);
+    if(function_decl == NO_NODE) {
+        // Vector types double as their constructors, left unresolved
+        Type* type = context.type_registry().get(call_expr.fn_name.symbol);
+        if(type && type->kind() == TypeKind::Vector) {
+            Visitor::visit_call_expr(node, call_expr);
+            return;
+        }
 
-        context.error(current_span, std::format("Use of undeclared function {}", call_expr->fn_name.name));
+        Span current_span = call_expr.fn_name.span;
+
+        context.error(current_span, std::format("Use of undeclared function {}", context.symbols().str(call_expr.fn_name.symbol)));
         return;
     }
 
-    context.symbol_resolver().register_function_ref(call_expr, function_decl);
+    context.symbol_resolver().register_function_ref(node, function_decl);
 
-    Visitor::visit_call_expr(call_expr);
+    Visitor::visit_call_expr(node, call_expr);
 }
-void SemanticsVisitor::visit_block_statement(BlockStatement* block) {
+void SemanticsVisitor::visit_block_statement(NodeId node, const BlockStatement& block) {
     push_block();
-    Visitor::visit_block_statement(block);
+    Visitor::visit_block_statement(node, block);
     pop_block();
 }
-void SemanticsVisitor::visit_var_decl(VarDecl* var_decl) {
-    auto& var = var_decl->name;
+void SemanticsVisitor::visit_var_decl(NodeId node, const VarDecl& var_decl) {
+    auto& var = var_decl.name;
     // Variable names must be unique in a scope; no shadowing
-    if(find_var_decl(var.name)) {
+    if(find_var_decl(var.symbol)) {
         Span current_span = var.span;
-        context.error(current_span, std::format("Redefinition of {}", var.name));
+        context.error(current_span, std::format("Redefinition of {}", context.symbols().str(var.symbol)));
         return;
     } else {
-        current_scope().push_var_decl(var_decl);
+        table.push_variable(node, var);
     }
 
-    Visitor::visit_var_decl(var_decl);
+    Visitor::visit_var_decl(node, var_decl);
 }
-void SemanticsVisitor::visit_let_expr(LetExpr* let_expr) {
-    Visitor::visit_let_expr(let_expr);
+void SemanticsVisitor::visit_let_expr(NodeId node, const LetExpr& let_expr) {
+    Visitor::visit_let_expr(node, let_expr);
 
-    auto decl = find_var_decl(let_expr->var_decl->name.name);
+    auto decl = find_var_decl(ast().var_decl(let_expr.var_decl).name.symbol);
     
-    if(decl && let_expr->rhs) {
+    if(decl && let_expr.rhs != NO_NODE) {
         decl->initialized = true;
     }
 }
-void SemanticsVisitor::visit_assignment_expr(AssignmentExpr* assignment_expr) {
-    assert(assignment_expr->lhs->kind() == ExprKind::Variable);
+void SemanticsVisitor::visit_assignment_expr(NodeId, const AssignmentExpr& assignment_expr) {
+    assert(ast().kind(assignment_expr.lhs) == NodeKind::Variable);
 
-    const Variable* assignment_target = (Variable*) assignment_expr->lhs.get();
+    auto target = ast().variable(assignment_expr.lhs).name;
+    if(!find_var_decl(target.symbol) && find_uniform(target.symbol) != NO_NODE) {
+        context.error(target.span, std::format("Cannot assign to uniform {}", context.symbols().str(target.symbol)));
+    }
 
-    auto variable_data = check_variable(assignment_target);
+    auto variable_data = check_variable(assignment_expr.lhs, ast().variable(assignment_expr.lhs));
 
     if(variable_data) {
         variable_data->initialized = true;
     }
 
-    visit_expr(assignment_expr->rhs.get());
+    visit_expr(assignment_expr.rhs);
 }
-void SemanticsVisitor::visit_variable(Variable* variable) {
-    check_variable(variable);
-    Visitor::visit_variable(variable);
+void SemanticsVisitor::visit_variable(NodeId node, const Variable& variable) {
+    check_variable(node, variable);
+    Visitor::visit_variable(node, variable);
 }
-VariableData* SemanticsVisitor::check_variable(const Variable* variable) {
-    auto* prev_var = find_var_decl(variable->name.name);
+VariableData* SemanticsVisitor::check_variable(NodeId node, const Variable& variable) {
+    auto* prev_var = find_var_decl(variable.name.symbol);
+    // Locals hide uniforms of the same name
+    NodeId uniform = prev_var ? NO_NODE : find_uniform(variable.name.symbol);
+    if(uniform != NO_NODE) {
+        context.symbol_resolver().register_variable_ref(node, uniform);
+        return nullptr;
+    }
     if(!prev_var) {
-        Span current_span = variable->name.span;
-        context.error(current_span, std::format("Use of undeclared variable {}", variable->name.name));
+        Span current_span = variable.name.span;
+        context.error(current_span, std::format("Use of undeclared variable {}", context.symbols().str(variable.name.symbol)));
         return nullptr;
     }
 
-    context.symbol_resolver().register_variable_ref(variable, prev_var->decl);
+    context.symbol_resolver().register_variable_ref(node, prev_var->decl);
     return prev_var;
 }
-Scope& SemanticsVisitor::current_scope() {
-    return scope_stack.back();
-}
 void SemanticsVisitor::push_block() {
-    scope_stack.push_back(Scope(ScopeKind::Block));
+    table.push_scope(ScopeKind::Block);
 }
 void SemanticsVisitor::pop_block() {
     check_uninitialized();
 
-    assert(scope_stack.back().is_block());
-    scope_stack.pop_back();
-
+    assert(table.innermost_kind() == ScopeKind::Block);
+    table.pop_scope();
 }
-void SemanticsVisitor::push_function(const Function* function) {
-    current_scope().push_function(function);
-    scope_stack.push_back(Scope(ScopeKind::Function));
+void SemanticsVisitor::push_function() {
+    table.push_scope(ScopeKind::Function);
 }
 void SemanticsVisitor::pop_function() {
     check_uninitialized();
 
-    assert(scope_stack.back().is_function());
-    scope_stack.pop_back();
+    assert(table.innermost_kind() == ScopeKind::Function);
+    table.pop_scope();
 }
-bool SemanticsVisitor::var_exists(const std::string& name) {
+bool SemanticsVisitor::var_exists(Symbol name) {
     return find_var_decl(name) != nullptr;
 }
-VariableData* SemanticsVisitor::find_var_decl(const std::string& name) {
-    int64_t index = scope_stack.size() - 1;
-    while(index >= 1 /*Global scope is at index 0*/) {
-        auto& top = scope_stack[index];
-
-        auto* matching_var = top.find_var_decl(name);
-
-        if(matching_var) {
-            return matching_var;
-        }
-
-        if(top.is_function()) {
-            break;
-        }
-
-        index--;
+VariableData* SemanticsVisitor::find_var_decl(Symbol name) {
+    return table.find_variable(name);
+}
+NodeId SemanticsVisitor::find_func_decl(Symbol name) {
+    NodeId function = table.find_function(name);
+    if(function == NO_NODE && globals) {
+        return globals->find_function(name);
     }
 
-    return nullptr;
+    return function;
 }
-const Function* SemanticsVisitor::find_func_decl(const std::string& name) {
-    int64_t index = scope_stack.size() - 1;
-    while(index >= 0) {
-        auto& top = scope_stack[index];
-
-        auto matching_func = top.find_func_decl(name);
-
-        if(matching_func) {
-            return matching_func;
-        }
-
-        index--;
+NodeId SemanticsVisitor::find_uniform(Symbol name) {
+    NodeId uniform = table.find_uniform(name);
+    if(uniform == NO_NODE && globals) {
+        return globals->find_uniform(name);
     }
 
-    return nullptr;
+    return uniform;
 }
 void SemanticsVisitor::check_uninitialized() {
-    current_scope().for_each_var([this](const std::string& name, const VariableData& data){
-            if(!data.initialized) {
-                context.error(data.span, std::format("Variable {} has not been initialized", name));
-            }
-    });
+    for(const auto& var: table.innermost_variables()) {
+        if(!var.data.initialized) {
+            context.error(var.data.span, std::format("Variable {} has not been initialized", context.symbols().str(var.name)));
+        }
+    }
+}
+bool SemanticsVisitor::can_infer_types() {
+    // Unresolved names leave nothing to type, and the type errors would be
+    // dropped anyway
+    return fused && statement_errors->errors.empty();
+}
+void SemanticsVisitor::infer_types(NodeId expr) {
+    if(!can_infer_types()) {
+        return;
+    }
+    ErrorBuffer buffer(context);
+    types.infer(ast(), expr);
+    std::move(buffer.errors.begin(), buffer.errors.end(), std::back_inserter(*statement_type_errors));
+}
+void SemanticsVisitor::infer_return_type(const ReturnStatement& ret) {
+    if(!can_infer_types()) {
+        return;
+    }
+    assert(outer_fn);
+    ErrorBuffer buffer(context);
+    types.infer_return(ast(), *outer_fn, ret);
+    std::move(buffer.errors.begin(), buffer.errors.end(), std::back_inserter(*statement_type_errors));
 }
 }
\ No newline at end of file
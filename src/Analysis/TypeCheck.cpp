@@ -6,49 +6,86 @@
 #include <format>
 
 namespace HKSL {
-Type* TypeInferenceVisitor::type_of(const Expr *expr) {
-  auto ty = type_of_expr(expr);
-  return ty;
-}
-Type* TypeInferenceVisitor::type_of_expr(const Expr *expr) {
-  switch (expr->kind()) {
-  case ExprKind::BinExpr:
-    return type_of_binary_expr((const BinExpr *)expr);
-  case ExprKind::UnaryExpr:
-    return type_of_unary_expr((const UnaryExpr *)expr);
-  case ExprKind::NumberConstant:
-    return type_of_number_constant((const NumberConstant *)expr);
-  case ExprKind::Variable:
-    return type_of_variable((const Variable *)expr);
-  case ExprKind::VarDecl:
-    return type_of_var_decl((const VarDecl *)expr);
-  case ExprKind::CallExpr:
-    return type_of_call_expr((const CallExpr *)expr);
-  case ExprKind::AssignmentExpr:
-    return type_of_assignment_expr((const AssignmentExpr *)expr);
-  case ExprKind::LetExpr:
-    return type_of_let_expr((const LetExpr *)expr);
+Type* TypeInferenceVisitor::type_of(NodeId expr) {
+  // Ids are post-order and every subtree was parsed in one go, so the
+  // subtree of `expr` is the id range from its first parsed leaf up to
+  // `expr`. Walking it in order types every child before its parent, and
+  // each node exactly once.
+  NodeId first = expr;
+  NodeId child;
+  while((child = first_child(first)) != NO_NODE) {
+    first = child;
   }
 
-  HKSL_UNREACHABLE();
-}
-Type* TypeInferenceVisitor::type_of_variable(const Variable *var) {
-  auto var_decl = context.symbol_resolver().get_var_decl(var);
+  for(NodeId node = first; node <= expr; node++) {
+    Type* type = type_of_expr(node);
+    if(type) {
+      context.type_resolver().register_expr(node, type);
+    }
+  }
 
-  if(!var_decl->type) {
-    return nullptr;
+  return inferred(expr);
+}
+NodeId TypeInferenceVisitor::first_child(NodeId expr) {
+  AST& ast = this->ast();
+  switch (ast.kind(expr)) {
+  case NodeKind::BinExpr:
+    return ast.bin_expr(expr).left;
+  case NodeKind::UnaryExpr:
+    return ast.unary_expr(expr).expr;
+  case NodeKind::CallExpr: {
+    auto args = ast.call_expr(expr).args;
+    return args.empty() ? NO_NODE : args.front();
+  }
+  case NodeKind::AssignmentExpr:
+    return ast.assignment_expr(expr).lhs;
+  case NodeKind::LetExpr:
+    return ast.let_expr(expr).var_decl;
+  default:
+    return NO_NODE;
+  }
+}
+Type* TypeInferenceVisitor::inferred(NodeId expr) {
+  return context.type_resolver().type_of(expr);
+}
+Type* TypeInferenceVisitor::type_of_expr(NodeId expr) {
+  typed++;
+  AST& ast = this->ast();
+  switch (ast.kind(expr)) {
+  case NodeKind::BinExpr:
+    return type_of_binary_expr(expr, ast.bin_expr(expr));
+  case NodeKind::UnaryExpr:
+    return type_of_unary_expr(expr, ast.unary_expr(expr));
+  case NodeKind::NumberConstant:
+    return type_of_number_constant(expr, ast.number_constant(expr));
+  case NodeKind::Variable:
+    return type_of_variable(expr, ast.variable(expr));
+  case NodeKind::VarDecl:
+    return type_of_var_decl(expr, ast.var_decl(expr));
+  case NodeKind::CallExpr:
+    return type_of_call_expr(expr, ast.call_expr(expr));
+  case NodeKind::AssignmentExpr:
+    return type_of_assignment_expr(expr, ast.assignment_expr(expr));
+  case NodeKind::LetExpr:
+    return type_of_let_expr(expr, ast.let_expr(expr));
+  default:
+    break;
   }
 
-  auto type = *var_decl->type;
+  HKSL_UNREACHABLE();
+}
+Type* TypeInferenceVisitor::type_of_variable(NodeId node, const Variable&) {
+  auto var_decl = context.symbol_resolver().get_var_decl(node);
 
-  return type;
+  return ast().var_decl(var_decl).type;
 }
-Type* TypeInferenceVisitor::type_of_let_expr(const LetExpr *expr) {
+Type* TypeInferenceVisitor::type_of_let_expr(NodeId, const LetExpr& expr) {
+  infer_let(expr);
   return context.type_registry().get_void();
 }
-Type* TypeInferenceVisitor::type_of_assignment_expr(const AssignmentExpr *expr) {
-  Type* type_left = type_of_expr(expr->lhs.get());
-  Type* type_right = type_of_expr(expr->rhs.get());
+Type* TypeInferenceVisitor::type_of_assignment_expr(NodeId, const AssignmentExpr& expr) {
+  Type* type_left = inferred(expr.lhs);
+  Type* type_right = inferred(expr.rhs);
 
   if (!type_left) {
     return nullptr;
@@ -58,7 +95,7 @@ Type* TypeInferenceVisitor::type_of_assignment_expr(const AssignmentExpr *expr)
   }
 
   if (type_left != type_right) {
-    context.error(expr->eq_token.span, std::format("Types of left and right side of assignment don't match, "
+    context.error(expr.eq_span, std::format("Types of left and right side of assignment don't match, "
                       "left: {}, right: {}",
                       type_left->name(), type_right->name()));
     return nullptr;
@@ -66,48 +103,78 @@ Type* TypeInferenceVisitor::type_of_assignment_expr(const AssignmentExpr *expr)
 
   return type_left;
 }
-Type* TypeInferenceVisitor::type_of_call_expr(const CallExpr *expr) { 
-  auto function = context.symbol_resolver().get_function(expr);
-  auto return_type = function->m_return_type;
+Type* TypeInferenceVisitor::type_of_call_expr(NodeId node, const CallExpr& expr) { 
+  NodeId decl = context.symbol_resolver().get_function(node);
+  if(decl == NO_NODE) {
+    return type_of_constructor(node, expr);
+  }
+  auto function = ast().function(decl);
+  auto return_type = function.return_type;
 
-  if(function->m_args.size() != expr->args.size()) {
-    context.error(function->m_name.span, std::format("Incorrect no. of args of function call, provided {}, expected {}", expr->args.size(), function->m_args.size()));
+  if(function.args.size() != expr.args.size()) {
+    context.error(function.name.span, std::format("Incorrect no. of args of function call, provided {}, expected {}", expr.args.size(), function.args.size()));
+    return return_type;
   }
-  for(size_t i = 0; i < function->m_args.size(); i++) {
-    auto parameter_type = *function->m_args[i].type;
-    auto arg_type = type_of_expr(expr->args[i].get());
+  for(size_t i = 0; i < function.args.size(); i++) {
+    auto parameter_type = ast().var_decl(function.args[i]).type;
+    auto arg_type = inferred(expr.args[i]);
     if(!arg_type) {
       break;
     }
     if(parameter_type != arg_type) {
-      context.error(expr->fn_name.span, std::format("Expected function argument at index {} to be: {}, got: {}", i, arg_type->name(), parameter_type->name()));
+      context.error(expr.fn_name.span, std::format("Expected function argument at index {} to be: {}, got: {}", i, arg_type->name(), parameter_type->name()));
     }
   }
 
   return return_type;
 }
-Type* TypeInferenceVisitor::type_of_var_decl(const VarDecl *decl) {
+Type* TypeInferenceVisitor::type_of_constructor(NodeId, const CallExpr& expr) {
+  Type* type = context.type_registry().get(expr.fn_name.symbol);
+  assert(type && type->kind() == TypeKind::Vector);
+
+  uint32_t components = 0;
+  for(NodeId arg: expr.args) {
+    Type* arg_type = inferred(arg);
+    if(!arg_type) {
+      return nullptr;
+    }
+    bool is_value = arg_type->kind() == TypeKind::Scalar || arg_type->kind() == TypeKind::Vector;
+    if(!is_value || arg_type->scalar() != type->scalar()) {
+      context.error(expr.fn_name.span, std::format("Cannot construct {} from {}", type->name(), arg_type->name()));
+      return nullptr;
+    }
+    components += arg_type->desc().columns;
+  }
+
+  if(components != type->desc().columns) {
+    context.error(expr.fn_name.span, std::format("Constructor of {} takes {} components, got {}", type->name(), (uint32_t) type->desc().columns, components));
+    return nullptr;
+  }
+
+  return type;
+}
+Type* TypeInferenceVisitor::type_of_var_decl(NodeId, const VarDecl&) {
   return context.type_registry().get_void();
 }
-Type* TypeInferenceVisitor::type_of_unary_expr(const UnaryExpr *expr) {
-  assert(expr->op == UnaryOp::Negate);
+Type* TypeInferenceVisitor::type_of_unary_expr(NodeId, const UnaryExpr& expr) {
+  assert(expr.op == UnaryOp::Negate);
 
-  Type* type_inner = type_of_expr(expr->expr.get());
+  Type* type_inner = inferred(expr.expr);
 
   if (!type_inner) {
     return nullptr;
   }
 
   if (type_inner->kind() == TypeKind::Void) {
-    context.error(expr->op_token.span, "Cannot negate type void");
+    context.error(expr.op_span, "Cannot negate type void");
     return nullptr;
   }
 
   return type_inner;
 }
-Type* TypeInferenceVisitor::type_of_binary_expr(const BinExpr *expr) {
-  Type* type_left = type_of_expr(expr->left.get());
-  Type* type_right = type_of_expr(expr->right.get());
+Type* TypeInferenceVisitor::type_of_binary_expr(NodeId, const BinExpr& expr) {
+  Type* type_left = inferred(expr.left);
+  Type* type_right = inferred(expr.right);
 
   if (!type_left) {
     return nullptr;
@@ -120,31 +187,38 @@ Type* TypeInferenceVisitor::type_of_binary_expr(const BinExpr *expr) {
     auto message = std::format("Types of left and right side of binary "
                                "expression don't match, left: {}, right: {}",
                                type_left->name(), type_right->name());
-    context.error(expr->op_token.span, message);
+    context.error(expr.op_span, message);
     return nullptr;
   }
 
   return type_left;
 }
 
-Type* TypeInferenceVisitor::type_of_number_constant(const NumberConstant *expr) {
+Type* TypeInferenceVisitor::type_of_number_constant(NodeId, const NumberConstant& expr) {
+  if (expr.number_literal.kind == NumberKind::Half) {
+    return context.type_registry().get_half();
+  }
   return context.type_registry().get_float();
 }
 
 TypeInferenceVisitor::TypeInferenceVisitor(CompilationContext& _context): context(_context) {}
 
-void TypeInferenceVisitor::visit_function(Function* function) {
+void TypeInferenceVisitor::visit_function(NodeId node, const Function& function) {
   outer_fn = function;
-  Visitor::visit_function(function);
+  Visitor::visit_function(node, function);
   outer_fn = std::nullopt;
 }
-void TypeInferenceVisitor::visit_return_statement(ReturnStatement* ret) {
+void TypeInferenceVisitor::visit_return_statement(NodeId, const ReturnStatement& ret) {
   assert(outer_fn);
-  auto type_ret = type_of(ret->value->get());
+  check_return(*outer_fn, ret);
+}
+void TypeInferenceVisitor::check_return(const Function& function, const ReturnStatement& ret) {
+  // A bare return returns void
+  Type* type_ret = ret.value != NO_NODE ? type_of(ret.value) : context.type_registry().get_void();
   if(!type_ret) {
     return;
   }
-  auto fn_ret_type = (*outer_fn)->m_return_type;
+  auto fn_ret_type = function.return_type;
   Type* type_fn_ret;
   if(!fn_ret_type) {
     type_fn_ret = context.type_registry().get_void();
@@ -153,57 +227,73 @@ void TypeInferenceVisitor::visit_return_statement(ReturnStatement* ret) {
   }
 
   if(type_ret != type_fn_ret) {
-    context.error(ret->ret_token.span, std::format("Incorrect return type, expected: {}, got: {}", type_fn_ret->name(), type_ret->name()));
+    context.error(ret.ret_span, std::format("Incorrect return type, expected: {}, got: {}", type_fn_ret->name(), type_ret->name()));
   }
 }
 
-void TypeInferenceVisitor::visit_expr(Expr* expr) {
-  Visitor::visit_expr(expr);
-
-  auto type = type_of_expr(expr);
-
-  if(type) {
-    context.type_resolver().register_expr(expr, type);
-  }
-
+Type* TypeInferenceVisitor::infer(AST& ast, NodeId expr) {
+  set_ast(ast);
+  return type_of(expr);
+}
+void TypeInferenceVisitor::infer_return(AST& ast, const Function& function, const ReturnStatement& ret) {
+  set_ast(ast);
+  check_return(function, ret);
+}
+size_t TypeInferenceVisitor::typed_nodes() const {
+  return typed;
 }
-void TypeInferenceVisitor::visit_let_expr(LetExpr* expr) {
-    std::optional<Type*> type_left = expr->var_decl->type;
-    std::optional<Type*> type_right = std::nullopt;
+void TypeInferenceVisitor::visit_expr(NodeId expr) {
+  type_of(expr);
+}
+void TypeInferenceVisitor::infer_let(const LetExpr& expr) {
+    auto var_decl = ast().var_decl(expr.var_decl);
+    Type* type_left = var_decl.type;
+    Type* type_right = nullptr;
 
-    if(expr->rhs) {
-      type_right = type_of(expr->rhs->get());
+    if(expr.rhs != NO_NODE) {
+      type_right = inferred(expr.rhs);
     }
 
     if(!type_left && !type_right) {
         // 1. There is on type explicitly provided AND
         // 2. We couldn't infer type on the right :(
-        context.error(expr->var_decl->name.span, std::format("Couldn't infer type for variable {}, please specify its manually", expr->var_decl->name.name));
+        context.error(var_decl.name.span, std::format("Couldn't infer type for variable {}, please specify its manually", context.symbols().str(var_decl.name.symbol)));
         return;
     }
 
-    if(!type_left && type_right) {
+    if(!type_left) {
       type_left = type_right;
-      expr->var_decl->type =  type_right;
+      ast().set_var_type(expr.var_decl, type_right);
       return;
     }
 
-    if(type_left && type_right) {
+    if(type_right) {
       if(type_left != type_right) {
-        context.error(expr->var_decl->name.span, std::format("Type of left and right hand side of variable declation don't match, left: {}, right: {}", (*type_left)->name(), (*type_right)->name()));
+        context.error(var_decl.name.span, std::format("Type of left and right hand side of variable declation don't match, left: {}, right: {}", type_left->name(), type_right->name()));
       }
     }
-
-    if(expr->rhs) {
-      Visitor::visit_expr(expr->rhs->get());
-    }
 }
-bool TypeInferenceVisitor::run() {
+bool TypeInferenceVisitor::run(ThreadPool& pool) {
   // TypeExistsVisitor type_exists(context);
   // if(!type_exists.check_all_types_exists()) {
   //   return false;
   // }
-  visit(context.get_ast());
+  AST& ast = context.get_ast();
+  auto statements = ast.top_level();
+  // Errors of every top level statement, merged in source order
+  std::vector<std::vector<std::string>> errors(statements.size());
+
+  pool.parallel_for(statements.size(), [&] (size_t i) {
+    ErrorBuffer buffer(context);
+    TypeInferenceVisitor statement(context);
+    statement.set_ast(ast);
+    statement.visit_statement(statements[i]);
+    errors[i] = std::move(buffer.errors);
+  });
+
+  for(auto& statement_errors: errors) {
+    context.append_errors(std::move(statement_errors));
+  }
 
   return context.is_success();
 }
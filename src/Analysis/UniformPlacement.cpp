@@ -0,0 +1,152 @@
+#include <Analysis/UniformPlacement.h>
+#include <Util.h>
+#include <algorithm>
+#include <unordered_map>
+
+namespace HKSL {
+const char* block_kind_to_string(BlockKind kind) {
+    switch(kind) {
+        case BlockKind::PushConstant:
+            return "push_constant";
+        case BlockKind::UniformBuffer:
+            return "uniform_buffer";
+    }
+    HKSL_UNREACHABLE();
+}
+
+struct UniformUse {
+    NodeId decl;
+    UniformDecl uniform;
+    const Type* type;
+    uint32_t accesses;
+};
+
+// Lays out `uses` as one block. Members with the same layout are placed in
+// the order of `uses`.
+static UniformBlock make_block(CompilationContext& context, BlockKind kind, UpdateFrequency frequency, uint32_t binding, std::span<const UniformUse> uses, bool reorder_struct_fields) {
+    LayoutRule rule = kind == BlockKind::PushConstant ? LayoutRule::Std430 : LayoutRule::Std140;
+    std::vector<const Type*> types;
+    for(const auto& use: uses) {
+        types.push_back(use.type);
+    }
+    StructLayout layout = layout_block(context.type_registry(), types, rule, reorder_struct_fields);
+
+    UniformBlock block = {
+        .kind = kind,
+        .frequency = frequency,
+        .binding = binding,
+        .size = layout.size,
+        .members = {},
+    };
+    for(const auto& field: layout.fields) {
+        const UniformUse& use = uses[field.field];
+        auto var_decl = context.get_ast().var_decl(use.uniform.var_decl);
+        block.members.push_back(PlacedUniform {
+            .decl = use.decl,
+            .name = std::string(context.symbols().str(var_decl.name.symbol)),
+            .frequency = use.uniform.frequency,
+            .accesses = use.accesses,
+            .offset = field.offset,
+            .size = field.size,
+        });
+    }
+
+    return block;
+}
+
+std::vector<UniformBlock> place_uniforms(CompilationContext& context, uint32_t push_constant_budget, bool reorder_struct_fields) {
+    AST& ast = context.get_ast();
+    std::vector<UniformUse> uses;
+    // From the VarDecl of a uniform to its index in `uses`
+    std::unordered_map<NodeId, size_t> uniform_of;
+    for(NodeId statement: ast.top_level()) {
+        if(ast.kind(statement) == NodeKind::Uniform) {
+            auto uniform = ast.uniform_decl(statement);
+            uniform_of.emplace(uniform.var_decl, uses.size());
+            uses.push_back(UniformUse {
+                .decl = statement,
+                .uniform = uniform,
+                .type = ast.var_decl(uniform.var_decl).type,
+                .accesses = 0,
+            });
+        }
+    }
+    if(uses.empty()) {
+        return {};
+    }
+
+    // Every read is a Variable node resolved to the uniform's VarDecl
+    for(NodeId node = 0; node < ast.size(); node++) {
+        if(ast.kind(node) != NodeKind::Variable) {
+            continue;
+        }
+        auto it = uniform_of.find(context.symbol_resolver().get_var_decl(node));
+        if(it != uniform_of.end()) {
+            uses[it->second].accesses++;
+        }
+    }
+
+    // Most reads per byte first, ties go to the more often updated uniform
+    // since it gains the most from skipping a descriptor update
+    const TypeRegistry& registry = context.type_registry();
+    std::vector<size_t> candidates;
+    for(size_t i = 0; i < uses.size(); i++) {
+        if(uses[i].accesses > 0) {
+            candidates.push_back(i);
+        }
+    }
+    std::vector<uint32_t> sizes;
+    for(const auto& use: uses) {
+        sizes.push_back(layout_size_of(registry, use.type, LayoutRule::Std430, reorder_struct_fields));
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [&] (size_t a, size_t b) {
+        uint64_t score_a = (uint64_t) uses[a].accesses * sizes[b];
+        uint64_t score_b = (uint64_t) uses[b].accesses * sizes[a];
+        if(score_a != score_b) {
+            return score_a > score_b;
+        }
+        return uses[a].uniform.frequency > uses[b].uniform.frequency;
+    });
+
+    // Greedily take every candidate that still fits, a smaller one further
+    // down may fill the space a bigger one couldn't. The block is built from
+    // the same ranked list the budget was checked against.
+    std::vector<bool> pushed(uses.size(), false);
+    std::vector<UniformUse> push_members;
+    std::vector<const Type*> push_types;
+    for(size_t i: candidates) {
+        if(sizes[i] > push_constant_budget) {
+            continue;
+        }
+        push_types.push_back(uses[i].type);
+        if(layout_block(registry, push_types, LayoutRule::Std430, reorder_struct_fields).size <= push_constant_budget) {
+            pushed[i] = true;
+            push_members.push_back(uses[i]);
+        } else {
+            push_types.pop_back();
+        }
+    }
+
+    std::vector<UniformBlock> blocks;
+    if(!push_members.empty()) {
+        blocks.push_back(make_block(context, BlockKind::PushConstant, UpdateFrequency::Draw, 0, push_members, reorder_struct_fields));
+    }
+
+    std::vector<UniformUse> members;
+
+    uint32_t binding = 0;
+    for(auto frequency: {UpdateFrequency::Frame, UpdateFrequency::Material, UpdateFrequency::Draw}) {
+        members.clear();
+        for(size_t i = 0; i < uses.size(); i++) {
+            if(!pushed[i] && uses[i].uniform.frequency == frequency) {
+                members.push_back(uses[i]);
+            }
+        }
+        if(!members.empty()) {
+            blocks.push_back(make_block(context, BlockKind::UniformBuffer, frequency, binding++, members, reorder_struct_fields));
+        }
+    }
+
+    return blocks;
+}
+}
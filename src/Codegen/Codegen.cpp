@@ -0,0 +1,60 @@
+#include <Codegen.h>
+#include <MLIRGen.h>
+#include <LowerToSPIRV.h>
+#include <MLIR/Dialect.h>
+#include <format>
+#include "mlir/Dialect/SPIRV/IR/SPIRVDialect.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Target/SPIRV/Serialization.h"
+#include "mlir/Transforms/Passes.h"
+
+namespace HKSL {
+std::vector<uint32_t> generate_spirv(CompilationContext& context, std::span<const UniformBlock> uniform_blocks, bool reorder_struct_fields) {
+    mlir::MLIRContext mlir_context;
+    mlir_context.getOrLoadDialect<mlir::hksl::HKSLDialect>();
+    mlir_context.getOrLoadDialect<mlir::spirv::SPIRVDialect>();
+
+    // MLIR reports in the same format as the front end
+    std::vector<std::string> errors;
+    mlir::ScopedDiagnosticHandler handler(&mlir_context, [&] (mlir::Diagnostic& diagnostic) {
+        if(diagnostic.getSeverity() != mlir::DiagnosticSeverity::Error) {
+            return mlir::success();
+        }
+        auto location = diagnostic.getLocation()->findInstanceOf<mlir::FileLineColLoc>();
+        if(location) {
+            errors.push_back(std::format("{}:{}: {}", location.getLine(), location.getColumn(), diagnostic.str()));
+        } else {
+            errors.push_back(diagnostic.str());
+        }
+        return mlir::success();
+    });
+
+    std::vector<uint32_t> binary;
+    mlir::OwningOpRef<mlir::ModuleOp> module = generate_mlir(context, mlir_context, uniform_blocks, reorder_struct_fields);
+    if(!module) {
+        return binary;
+    }
+
+    mlir::PassManager pass_manager(&mlir_context, mlir::ModuleOp::getOperationName());
+    pass_manager.addPass(mlir::createCanonicalizerPass());
+    pass_manager.addPass(mlir::createCSEPass());
+    pass_manager.addPass(create_lower_to_spirv_pass());
+    if(mlir::failed(pass_manager.run(*module))) {
+        context.append_errors(std::move(errors));
+        return binary;
+    }
+
+    auto spirv_modules = module->getOps<mlir::spirv::ModuleOp>();
+    llvm::SmallVector<uint32_t> words;
+    if(spirv_modules.empty() || mlir::failed(mlir::spirv::serialize(*spirv_modules.begin(), words))) {
+        errors.push_back("Couldn't serialize the SPIR-V module");
+    } else {
+        binary.assign(words.begin(), words.end());
+    }
+    context.append_errors(std::move(errors));
+
+    return binary;
+}
+}
@@ -0,0 +1,112 @@
+#include <MLIR/Dialect.h>
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/OpImplementation.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Interfaces/FunctionImplementation.h"
+
+using namespace mlir;
+using namespace mlir::hksl;
+
+#include "Dialect.cpp.inc"
+
+void HKSLDialect::initialize() {
+    addOperations<
+#define GET_OP_LIST
+#include "Ops.cpp.inc"
+    >();
+}
+
+// Components of a scalar or vector
+static int64_t component_count(Type type) {
+    auto vector = llvm::dyn_cast<VectorType>(type);
+    return vector ? vector.getNumElements() : 1;
+}
+
+LogicalResult ConstructOp::verify() {
+    auto result = llvm::cast<VectorType>(getType());
+    int64_t components = 0;
+    for(Value element: getElements()) {
+        if(getElementTypeOrSelf(element.getType()) != result.getElementType()) {
+            return emitOpError("expects elements of type ") << result.getElementType() << ", got " << element.getType();
+        }
+        components += component_count(element.getType());
+    }
+    if(components != result.getNumElements()) {
+        return emitOpError("expects ") << result.getNumElements() << " components, got " << components;
+    }
+
+    return success();
+}
+
+LogicalResult UniformOp::verifySymbolUses(SymbolTableCollection& symbol_table) {
+    auto block = symbol_table.lookupNearestSymbolFrom<UniformBlockOp>(*this, getUniformBlockAttr());
+    if(!block) {
+        return emitOpError("'") << getUniformBlock() << "' does not reference a uniform block";
+    }
+
+    return success();
+}
+
+void FuncOp::build(OpBuilder& builder, OperationState& state, StringRef name, FunctionType type, ArrayRef<NamedAttribute> attrs) {
+    buildWithEntryBlock(builder, state, name, type, attrs, type.getInputs());
+}
+ParseResult FuncOp::parse(OpAsmParser& parser, OperationState& result) {
+    auto build_func_type = [] (Builder& builder, ArrayRef<Type> arg_types, ArrayRef<Type> results, function_interface_impl::VariadicFlag, std::string&) {
+        return builder.getFunctionType(arg_types, results);
+    };
+
+    return function_interface_impl::parseFunctionOp(
+        parser, result, /*allowVariadic=*/false,
+        getFunctionTypeAttrName(result.name), build_func_type,
+        getArgAttrsAttrName(result.name), getResAttrsAttrName(result.name));
+}
+void FuncOp::print(OpAsmPrinter& printer) {
+    function_interface_impl::printFunctionOp(
+        printer, *this, /*isVariadic=*/false, getFunctionTypeAttrName(),
+        getArgAttrsAttrName(), getResAttrsAttrName());
+}
+
+LogicalResult CallOp::verifySymbolUses(SymbolTableCollection& symbol_table) {
+    auto callee = symbol_table.lookupNearestSymbolFrom<FuncOp>(*this, getCalleeAttr());
+    if(!callee) {
+        return emitOpError("'") << getCallee() << "' does not reference a function";
+    }
+
+    FunctionType type = callee.getFunctionType();
+    if(!llvm::equal(getInputs().getTypes(), type.getInputs()) || !llvm::equal(getResultTypes(), type.getResults())) {
+        return emitOpError("doesn't match the signature of ") << getCallee();
+    }
+
+    return success();
+}
+
+LogicalResult ReturnOp::verify() {
+    auto function = cast<FuncOp>((*this)->getParentOp());
+    ArrayRef<Type> results = function.getResultTypes();
+    if(results.empty() != !getInput()) {
+        return emitOpError("must return a value exactly when the function has a result");
+    }
+    if(getInput() && getInput().getType() != results.front()) {
+        return emitOpError("returns ") << getInput().getType() << " from a function returning " << results.front();
+    }
+
+    return success();
+}
+
+LogicalResult IfOp::verify() {
+    for(Region* region: {&getThenRegion(), &getElseRegion()}) {
+        Block& block = region->front();
+        if(block.empty() || !llvm::isa<YieldOp>(block.back())) {
+            return emitOpError("branches must end in hksl.yield");
+        }
+        auto yield = llvm::cast<YieldOp>(block.back());
+        if(!llvm::equal(yield.getResults().getTypes(), getResultTypes())) {
+            return emitOpError("branches must yield the types of the results");
+        }
+    }
+
+    return success();
+}
+
+#define GET_OP_CLASSES
+#include "Ops.cpp.inc"
@@ -0,0 +1,420 @@
+#include <LowerToSPIRV.h>
+#include <MLIR/Dialect.h>
+#include <ReflectionWriter.h>
+#include <Util.h>
+#include <format>
+#include "mlir/Conversion/ArithToSPIRV/ArithToSPIRV.h"
+#include "mlir/Conversion/FuncToSPIRV/FuncToSPIRV.h"
+#include "mlir/Conversion/SCFToSPIRV/SCFToSPIRV.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/SCF/IR/SCF.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVDialect.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
+#include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
+#include "mlir/Dialect/SPIRV/Transforms/SPIRVConversion.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Transforms/DialectConversion.h"
+
+namespace HKSL {
+using namespace mlir;
+
+// First step, hksl to arith, func and scf
+
+struct ConstantLowering: public OpConversionPattern<hksl::ConstantOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::ConstantOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        rewriter.replaceOpWithNewOp<arith::ConstantOp>(op, op.getValue());
+        return success();
+    }
+};
+template<typename Op, typename ArithOp>
+struct BinaryLowering: public OpConversionPattern<Op> {
+    using OpConversionPattern<Op>::OpConversionPattern;
+    LogicalResult matchAndRewrite(Op op, typename OpConversionPattern<Op>::OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        rewriter.replaceOpWithNewOp<ArithOp>(op, adaptor.getLhs(), adaptor.getRhs());
+        return success();
+    }
+};
+struct EqLowering: public OpConversionPattern<hksl::EqOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::EqOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        // 1.0 or 0.0 per component
+        Value equal = rewriter.create<arith::CmpFOp>(op.getLoc(), arith::CmpFPredicate::OEQ, adaptor.getLhs(), adaptor.getRhs());
+        rewriter.replaceOpWithNewOp<arith::UIToFPOp>(op, op.getType(), equal);
+        return success();
+    }
+};
+struct NegLowering: public OpConversionPattern<hksl::NegOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::NegOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        rewriter.replaceOpWithNewOp<arith::NegFOp>(op, adaptor.getOperand());
+        return success();
+    }
+};
+struct NonZeroLowering: public OpConversionPattern<hksl::NonZeroOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::NonZeroOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        Type type = adaptor.getOperand().getType();
+        Value zero = rewriter.create<arith::ConstantOp>(op.getLoc(), cast<TypedAttr>(rewriter.getFloatAttr(type, 0.0)));
+        rewriter.replaceOpWithNewOp<arith::CmpFOp>(op, arith::CmpFPredicate::UNE, adaptor.getOperand(), zero);
+        return success();
+    }
+};
+struct FuncLowering: public OpConversionPattern<hksl::FuncOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::FuncOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        auto func = rewriter.create<func::FuncOp>(op.getLoc(), op.getSymName(), op.getFunctionType());
+        rewriter.inlineRegionBefore(op.getBody(), func.getBody(), func.end());
+        rewriter.eraseOp(op);
+        return success();
+    }
+};
+struct CallLowering: public OpConversionPattern<hksl::CallOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::CallOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        rewriter.replaceOpWithNewOp<func::CallOp>(op, op.getCallee(), op->getResultTypes(), adaptor.getInputs());
+        return success();
+    }
+};
+struct ReturnLowering: public OpConversionPattern<hksl::ReturnOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::ReturnOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        rewriter.replaceOpWithNewOp<func::ReturnOp>(op, adaptor.getOperands());
+        return success();
+    }
+};
+struct IfLowering: public OpConversionPattern<hksl::IfOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::IfOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        auto if_op = rewriter.create<scf::IfOp>(op.getLoc(), op->getResultTypes(), adaptor.getCondition(), false, false);
+        rewriter.inlineRegionBefore(op.getThenRegion(), if_op.getThenRegion(), if_op.getThenRegion().end());
+        rewriter.inlineRegionBefore(op.getElseRegion(), if_op.getElseRegion(), if_op.getElseRegion().end());
+        rewriter.replaceOp(op, if_op.getResults());
+        return success();
+    }
+};
+struct YieldLowering: public OpConversionPattern<hksl::YieldOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::YieldOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        rewriter.replaceOpWithNewOp<scf::YieldOp>(op, adaptor.getOperands());
+        return success();
+    }
+};
+
+// Second step, what has no upstream conversion straight to SPIR-V
+
+struct ConstructLowering: public OpConversionPattern<hksl::ConstructOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::ConstructOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        // OpCompositeConstruct takes vector constituents as they are
+        Type type = getTypeConverter()->convertType(op.getType());
+        if(!type) {
+            return failure();
+        }
+        rewriter.replaceOpWithNewOp<spirv::CompositeConstructOp>(op, type, adaptor.getElements());
+        return success();
+    }
+};
+struct UniformLowering: public OpConversionPattern<hksl::UniformOp> {
+    using OpConversionPattern::OpConversionPattern;
+    LogicalResult matchAndRewrite(hksl::UniformOp op, OpAdaptor adaptor, ConversionPatternRewriter& rewriter) const override {
+        auto block = SymbolTable::lookupNearestSymbolFrom<spirv::GlobalVariableOp>(op, op.getUniformBlockAttr());
+        if(!block) {
+            return failure();
+        }
+        Location loc = op.getLoc();
+        Value pointer = rewriter.create<spirv::AddressOfOp>(loc, block);
+        Value index = rewriter.create<spirv::ConstantOp>(loc, rewriter.getI32Type(), rewriter.getI32IntegerAttr(op.getMember()));
+        Value member = rewriter.create<spirv::AccessChainOp>(loc, pointer, ValueRange(index));
+        rewriter.replaceOpWithNewOp<spirv::LoadOp>(op, member);
+        return success();
+    }
+};
+
+// Everything the lowering may use, the capabilities the module declares
+// are narrowed down to what it does use
+static spirv::TargetEnvAttr vulkan_target_env(MLIRContext* context) {
+    auto triple = spirv::VerCapExtAttr::get(
+        spirv::Version::V_1_0,
+        {
+            spirv::Capability::Shader,
+            spirv::Capability::Float16,
+            spirv::Capability::StorageInputOutput16,
+            spirv::Capability::StorageUniform16,
+            spirv::Capability::StoragePushConstant16,
+        },
+        {spirv::Extension::SPV_KHR_16bit_storage},
+        context);
+
+    return spirv::TargetEnvAttr::get(triple, spirv::getDefaultResourceLimits(context), spirv::ClientAPI::Vulkan);
+}
+static spirv::ExecutionModel execution_model(Reflection::Stage stage) {
+    switch(stage) {
+        case Reflection::Stage::Vertex:
+            return spirv::ExecutionModel::Vertex;
+        case Reflection::Stage::Fragment:
+            return spirv::ExecutionModel::Fragment;
+        case Reflection::Stage::Compute:
+            return spirv::ExecutionModel::GLCompute;
+    }
+    HKSL_UNREACHABLE();
+}
+static bool contains_half(Type type) {
+    if(auto pointer = dyn_cast<spirv::PointerType>(type)) {
+        return contains_half(pointer.getPointeeType());
+    }
+    if(auto structure = dyn_cast<spirv::StructType>(type)) {
+        for(unsigned i = 0; i < structure.getNumElements(); i++) {
+            if(contains_half(structure.getElementType(i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return getElementTypeOrSelf(type).isF16();
+}
+
+struct EntryPoint {
+    std::string name;
+    spirv::ExecutionModel model;
+};
+
+class LowerToSPIRVPass: public PassWrapper<LowerToSPIRVPass, OperationPass<ModuleOp>> {
+    public:
+        MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(LowerToSPIRVPass)
+
+        StringRef getArgument() const override {
+            return "hksl-to-spirv";
+        }
+        void getDependentDialects(DialectRegistry& registry) const override {
+            registry.insert<arith::ArithDialect, func::FuncDialect, scf::SCFDialect, spirv::SPIRVDialect>();
+        }
+        void runOnOperation() override;
+    private:
+        // Frees the entry point names for their wrappers
+        LogicalResult rename_entry_points(ModuleOp module, std::vector<EntryPoint>& entry_points);
+        LogicalResult lower_to_standard(ModuleOp module);
+        spirv::ModuleOp create_spirv_module(ModuleOp module);
+        LogicalResult lower_to_spirv(spirv::ModuleOp spirv_module);
+        void add_entry_point(spirv::ModuleOp spirv_module, const EntryPoint& entry_point);
+        void set_vce_triple(spirv::ModuleOp spirv_module);
+};
+
+void LowerToSPIRVPass::runOnOperation() {
+    ModuleOp module = getOperation();
+    std::vector<EntryPoint> entry_points;
+    if(failed(rename_entry_points(module, entry_points)) || failed(lower_to_standard(module))) {
+        return signalPassFailure();
+    }
+
+    spirv::ModuleOp spirv_module = create_spirv_module(module);
+    if(failed(lower_to_spirv(spirv_module))) {
+        return signalPassFailure();
+    }
+    for(const auto& entry_point: entry_points) {
+        add_entry_point(spirv_module, entry_point);
+    }
+    set_vce_triple(spirv_module);
+}
+LogicalResult LowerToSPIRVPass::rename_entry_points(ModuleOp module, std::vector<EntryPoint>& entry_points) {
+    for(auto func: llvm::make_early_inc_range(module.getOps<hksl::FuncOp>())) {
+        std::string name = func.getSymName().str();
+        auto stage = entry_point_stage(name);
+        if(!stage) {
+            continue;
+        }
+
+        // Not a valid HKSL name, so it can't clash with one
+        auto body_name = StringAttr::get(module.getContext(), name + ".body");
+        if(failed(SymbolTable::replaceAllSymbolUses(func, body_name, module))) {
+            return func.emitError("Couldn't rename entry point ") << name;
+        }
+        SymbolTable::setSymbolName(func, body_name);
+        entry_points.push_back(EntryPoint {.name = name, .model = execution_model(*stage)});
+    }
+
+    return success();
+}
+LogicalResult LowerToSPIRVPass::lower_to_standard(ModuleOp module) {
+    MLIRContext* context = module.getContext();
+    ConversionTarget target(*context);
+    target.addLegalDialect<arith::ArithDialect, func::FuncDialect, scf::SCFDialect>();
+    target.addIllegalDialect<hksl::HKSLDialect>();
+    // Lowered straight to SPIR-V
+    target.addLegalOp<hksl::ConstructOp, hksl::UniformOp, hksl::UniformBlockOp>();
+
+    RewritePatternSet patterns(context);
+    patterns.add<
+        ConstantLowering,
+        BinaryLowering<hksl::AddOp, arith::AddFOp>,
+        BinaryLowering<hksl::SubOp, arith::SubFOp>,
+        BinaryLowering<hksl::MulOp, arith::MulFOp>,
+        BinaryLowering<hksl::DivOp, arith::DivFOp>,
+        EqLowering,
+        NegLowering,
+        NonZeroLowering,
+        FuncLowering,
+        CallLowering,
+        ReturnLowering,
+        IfLowering,
+        YieldLowering
+    >(context);
+
+    return applyPartialConversion(module, target, std::move(patterns));
+}
+spirv::ModuleOp LowerToSPIRVPass::create_spirv_module(ModuleOp module) {
+    OpBuilder builder(module.getContext());
+    builder.setInsertionPointToEnd(module.getBody());
+    auto spirv_module = builder.create<spirv::ModuleOp>(module.getLoc(), spirv::AddressingModel::Logical, spirv::MemoryModel::GLSL450);
+    spirv_module->setAttr(spirv::getTargetEnvAttrName(), vulkan_target_env(module.getContext()));
+
+    Block& body = spirv_module.getRegion().front();
+    for(Operation& op: llvm::make_early_inc_range(module.getBody()->getOperations())) {
+        if(isa<func::FuncOp, hksl::UniformBlockOp>(op)) {
+            op.moveBefore(&body, body.end());
+        }
+    }
+
+    for(auto block: llvm::make_early_inc_range(body.getOps<hksl::UniformBlockOp>())) {
+        builder.setInsertionPoint(block);
+        if(block.getPushConstant()) {
+            auto pointer = spirv::PointerType::get(block.getType(), spirv::StorageClass::PushConstant);
+            builder.create<spirv::GlobalVariableOp>(block.getLoc(), pointer, block.getSymName());
+        } else {
+            auto pointer = spirv::PointerType::get(block.getType(), spirv::StorageClass::Uniform);
+            builder.create<spirv::GlobalVariableOp>(block.getLoc(), pointer, block.getSymName(), 0, block.getBinding());
+        }
+        block.erase();
+    }
+
+    return spirv_module;
+}
+LogicalResult LowerToSPIRVPass::lower_to_spirv(spirv::ModuleOp spirv_module) {
+    MLIRContext* context = spirv_module.getContext();
+    spirv::TargetEnvAttr target_env = spirv::lookupTargetEnvOrDefault(spirv_module);
+    std::unique_ptr<ConversionTarget> target = SPIRVConversionTarget::get(target_env);
+    SPIRVTypeConverter type_converter(target_env);
+
+    RewritePatternSet patterns(context);
+    arith::populateArithToSPIRVPatterns(type_converter, patterns);
+    populateFuncToSPIRVPatterns(type_converter, patterns);
+    populateBuiltinFuncToSPIRVPatterns(type_converter, patterns);
+    ScfToSPIRVContext scf_context;
+    populateSCFToSPIRVPatterns(type_converter, scf_context, patterns);
+    patterns.add<ConstructLowering, UniformLowering>(type_converter, context);
+
+    return applyFullConversion(spirv_module, *target, std::move(patterns));
+}
+void LowerToSPIRVPass::add_entry_point(spirv::ModuleOp spirv_module, const EntryPoint& entry_point) {
+    MLIRContext* context = spirv_module.getContext();
+    Block& body = spirv_module.getRegion().front();
+    auto function = cast<spirv::FuncOp>(SymbolTable::lookupSymbolIn(spirv_module, entry_point.name + ".body"));
+    FunctionType type = function.getFunctionType();
+    Location loc = function.getLoc();
+    OpBuilder builder(context);
+    builder.setInsertionPointToEnd(&body);
+
+    // Locations match the reflection's, parameters in order and the
+    // result at 0
+    llvm::SmallVector<spirv::GlobalVariableOp> inputs;
+    llvm::SmallVector<Attribute> interface;
+    for(unsigned i = 0; i < type.getNumInputs(); i++) {
+        auto pointer = spirv::PointerType::get(type.getInput(i), spirv::StorageClass::Input);
+        auto input = builder.create<spirv::GlobalVariableOp>(loc, pointer, std::format("{}.in{}", entry_point.name, i));
+        input->setAttr("location", builder.getI32IntegerAttr(i));
+        inputs.push_back(input);
+        interface.push_back(SymbolRefAttr::get(input));
+    }
+    spirv::GlobalVariableOp output;
+    if(type.getNumResults() == 1) {
+        auto pointer = spirv::PointerType::get(type.getResult(0), spirv::StorageClass::Output);
+        output = builder.create<spirv::GlobalVariableOp>(loc, pointer, entry_point.name + ".out");
+        output->setAttr("location", builder.getI32IntegerAttr(0));
+        interface.push_back(SymbolRefAttr::get(output));
+    }
+
+    auto wrapper = builder.create<spirv::FuncOp>(loc, entry_point.name, builder.getFunctionType({}, {}));
+    builder.setInsertionPointToStart(wrapper.addEntryBlock());
+    llvm::SmallVector<Value> args;
+    for(auto input: inputs) {
+        args.push_back(builder.create<spirv::LoadOp>(loc, builder.create<spirv::AddressOfOp>(loc, input)));
+    }
+    auto call = builder.create<spirv::FunctionCallOp>(loc, type.getResults(), FlatSymbolRefAttr::get(function), args);
+    if(output) {
+        builder.create<spirv::StoreOp>(loc, builder.create<spirv::AddressOfOp>(loc, output), call->getResult(0));
+    }
+    builder.create<spirv::ReturnOp>(loc);
+
+    builder.setInsertionPointToEnd(&body);
+    builder.create<spirv::EntryPointOp>(loc, entry_point.model, wrapper, interface);
+    if(entry_point.model == spirv::ExecutionModel::Fragment) {
+        builder.create<spirv::ExecutionModeOp>(loc, wrapper, spirv::ExecutionMode::OriginUpperLeft, ArrayRef<int32_t>{});
+    } else if(entry_point.model == spirv::ExecutionModel::GLCompute) {
+        builder.create<spirv::ExecutionModeOp>(loc, wrapper, spirv::ExecutionMode::LocalSize, ArrayRef<int32_t>{1, 1, 1});
+    }
+}
+void LowerToSPIRVPass::set_vce_triple(spirv::ModuleOp spirv_module) {
+    bool half = false;
+    bool half_io = false, half_uniform = false, half_push_constant = false;
+    auto note_type = [&] (Type type) {
+        if(!contains_half(type)) {
+            return;
+        }
+        half = true;
+        if(auto pointer = dyn_cast<spirv::PointerType>(type)) {
+            switch(pointer.getStorageClass()) {
+                case spirv::StorageClass::Input:
+                case spirv::StorageClass::Output:
+                    half_io = true;
+                    break;
+                case spirv::StorageClass::Uniform:
+                    half_uniform = true;
+                    break;
+                case spirv::StorageClass::PushConstant:
+                    half_push_constant = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+    };
+    spirv_module.walk([&] (Operation* op) {
+        for(Type type: op->getResultTypes()) {
+            note_type(type);
+        }
+        if(auto variable = dyn_cast<spirv::GlobalVariableOp>(op)) {
+            note_type(variable.getType());
+        } else if(auto function = dyn_cast<spirv::FuncOp>(op)) {
+            for(Type type: function.getFunctionType().getInputs()) {
+                note_type(type);
+            }
+        }
+    });
+
+    llvm::SmallVector<spirv::Capability> capabilities = {spirv::Capability::Shader};
+    llvm::SmallVector<spirv::Extension> extensions;
+    if(half) {
+        capabilities.push_back(spirv::Capability::Float16);
+    }
+    if(half_io) {
+        capabilities.push_back(spirv::Capability::StorageInputOutput16);
+    }
+    if(half_uniform) {
+        capabilities.push_back(spirv::Capability::StorageUniform16);
+    }
+    if(half_push_constant) {
+        capabilities.push_back(spirv::Capability::StoragePushConstant16);
+    }
+    if(half_io || half_uniform || half_push_constant) {
+        extensions.push_back(spirv::Extension::SPV_KHR_16bit_storage);
+    }
+
+    spirv_module.setVceTripleAttr(spirv::VerCapExtAttr::get(spirv::Version::V_1_0, capabilities, extensions, spirv_module.getContext()));
+}
+
+std::unique_ptr<mlir::Pass> create_lower_to_spirv_pass() {
+    return std::make_unique<LowerToSPIRVPass>();
+}
+}
@@ -0,0 +1,534 @@
+#include <MLIRGen.h>
+#include <MLIR/Dialect.h>
+#include <ReflectionWriter.h>
+#include <Visitor.h>
+#include <Util.h>
+#include <algorithm>
+#include <format>
+#include <unordered_map>
+#include "mlir/Dialect/SPIRV/IR/SPIRVTypes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/Verifier.h"
+
+namespace HKSL {
+static bool is_value_type(const Type* type) {
+    return type->kind() == TypeKind::Scalar || type->kind() == TypeKind::Vector;
+}
+static bool is_void(const Type* type) {
+    return !type || type->kind() == TypeKind::Void;
+}
+
+// Reports what codegen can't handle yet before anything is generated, so
+// the generator can take a checked function as it is
+class SupportCheck: public Visitor<SupportCheck> {
+    public:
+        SupportCheck(CompilationContext& context): context(context) {
+            set_ast(context.get_ast());
+        }
+        void visit_function(NodeId node, const Function& function) {
+            if(!is_void(function.return_type)) {
+                check_type(function.name.span, function.return_type);
+            }
+
+            auto stage = entry_point_stage(context.symbols().str(function.name.symbol));
+            if(stage == Reflection::Stage::Compute && (!function.args.empty() || !is_void(function.return_type))) {
+                context.error(function.name.span, "compute_main can't have parameters or a result");
+            }
+
+            Visitor::visit_function(node, function);
+        }
+        void visit_if_statement(NodeId node, const IfStatement& if_statement) {
+            Type* type = context.type_resolver().type_of(if_statement.condition);
+            if(type && type->kind() != TypeKind::Scalar) {
+                context.error(ast().span(if_statement.condition), std::format("Conditions must be scalars, got {}", type->name()));
+            }
+
+            Visitor::visit_if_statement(node, if_statement);
+        }
+        // Parameters and lets
+        void visit_var_decl(NodeId node, const VarDecl& var_decl) {
+            if(var_decl.type) {
+                check_type(var_decl.name.span, var_decl.type);
+            }
+        }
+        void visit_expr(NodeId expr) {
+            Type* type = context.type_resolver().type_of(expr);
+            if(type && !is_void(type)) {
+                check_type(ast().span(expr), type);
+            }
+
+            Visitor::visit_expr(expr);
+        }
+    private:
+        void check_type(Span span, const Type* type) {
+            if(!is_value_type(type)) {
+                context.error(span, std::format("Codegen doesn't support {} values yet", type->name()));
+            }
+        }
+
+        CompilationContext& context;
+};
+
+// Variables a statement assigns and whether it may return
+class Effects: public Visitor<Effects> {
+    public:
+        Effects(CompilationContext& context): context(context) {
+            set_ast(context.get_ast());
+        }
+        void visit_assignment_expr(NodeId node, const AssignmentExpr& expr) {
+            assigned.push_back(context.symbol_resolver().get_var_decl(expr.lhs));
+            Visitor::visit_assignment_expr(node, expr);
+        }
+        void visit_return_statement(NodeId node, const ReturnStatement& ret) {
+            returns = true;
+            Visitor::visit_return_statement(node, ret);
+        }
+
+        // VarDecl nodes, may repeat
+        std::vector<NodeId> assigned;
+        bool returns = false;
+    private:
+        CompilationContext& context;
+};
+
+class MLIRGenerator {
+    public:
+        MLIRGenerator(CompilationContext& context, mlir::MLIRContext& mlir_context, bool reorder_struct_fields):
+            context(context), ast(context.get_ast()), builder(&mlir_context), reorder_struct_fields(reorder_struct_fields) {}
+        mlir::OwningOpRef<mlir::ModuleOp> generate(std::span<const UniformBlock> uniform_blocks);
+    private:
+        // Values of the variables in scope, and of the return taken so far.
+        // A return inside an if only sets `returned`, the statements after
+        // the if are then skipped by another if.
+        struct FlowState {
+            // By VarDecl
+            std::unordered_map<NodeId, mlir::Value> vars;
+            // i1
+            mlir::Value returned;
+            // Null in void functions
+            mlir::Value return_value;
+        };
+
+        void declare_uniform_block(const UniformBlock& block);
+        void generate_function(const Function& function);
+        // True if the statements always return
+        bool generate_statements(std::span<const NodeId> statements, size_t first);
+        void generate_if(NodeId node, const IfStatement& if_statement, const Effects& effects);
+        // Runs statements[first..] unless a return was taken
+        void generate_rest(std::span<const NodeId> statements, size_t first);
+        // An hksl.if on `condition` yielding the variables in `carried` and,
+        // if `may_return`, the return state
+        template<typename Then, typename Else>
+        void generate_branches(mlir::Location loc, mlir::Value condition, const std::vector<NodeId>& carried, bool may_return, Then then_branch, Else else_branch);
+        std::vector<mlir::Value> yielded(const std::vector<NodeId>& carried, bool may_return);
+        // Assigned variables declared outside of the statements, by id
+        std::vector<NodeId> carried_vars(const Effects& effects);
+        mlir::Value generate_expr(NodeId expr);
+        mlir::Value generate_bin_expr(NodeId node, const BinExpr& expr);
+        mlir::Value generate_call(NodeId node, const CallExpr& call);
+        mlir::Value generate_constant(NodeId node, const NumberLiteral& literal);
+        mlir::Value zero(mlir::Type type, mlir::Location loc);
+        mlir::Value flag(bool value, mlir::Location loc);
+        mlir::Type value_type(const Type* type);
+        // Members of structs in blocks carry their offsets under `rule`
+        mlir::Type block_member_type(const Type* type, LayoutRule rule);
+        mlir::Location loc(Span span);
+
+        CompilationContext& context;
+        AST& ast;
+        mlir::OpBuilder builder;
+        // Struct fields in blocks are laid out as the reflection reports them
+        bool reorder_struct_fields;
+        mlir::ModuleOp module;
+        FlowState state;
+        // Of the function being generated, null if void
+        mlir::Type return_type;
+        // From the VarDecl of a uniform to its block and member index
+        std::unordered_map<NodeId, std::pair<mlir::FlatSymbolRefAttr, uint32_t>> uniforms;
+};
+
+mlir::OwningOpRef<mlir::ModuleOp> MLIRGenerator::generate(std::span<const UniformBlock> uniform_blocks) {
+    SupportCheck check(context);
+    for(NodeId statement: ast.top_level()) {
+        if(ast.kind(statement) == NodeKind::Function) {
+            check.visit_function(statement, ast.function(statement));
+        }
+    }
+    if(!context.is_success()) {
+        return nullptr;
+    }
+
+    module = mlir::ModuleOp::create(builder.getUnknownLoc());
+    builder.setInsertionPointToEnd(module.getBody());
+    for(const auto& block: uniform_blocks) {
+        declare_uniform_block(block);
+    }
+    for(NodeId statement: ast.top_level()) {
+        if(ast.kind(statement) == NodeKind::Function) {
+            generate_function(ast.function(statement));
+        }
+    }
+
+    if(mlir::failed(mlir::verify(module))) {
+        module.emitError("Generated invalid HKSL dialect");
+        module.erase();
+        return nullptr;
+    }
+
+    return module;
+}
+void MLIRGenerator::declare_uniform_block(const UniformBlock& block) {
+    LayoutRule rule = block.kind == BlockKind::PushConstant ? LayoutRule::Std430 : LayoutRule::Std140;
+    std::string name = block.kind == BlockKind::PushConstant
+        ? "push_constants"
+        : std::format("uniforms_{}", update_frequency_to_string(block.frequency));
+    auto symbol = mlir::FlatSymbolRefAttr::get(builder.getContext(), name);
+
+    llvm::SmallVector<mlir::Type> members;
+    llvm::SmallVector<mlir::spirv::StructType::OffsetInfo> offsets;
+    for(size_t i = 0; i < block.members.size(); i++) {
+        const PlacedUniform& member = block.members[i];
+        NodeId var_decl = ast.uniform_decl(member.decl).var_decl;
+        members.push_back(block_member_type(ast.var_decl(var_decl).type, rule));
+        offsets.push_back(member.offset);
+        uniforms.emplace(var_decl, std::make_pair(symbol, (uint32_t) i));
+    }
+
+    builder.create<mlir::hksl::UniformBlockOp>(
+        loc(ast.span(block.members.front().decl)),
+        builder.getStringAttr(name),
+        mlir::TypeAttr::get(mlir::spirv::StructType::get(members, offsets)),
+        block.kind == BlockKind::PushConstant ? builder.getUnitAttr() : mlir::UnitAttr(),
+        builder.getI32IntegerAttr(block.binding));
+}
+void MLIRGenerator::generate_function(const Function& function) {
+    llvm::SmallVector<mlir::Type> arg_types, result_types;
+    for(NodeId arg: function.args) {
+        arg_types.push_back(value_type(ast.var_decl(arg).type));
+    }
+    return_type = is_void(function.return_type) ? mlir::Type() : value_type(function.return_type);
+    if(return_type) {
+        result_types.push_back(return_type);
+    }
+    auto function_type = builder.getFunctionType(arg_types, result_types);
+
+    auto location = loc(function.name.span);
+    std::string_view name = context.symbols().str(function.name.symbol);
+    builder.setInsertionPointToEnd(module.getBody());
+    auto func = builder.create<mlir::hksl::FuncOp>(location, llvm::StringRef(name.data(), name.size()), function_type);
+    mlir::Block& entry = func.getBody().front();
+    builder.setInsertionPointToStart(&entry);
+
+    state = FlowState();
+    for(size_t i = 0; i < function.args.size(); i++) {
+        state.vars[function.args[i]] = entry.getArgument(i);
+    }
+    // Functions falling off their end return zero
+    state.returned = flag(false, location);
+    if(return_type) {
+        state.return_value = zero(return_type, location);
+    }
+
+    generate_statements(ast.block_statement(function.block).statements, 0);
+    builder.create<mlir::hksl::ReturnOp>(location, state.return_value);
+}
+bool MLIRGenerator::generate_statements(std::span<const NodeId> statements, size_t first) {
+    for(size_t i = first; i < statements.size(); i++) {
+        NodeId statement = statements[i];
+        switch(ast.kind(statement)) {
+            case NodeKind::ExprStatement:
+                generate_expr(ast.expr_statement(statement).expr);
+                break;
+            case NodeKind::Return: {
+                auto ret = ast.return_statement(statement);
+                mlir::Value value = ret.value != NO_NODE ? generate_expr(ret.value) : mlir::Value();
+                if(return_type) {
+                    state.return_value = value;
+                }
+                state.returned = flag(true, loc(ret.ret_span));
+                // Anything after is dead
+                return true;
+            }
+            case NodeKind::Block: {
+                Effects effects(context);
+                effects.visit_statement(statement);
+                if(generate_statements(ast.block_statement(statement).statements, 0)) {
+                    return true;
+                }
+                if(effects.returns) {
+                    generate_rest(statements, i + 1);
+                    return false;
+                }
+                break;
+            }
+            case NodeKind::If: {
+                Effects effects(context);
+                effects.visit_statement(statement);
+                generate_if(statement, ast.if_statement(statement), effects);
+                if(effects.returns) {
+                    generate_rest(statements, i + 1);
+                    return false;
+                }
+                break;
+            }
+            default:
+                HKSL_UNREACHABLE();
+        }
+    }
+
+    return false;
+}
+void MLIRGenerator::generate_if(NodeId node, const IfStatement& if_statement, const Effects& effects) {
+    auto location = loc(ast.span(node));
+    mlir::Value condition = generate_expr(if_statement.condition);
+    condition = builder.create<mlir::hksl::NonZeroOp>(location, builder.getI1Type(), condition);
+
+    generate_branches(location, condition, carried_vars(effects), effects.returns,
+        [&] {
+            generate_statements(ast.block_statement(if_statement.then_block).statements, 0);
+        },
+        [&] {
+            if(if_statement.else_stmt != NO_NODE) {
+                // A block or, for else if, another if
+                NodeId else_body = ast.else_statement(if_statement.else_stmt).statement;
+                generate_statements(std::span<const NodeId>(&else_body, 1), 0);
+            }
+        });
+}
+void MLIRGenerator::generate_rest(std::span<const NodeId> statements, size_t first) {
+    if(first == statements.size()) {
+        return;
+    }
+
+    Effects effects(context);
+    for(size_t i = first; i < statements.size(); i++) {
+        effects.visit_statement(statements[i]);
+    }
+    generate_branches(loc(ast.span(statements[first])), state.returned, carried_vars(effects), true,
+        [] {},
+        [&] {
+            generate_statements(statements, first);
+        });
+}
+template<typename Then, typename Else>
+void MLIRGenerator::generate_branches(mlir::Location loc, mlir::Value condition, const std::vector<NodeId>& carried, bool may_return, Then then_branch, Else else_branch) {
+    llvm::SmallVector<mlir::Type> types;
+    for(mlir::Value value: yielded(carried, may_return)) {
+        types.push_back(value.getType());
+    }
+    auto if_op = builder.create<mlir::hksl::IfOp>(loc, types, condition);
+
+    // Both branches start from the state before the if, variables declared
+    // inside go out of scope with it
+    FlowState before = state;
+    builder.setInsertionPointToStart(&if_op.getThenRegion().front());
+    then_branch();
+    builder.create<mlir::hksl::YieldOp>(loc, yielded(carried, may_return));
+
+    state = before;
+    builder.setInsertionPointToStart(&if_op.getElseRegion().front());
+    else_branch();
+    builder.create<mlir::hksl::YieldOp>(loc, yielded(carried, may_return));
+
+    state = std::move(before);
+    builder.setInsertionPointAfter(if_op);
+    unsigned result = 0;
+    if(may_return) {
+        state.returned = if_op->getResult(result++);
+        if(return_type) {
+            state.return_value = if_op->getResult(result++);
+        }
+    }
+    for(NodeId var: carried) {
+        state.vars[var] = if_op->getResult(result++);
+    }
+}
+std::vector<mlir::Value> MLIRGenerator::yielded(const std::vector<NodeId>& carried, bool may_return) {
+    std::vector<mlir::Value> values;
+    if(may_return) {
+        values.push_back(state.returned);
+        if(return_type) {
+            values.push_back(state.return_value);
+        }
+    }
+    for(NodeId var: carried) {
+        values.push_back(state.vars.at(var));
+    }
+
+    return values;
+}
+std::vector<NodeId> MLIRGenerator::carried_vars(const Effects& effects) {
+    std::vector<NodeId> carried;
+    for(NodeId var: effects.assigned) {
+        if(state.vars.contains(var)) {
+            carried.push_back(var);
+        }
+    }
+    std::sort(carried.begin(), carried.end());
+    carried.erase(std::unique(carried.begin(), carried.end()), carried.end());
+
+    return carried;
+}
+mlir::Value MLIRGenerator::generate_expr(NodeId expr) {
+    switch(ast.kind(expr)) {
+        case NodeKind::BinExpr:
+            return generate_bin_expr(expr, ast.bin_expr(expr));
+        case NodeKind::UnaryExpr: {
+            auto unary = ast.unary_expr(expr);
+            assert(unary.op == UnaryOp::Negate);
+            mlir::Value operand = generate_expr(unary.expr);
+            return builder.create<mlir::hksl::NegOp>(loc(unary.op_span), operand.getType(), operand);
+        }
+        case NodeKind::NumberConstant:
+            return generate_constant(expr, ast.number_constant(expr).number_literal);
+        case NodeKind::Variable: {
+            NodeId decl = context.symbol_resolver().get_var_decl(expr);
+            auto uniform = uniforms.find(decl);
+            if(uniform != uniforms.end()) {
+                return builder.create<mlir::hksl::UniformOp>(
+                    loc(ast.span(expr)),
+                    value_type(context.type_resolver().type_of(expr)),
+                    uniform->second.first,
+                    builder.getI32IntegerAttr(uniform->second.second));
+            }
+            return state.vars.at(decl);
+        }
+        case NodeKind::CallExpr:
+            return generate_call(expr, ast.call_expr(expr));
+        case NodeKind::AssignmentExpr: {
+            auto assignment = ast.assignment_expr(expr);
+            mlir::Value value = generate_expr(assignment.rhs);
+            state.vars[context.symbol_resolver().get_var_decl(assignment.lhs)] = value;
+            return value;
+        }
+        case NodeKind::LetExpr: {
+            auto let = ast.let_expr(expr);
+            auto var_decl = ast.var_decl(let.var_decl);
+            state.vars[let.var_decl] = let.rhs != NO_NODE
+                ? generate_expr(let.rhs)
+                : zero(value_type(var_decl.type), loc(var_decl.name.span));
+            return mlir::Value();
+        }
+        default:
+            HKSL_UNREACHABLE();
+    }
+}
+mlir::Value MLIRGenerator::generate_bin_expr(NodeId node, const BinExpr& expr) {
+    mlir::Value lhs = generate_expr(expr.left);
+    mlir::Value rhs = generate_expr(expr.right);
+    auto location = loc(expr.op_span);
+    switch(expr.op) {
+        case BinOp::Add:
+            return builder.create<mlir::hksl::AddOp>(location, lhs.getType(), lhs, rhs);
+        case BinOp::Subtract:
+            return builder.create<mlir::hksl::SubOp>(location, lhs.getType(), lhs, rhs);
+        case BinOp::Multiply:
+            return builder.create<mlir::hksl::MulOp>(location, lhs.getType(), lhs, rhs);
+        case BinOp::Divide:
+            return builder.create<mlir::hksl::DivOp>(location, lhs.getType(), lhs, rhs);
+        case BinOp::Equals:
+            return builder.create<mlir::hksl::EqOp>(location, lhs.getType(), lhs, rhs);
+    }
+    HKSL_UNREACHABLE();
+}
+mlir::Value MLIRGenerator::generate_call(NodeId node, const CallExpr& call) {
+    llvm::SmallVector<mlir::Value> args;
+    for(NodeId arg: call.args) {
+        args.push_back(generate_expr(arg));
+    }
+
+    auto location = loc(call.fn_name.span);
+    NodeId decl = context.symbol_resolver().get_function(node);
+    if(decl == NO_NODE) {
+        // Unresolved calls are vector constructors
+        return builder.create<mlir::hksl::ConstructOp>(location, value_type(context.type_resolver().type_of(node)), args);
+    }
+
+    auto function = ast.function(decl);
+    llvm::SmallVector<mlir::Type> results;
+    if(!is_void(function.return_type)) {
+        results.push_back(value_type(function.return_type));
+    }
+    std::string_view name = context.symbols().str(function.name.symbol);
+    auto callee = mlir::FlatSymbolRefAttr::get(builder.getContext(), llvm::StringRef(name.data(), name.size()));
+    auto call_op = builder.create<mlir::hksl::CallOp>(location, mlir::TypeRange(results), callee, args);
+
+    return results.empty() ? mlir::Value() : call_op->getResult(0);
+}
+mlir::Value MLIRGenerator::generate_constant(NodeId node, const NumberLiteral& literal) {
+    // Bits are already rounded to the literal's precision, keep them as they are
+    bool half = literal.kind == NumberKind::Half;
+    llvm::APFloat value(
+        half ? llvm::APFloat::IEEEhalf() : llvm::APFloat::IEEEsingle(),
+        llvm::APInt(half ? 16 : 32, half ? (literal.bits & 0xFFFF) : literal.bits));
+    auto attr = builder.getFloatAttr(half ? builder.getF16Type() : builder.getF32Type(), value);
+
+    return builder.create<mlir::hksl::ConstantOp>(loc(ast.span(node)), llvm::cast<mlir::TypedAttr>(attr));
+}
+mlir::Value MLIRGenerator::zero(mlir::Type type, mlir::Location loc) {
+    mlir::TypedAttr attr;
+    if(auto vector = llvm::dyn_cast<mlir::VectorType>(type)) {
+        mlir::Attribute component = builder.getFloatAttr(vector.getElementType(), 0.0);
+        attr = llvm::cast<mlir::TypedAttr>(mlir::DenseElementsAttr::get(llvm::cast<mlir::ShapedType>(vector), llvm::ArrayRef<mlir::Attribute>(component)));
+    } else {
+        attr = llvm::cast<mlir::TypedAttr>(builder.getFloatAttr(type, 0.0));
+    }
+
+    return builder.create<mlir::hksl::ConstantOp>(loc, attr);
+}
+mlir::Value MLIRGenerator::flag(bool value, mlir::Location loc) {
+    return builder.create<mlir::hksl::ConstantOp>(loc, llvm::cast<mlir::TypedAttr>(builder.getIntegerAttr(builder.getI1Type(), value)));
+}
+mlir::Type MLIRGenerator::value_type(const Type* type) {
+    const TypeDesc& desc = type->desc();
+    mlir::Type scalar;
+    switch(desc.scalar) {
+        case ScalarKind::Float:
+            scalar = builder.getF32Type();
+            break;
+        case ScalarKind::Half:
+            scalar = builder.getF16Type();
+            break;
+        case ScalarKind::None:
+            HKSL_UNREACHABLE();
+    }
+
+    switch(desc.kind) {
+        case TypeKind::Scalar:
+            return scalar;
+        case TypeKind::Vector:
+            return mlir::VectorType::get({(int64_t) desc.columns}, scalar);
+        default:
+            // Rejected by SupportCheck
+            HKSL_UNREACHABLE();
+    }
+}
+mlir::Type MLIRGenerator::block_member_type(const Type* type, LayoutRule rule) {
+    if(type->kind() != TypeKind::Struct) {
+        return value_type(type);
+    }
+
+    // Same layout place_uniforms sized the member with
+    TypeRegistry& registry = context.type_registry();
+    StructLayout layout = layout_struct(registry, type, rule, reorder_struct_fields);
+    const StructInfo& info = registry.struct_info(type);
+    llvm::SmallVector<mlir::Type> members;
+    llvm::SmallVector<mlir::spirv::StructType::OffsetInfo> offsets;
+    for(const auto& field: layout.fields) {
+        members.push_back(block_member_type(info.fields[field.field].type, rule));
+        offsets.push_back(field.offset);
+    }
+
+    return mlir::spirv::StructType::get(members, offsets);
+}
+mlir::Location MLIRGenerator::loc(Span span) {
+    SourceLocation location = context.locate(span);
+    return mlir::FileLineColLoc::get(builder.getStringAttr(context.sources().file(span.file).name()), location.line, location.col);
+}
+
+mlir::OwningOpRef<mlir::ModuleOp> generate_mlir(CompilationContext& context, mlir::MLIRContext& mlir_context, std::span<const UniformBlock> uniform_blocks, bool reorder_struct_fields) {
+    MLIRGenerator generator(context, mlir_context, reorder_struct_fields);
+    return generator.generate(uniform_blocks);
+}
+}
@@ -3,34 +3,99 @@
 #include <Parser.h>
 #include <Semantics.h>
 #include <Compiler.h>
+#include <ParallelLexer.h>
+#include <ParallelParser.h>
+#include <ReflectionWriter.h>
+#include <Codegen.h>
 namespace HKSL {
 bool CompilationResult::is_success() {
     return errors.empty();
 }
 
-Compiler::Compiler() {}
-CompilationResult Compiler::compile(const std::string& filename, const std::string& source) {
-    Lexer lexer(source.c_str());
+Compiler::Compiler(): Compiler(SymbolInterner::global()) {}
+Compiler::Compiler(SymbolInterner& _symbols): Compiler(_symbols, 0) {}
+Compiler::Compiler(SymbolInterner& _symbols, size_t n_threads): symbols(_symbols), thread_pool(n_threads) {}
+SourceManager& Compiler::sources() {
+    return source_manager;
+}
+void Compiler::set_fused_frontend(bool fused) {
+    this->fused_frontend = fused;
+}
+void Compiler::set_reorder_struct_fields(bool reorder) {
+    this->reorder_struct_fields = reorder;
+}
+void Compiler::set_push_constant_budget(uint32_t bytes) {
+    this->push_constant_budget = bytes;
+}
+void Compiler::set_emit_spirv(bool emit) {
+    this->emit_spirv = emit;
+}
+static StructReport report_struct(CompilationContext& context, const StructDecl& decl, bool reorder_fields) {
+    StructReport report;
+    report.name = context.symbols().str(decl.name.symbol);
+    for(const auto& field: context.type_registry().struct_info(decl.type).fields) {
+        report.fields.emplace_back(context.symbols().str(field.name));
+    }
+    for(size_t rule = 0; rule < LAYOUT_RULE_COUNT; rule++) {
+        report.layouts[rule] = layout_struct(context.type_registry(), decl.type, (LayoutRule) rule, reorder_fields);
+    }
 
-    auto tokens = lexer.collect_tokens();
-    CompilationContext context;
+    return report;
+}
+CompilationResult Compiler::compile(const std::string& filename, std::string source) {
+    return compile(source_manager.add_buffer(filename, std::move(source)));
+}
+CompilationResult Compiler::compile(uint32_t file) {
+    CompilationContext context(symbols, source_manager);
 
-    Parser parser(context, tokens.data());
-    auto ast = parser.program();
+    const SourceFile& source = source_manager.file(file);
+    AST ast;
+    if(thread_pool.size() > 1 && source.text().size() >= 2 * PARALLEL_LEX_MIN_CHUNK) {
+        auto tokens = lex_parallel(source, symbols, thread_pool);
+        ast = parse_parallel(context, tokens, thread_pool);
+    } else {
+        Lexer lexer(source, symbols);
+        Parser parser(context, lexer);
+        ast = parser.program();
+    }
     
     context.set_ast(std::move(ast));
     SemanticsVisitor semantics_visitor(context);
 
-    semantics_visitor.run();
-    context.abort_if_failure();
+    if(fused_frontend) {
+        semantics_visitor.run_fused(thread_pool);
+        context.abort_if_failure();
+    } else {
+        semantics_visitor.run(thread_pool);
+        context.abort_if_failure();
 
-    TypeInferenceVisitor type_inference_visitor(context);
-    type_inference_visitor.run();
-    context.abort_if_failure();
+        TypeInferenceVisitor type_inference_visitor(context);
+        type_inference_visitor.run(thread_pool);
+        context.abort_if_failure();
+    }
 
     auto result = CompilationResult {
-        .errors = std::move(context.errors())
+        .errors = context.take_errors(),
+        .structs = {},
+        .uniform_blocks = place_uniforms(context, push_constant_budget, reorder_struct_fields),
+        .reflection = {},
+        .spirv = {},
     };
+    AST& checked = context.get_ast();
+    for(NodeId statement: checked.top_level()) {
+        if(checked.kind(statement) == NodeKind::Struct) {
+            result.structs.push_back(report_struct(context, checked.struct_decl(statement), reorder_struct_fields));
+        }
+    }
+    result.reflection = write_reflection(context, result.structs, result.uniform_blocks);
+    if(emit_spirv) {
+#ifdef HKSL_SPIRV
+        result.spirv = generate_spirv(context, result.uniform_blocks, reorder_struct_fields);
+#else
+        context.append_errors({"HKSL was built without the SPIR-V backend, configure with -DHKSL_SPIRV=ON"});
+#endif
+        context.abort_if_failure();
+    }
 
     return result;
 }
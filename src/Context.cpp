@@ -1,25 +1,66 @@
 #include <Context.h>
 #include <format>
 #include <cassert>
+#include <iterator>
 
 namespace HKSL {
-CompilationContext::CompilationContext() {
-    this->ast = nullptr;
+static thread_local ErrorBuffer* current_error_buffer = nullptr;
+
+ErrorBuffer::ErrorBuffer(CompilationContext& _context): context(_context) {
+    this->previous = current_error_buffer;
+    current_error_buffer = this;
+}
+ErrorBuffer::~ErrorBuffer() {
+    current_error_buffer = previous;
 }
 
+CompilationContext::CompilationContext(SymbolInterner& symbols, SourceManager& sources): interner(symbols), source_manager(sources), ty_registry(symbols) {
+    this->has_ast = false;
+    this->is_failing = false;
+}
+
+SourceManager& CompilationContext::sources() {
+    return source_manager;
+}
+SourceLocation CompilationContext::locate(Span span) {
+    return source_manager.locate(span.file, span.offset);
+}
 void CompilationContext::error(Span location, const std::string &message) {
+    auto formatted = std::format("{}: {}", locate(location).to_string(), message);
+    if(current_error_buffer && &current_error_buffer->context == this) {
+        current_error_buffer->errors.push_back(std::move(formatted));
+        return;
+    }
+
     is_failing = true;
-    m_errors.push_back(std::format("{}: {}", location.to_string(), message));
+    m_errors.push_back(std::move(formatted));
+}
+void CompilationContext::append_errors(std::vector<std::string>&& errors) {
+    if(errors.empty()) {
+        return;
+    }
+
+    is_failing = true;
+    std::move(errors.begin(), errors.end(), std::back_inserter(m_errors));
 }
 const std::vector<std::string>& CompilationContext::errors() {
     return m_errors;
 }
-void CompilationContext::set_ast(std::unique_ptr<AST> ast) {
-    assert(!this->ast && "AST can only be set once");
+std::vector<std::string> CompilationContext::take_errors() {
+    return std::move(m_errors);
+}
+void CompilationContext::set_ast(AST ast) {
+    assert(!has_ast && "AST can only be set once");
     this->ast = std::move(ast);
+    this->has_ast = true;
+    sym_resolver.resize(this->ast.size());
+    ty_resolver.resize(this->ast.size());
 }
 AST& CompilationContext::get_ast() {
-    return *ast;
+    return ast;
+}
+SymbolInterner& CompilationContext::symbols() {
+    return interner;
 }
 SymbolResolver& CompilationContext::symbol_resolver() {
     return sym_resolver;
@@ -45,27 +86,24 @@ void CompilationContext::abort_if_failure() {
     }
 }
 
-void SymbolResolver::register_variable_ref(const Variable* variable, const VarDecl* decl) {
-    ref_to_decl[variable] = decl;
+void SymbolResolver::resize(size_t node_count) {
+    decls.assign(node_count, NO_NODE);
 }
-void SymbolResolver::register_function_ref(const CallExpr* call_expr, const Function* decl) {
-    call_to_func_decl[call_expr] = decl;
+void SymbolResolver::register_variable_ref(NodeId variable, NodeId decl) {
+    assert(variable < decls.size());
+    decls[variable] = decl;
 }
-
-const Function* SymbolResolver::get_function(const CallExpr* expr) {
-    auto it = call_to_func_decl.find(expr);
-    if(it != call_to_func_decl.end()) {
-        return it->second;
-    }
-
-    return nullptr;
+void SymbolResolver::register_function_ref(NodeId call_expr, NodeId decl) {
+    assert(call_expr < decls.size());
+    decls[call_expr] = decl;
 }
-const VarDecl* SymbolResolver::get_var_decl(const Variable* var) {
-    auto it = ref_to_decl.find(var);
-    if(it != ref_to_decl.end()) {
-        return it->second;
-    }
 
-    return nullptr;
+NodeId SymbolResolver::get_function(NodeId call_expr) {
+    assert(call_expr < decls.size());
+    return decls[call_expr];
+}
+NodeId SymbolResolver::get_var_decl(NodeId variable) {
+    assert(variable < decls.size());
+    return decls[variable];
 }
 }
@@ -4,11 +4,14 @@
 #include <cstdio>
 #include <cstring>
 #include <format>
-#include <cassert>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace HKSL {
 std::string read_to_string(const char* path) {
-    FILE* file = fopen(path, "r");
+    FILE* file = fopen(path, "rb");
     if(!file) {
         HKSL_ERROR(std::format("Failed to read file: {}", strerror(errno)));
     }
@@ -18,8 +21,66 @@ std::string read_to_string(const char* path) {
     fseek(file, 0, SEEK_SET);
 
     std::string str(nbytes, '\0');
-    assert(fread(str.data(), 1, nbytes, file) == nbytes);
+    size_t nread = fread(str.data(), 1, nbytes, file);
+    fclose(file);
+
+    if(nread != nbytes) {
+        HKSL_ERROR(std::format("Failed to read file: {}", path));
+    }
 
     return str;
 }
-}
\ No newline at end of file
+
+MappedFile::MappedFile(const char* path, size_t padding) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        HKSL_ERROR(std::format("Failed to read file: {}", strerror(errno)));
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0) {
+        close(fd);
+        HKSL_ERROR(std::format("Failed to read file: {}", strerror(errno)));
+    }
+
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    file_size = info.st_size;
+    mapped_size = (file_size + padding + page_size - 1) / page_size * page_size;
+
+    // Reserve zero filled pages for the file and its padding, then map the
+    // file over the start. The rest of the file's last page reads as zero too.
+    base = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) {
+        close(fd);
+        HKSL_ERROR(std::format("Failed to map file: {}", strerror(errno)));
+    }
+
+    if(file_size > 0 && mmap(base, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped_size);
+        close(fd);
+        HKSL_ERROR(std::format("Failed to map file: {}", strerror(errno)));
+    }
+
+    close(fd);
+}
+MappedFile::MappedFile(MappedFile&& other) {
+    base = other.base;
+    mapped_size = other.mapped_size;
+    file_size = other.file_size;
+
+    other.base = nullptr;
+    other.mapped_size = 0;
+    other.file_size = 0;
+}
+MappedFile::~MappedFile() {
+    if(base) {
+        munmap(base, mapped_size);
+    }
+}
+const char* MappedFile::data() const {
+    return (const char*) base;
+}
+size_t MappedFile::size() const {
+    return file_size;
+}
+}
@@ -1,8 +1,8 @@
 #include <Function.h>
 namespace HKSL {
-LibraryFunction::LibraryFunction(const std::string& name, std::initializer_list<Type*> args, Type* return_type): m_name(name), m_args(args), m_return_type(return_type) {}
-const char* LibraryFunction::name() const {
-    return m_name.c_str();
+LibraryFunction::LibraryFunction(Symbol name, std::initializer_list<Type*> args, Type* return_type): m_name(name), m_args(args), m_return_type(return_type) {}
+Symbol LibraryFunction::name() const {
+    return m_name;
 }
 size_t LibraryFunction::n_args() const {
     return m_args.size();
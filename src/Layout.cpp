@@ -0,0 +1,137 @@
+#include <Layout.h>
+#include <Util.h>
+#include <algorithm>
+#include <cassert>
+
+namespace HKSL {
+const char* layout_rule_to_string(LayoutRule rule) {
+    switch(rule) {
+        case LayoutRule::Std140:
+            return "std140";
+        case LayoutRule::Std430:
+            return "std430";
+        case LayoutRule::Scalar:
+            return "scalar";
+    }
+    HKSL_UNREACHABLE();
+}
+static uint32_t align_up(uint32_t value, uint32_t alignment) {
+    return alignment == 0 ? value : (value + alignment - 1) / alignment * alignment;
+}
+// Alignment of a vector of `width` components, which matrix columns share
+static uint32_t vector_align_of(uint32_t component, uint32_t width, LayoutRule rule) {
+    if(rule == LayoutRule::Scalar || width == 1) {
+        return component;
+    }
+    // float3 aligns like float4
+    return component * (width == 2 ? 2 : 4);
+}
+static uint32_t column_stride_of(const Type* type, LayoutRule rule) {
+    const TypeDesc& desc = type->desc();
+    uint32_t component = scalar_size_of(desc.scalar);
+    if(rule == LayoutRule::Scalar) {
+        return component * desc.rows;
+    }
+    uint32_t stride = vector_align_of(component, desc.rows, rule);
+    return rule == LayoutRule::Std140 ? align_up(stride, 16) : stride;
+}
+uint32_t layout_align_of(const TypeRegistry& registry, const Type* type, LayoutRule rule) {
+    const TypeDesc& desc = type->desc();
+    uint32_t component = scalar_size_of(desc.scalar);
+    switch(desc.kind) {
+        case TypeKind::Void:
+            return 1;
+        case TypeKind::Scalar:
+            return component;
+        case TypeKind::Vector:
+            return vector_align_of(component, desc.columns, rule);
+        case TypeKind::Matrix:
+            return rule == LayoutRule::Scalar ? component : column_stride_of(type, rule);
+        case TypeKind::Struct: {
+            uint32_t alignment = 1;
+            for(const auto& field: registry.struct_info(type).fields) {
+                alignment = std::max(alignment, layout_align_of(registry, field.type, rule));
+            }
+            // Same as layout_members computes, without laying out the fields
+            return rule == LayoutRule::Std140 ? align_up(alignment, 16) : alignment;
+        }
+    }
+    HKSL_UNREACHABLE();
+}
+uint32_t layout_size_of(const TypeRegistry& registry, const Type* type, LayoutRule rule, bool reorder_fields) {
+    switch(type->kind()) {
+        case TypeKind::Matrix:
+            return column_stride_of(type, rule) * type->desc().columns;
+        case TypeKind::Struct:
+            return layout_struct(registry, type, rule, reorder_fields).size;
+        default:
+            return type->size_of();
+    }
+}
+StructLayout layout_struct(const TypeRegistry& registry, const Type* type, LayoutRule rule, bool reorder_fields) {
+    std::vector<const Type*> fields;
+    for(const auto& field: registry.struct_info(type).fields) {
+        fields.push_back(field.type);
+    }
+
+    return layout_members(registry, fields, rule, reorder_fields);
+}
+// `reorder_fields` applies to `fields`, `reorder_nested` to the fields of
+// nested structs
+static StructLayout layout_fields(const TypeRegistry& registry, std::span<const Type* const> fields, LayoutRule rule, bool reorder_fields, bool reorder_nested) {
+    std::vector<uint32_t> sizes, alignments;
+    uint32_t alignment = 1;
+    for(const Type* field: fields) {
+        sizes.push_back(layout_size_of(registry, field, rule, reorder_nested));
+        alignments.push_back(layout_align_of(registry, field, rule));
+        alignment = std::max(alignment, alignments.back());
+    }
+    if(rule == LayoutRule::Std140) {
+        alignment = align_up(alignment, 16);
+    }
+
+    StructLayout layout = {.fields = {}, .size = 0, .alignment = alignment, .padding = 0};
+    std::vector<uint32_t> order(fields.size());
+    for(uint32_t i = 0; i < fields.size(); i++) {
+        order[i] = i;
+    }
+
+    uint32_t offset = 0;
+    uint32_t used = 0;
+    for(size_t placed = 0; placed < order.size(); placed++) {
+        if(reorder_fields) {
+            // Least padding first, then the most aligned and largest, which
+            // leaves the smallest fields for the holes later on
+            auto padding = [&] (uint32_t field) {
+                return align_up(offset, alignments[field]) - offset;
+            };
+            auto best = std::min_element(order.begin() + placed, order.end(), [&] (uint32_t a, uint32_t b) {
+                if(padding(a) != padding(b)) {
+                    return padding(a) < padding(b);
+                }
+                if(alignments[a] != alignments[b]) {
+                    return alignments[a] > alignments[b];
+                }
+                return sizes[a] > sizes[b];
+            });
+            std::rotate(order.begin() + placed, best, best + 1);
+        }
+
+        uint32_t field = order[placed];
+        offset = align_up(offset, alignments[field]);
+        layout.fields.push_back(FieldLayout {.field = field, .offset = offset, .size = sizes[field]});
+        offset += sizes[field];
+        used += sizes[field];
+    }
+
+    layout.size = align_up(offset, layout.alignment);
+    layout.padding = layout.size - used;
+    return layout;
+}
+StructLayout layout_members(const TypeRegistry& registry, std::span<const Type* const> fields, LayoutRule rule, bool reorder_fields) {
+    return layout_fields(registry, fields, rule, reorder_fields, reorder_fields);
+}
+StructLayout layout_block(const TypeRegistry& registry, std::span<const Type* const> members, LayoutRule rule, bool reorder_struct_fields) {
+    return layout_fields(registry, members, rule, true, reorder_struct_fields);
+}
+}
@@ -1,11 +1,11 @@
 #include "Util.h"
 #include <Parse/Lexer.h>
+#include <Parse/LexerTables.h>
+#include <Parse/Numeric.h>
+#include <bit>
 #include <format>
 
 namespace HKSL {
-std::string Span::to_string() const {
-    return std::format("{}:{}", line, col);
-}
 std::string token_kind_to_debug_string(TokenKind token) {
   switch (token) {
   case TokenKind::Plus:
@@ -64,6 +64,10 @@ std::string token_kind_to_debug_string(TokenKind token) {
     return "KeywordLet";
   case TokenKind::KeywordReturn:
     return "KeyworReturn";
+  case TokenKind::KeywordStruct:
+    return "KeywordStruct";
+  case TokenKind::KeywordUniform:
+    return "KeywordUniform";
   case TokenKind::Eof:
     return "Eof";
   default:
@@ -129,6 +133,10 @@ std::string token_kind_to_string(TokenKind token) {
     return "let";
   case TokenKind::KeywordReturn:
     return "return";
+  case TokenKind::KeywordStruct:
+    return "struct";
+  case TokenKind::KeywordUniform:
+    return "uniform";
   case TokenKind::Eof:
     return "Eof";
   default:
@@ -136,23 +144,29 @@ std::string token_kind_to_string(TokenKind token) {
   }
 }
 
-std::string Token::to_string() const {
+std::string Token::to_string(const SymbolInterner& symbols) const {
   std::string output;
   output += "Token { kind: ";
   output += token_kind_to_debug_string(kind);
   if (kind == TokenKind::Number) {
-    output += std::format(" ({})", std::get<NumberLiteral>(data).value);
+    output += std::format(" ({})", std::get<NumberLiteral>(data).value());
   } else if(kind == TokenKind::Identifier) {
-    output += std::format("({})", std::get<Identifier>(data).name);
+    output += std::format("({})", symbols.str(std::get<Identifier>(data).symbol));
   }
-  output += ", ";
-  output += span.to_string();
-  output += " }";
+  output += std::format(", @{}+{} }}", span.offset, span.length);
 
   
   return output;
 }
 
+float NumberLiteral::value() const {
+    if(kind == NumberKind::Half) {
+        return half_bits_to_float(bits);
+    }
+
+    return std::bit_cast<float>(bits);
+}
+
 const Identifier& Token::unwrap_identifier() const {
     if(kind == TokenKind::Identifier) {
         return std::get<Identifier>(data);
@@ -168,28 +182,166 @@ const NumberLiteral& Token::unwrap_number_literal() const {
     }
 }
 
-Lexer::Lexer(const char *code) {
-  remaining = code;
-  line = 1;
-  col = 1;
+static uint32_t fixed_token_length(TokenKind kind) {
+    switch(kind) {
+        case TokenKind::Eof:
+            return 0;
+        case TokenKind::DoubleEquals:
+        case TokenKind::PlusEqual:
+        case TokenKind::MinusEqual:
+        case TokenKind::StarEqual:
+        case TokenKind::SlashEqual:
+        case TokenKind::RightArrow:
+        case TokenKind::KeywordIf:
+        case TokenKind::KeywordFn:
+            return 2;
+        case TokenKind::KeywordLet:
+            return 3;
+        case TokenKind::KeywordElse:
+            return 4;
+        case TokenKind::KeywordReturn:
+        case TokenKind::KeywordStruct:
+            return 6;
+        case TokenKind::KeywordUniform:
+            return 7;
+        default:
+            return 1;
+    }
 }
 
-char Lexer::current() { return *remaining; }
-char Lexer::next() { return *(remaining + 1); }
-void Lexer::advance() {
-    if(current() == '\0') {
-        HKSL_ERROR("Reached EOF while lexing");
+TokenBuffer::TokenBuffer(uint32_t file) {
+    this->file = file;
+}
+void TokenBuffer::push(const Token& token) {
+    kinds.push_back(token.kind);
+    offsets.push_back(token.span.offset);
+
+    uint32_t payload = 0;
+    if(token.kind == TokenKind::Identifier) {
+        payload = identifiers.size();
+        identifiers.push_back(IdentifierEntry {
+            .symbol = std::get<Identifier>(token.data).symbol,
+            .length = token.span.length,
+        });
+    } else if(token.kind == TokenKind::Number) {
+        payload = literals.size();
+        literals.push_back(LiteralEntry {
+            .value = std::get<NumberLiteral>(token.data),
+            .length = token.span.length,
+        });
+    }
+    payloads.push_back(payload);
+}
+TokenBuffer TokenBuffer::concatenate(uint32_t file, std::span<const TokenBuffer> parts, ThreadPool& pool) {
+    struct Base {
+        size_t token;
+        uint32_t identifier;
+        uint32_t literal;
+    };
+    std::vector<Base> bases;
+    Base total = {0, 0, 0};
+    for(const auto& part: parts) {
+        bases.push_back(total);
+        total.token += part.size();
+        total.identifier += part.identifiers.size();
+        total.literal += part.literals.size();
+    }
+
+    TokenBuffer tokens(file);
+    tokens.kinds.resize(total.token);
+    tokens.offsets.resize(total.token);
+    tokens.payloads.resize(total.token);
+    tokens.identifiers.resize(total.identifier);
+    tokens.literals.resize(total.literal);
+
+    pool.parallel_for(parts.size(), [&] (size_t i) {
+        const TokenBuffer& part = parts[i];
+        Base base = bases[i];
+        std::copy(part.kinds.begin(), part.kinds.end(), tokens.kinds.begin() + base.token);
+        std::copy(part.offsets.begin(), part.offsets.end(), tokens.offsets.begin() + base.token);
+        std::copy(part.identifiers.begin(), part.identifiers.end(), tokens.identifiers.begin() + base.identifier);
+        std::copy(part.literals.begin(), part.literals.end(), tokens.literals.begin() + base.literal);
+
+        for(size_t j = 0; j < part.size(); j++) {
+            uint32_t payload = part.payloads[j];
+            if(part.kinds[j] == TokenKind::Identifier) {
+                payload += base.identifier;
+            } else if(part.kinds[j] == TokenKind::Number) {
+                payload += base.literal;
+            }
+            tokens.payloads[base.token + j] = payload;
+        }
+    });
+
+    return tokens;
+}
+size_t TokenBuffer::size() const {
+    return kinds.size();
+}
+TokenKind TokenBuffer::kind(size_t i) const {
+    return kinds[i];
+}
+uint32_t TokenBuffer::offset(size_t i) const {
+    return offsets[i];
+}
+Span TokenBuffer::span(size_t i) const {
+    uint32_t length;
+    if(kinds[i] == TokenKind::Identifier) {
+        length = identifiers[payloads[i]].length;
+    } else if(kinds[i] == TokenKind::Number) {
+        length = literals[payloads[i]].length;
+    } else {
+        length = fixed_token_length(kinds[i]);
+    }
+
+    return Span {.file = file, .offset = offsets[i], .length = length};
+}
+Identifier TokenBuffer::identifier(size_t i) const {
+    if(kinds[i] != TokenKind::Identifier) {
+        HKSL_ERROR("Variant is not an identifier");
     }
 
-    if (current() == '\n') {
-        line++;
-        col = 1;
+    return Identifier {.symbol = identifiers[payloads[i]].symbol, .span = span(i)};
+}
+const NumberLiteral& TokenBuffer::number_literal(size_t i) const {
+    if(kinds[i] != TokenKind::Number) {
+        HKSL_ERROR("Variant is not a number literal");
+    }
+
+    return literals[payloads[i]].value;
+}
+Token TokenBuffer::token(size_t i) const {
+    Token token;
+    token.kind = kinds[i];
+    token.span = span(i);
+
+    if(token.kind == TokenKind::Identifier) {
+        token.data = identifier(i);
+    } else if(token.kind == TokenKind::Number) {
+        token.data = number_literal(i);
     } else {
-        col++;
+        token.data = NoTokenData();
     }
 
+    return token;
+}
+Lexer::Lexer(const SourceFile& source, SymbolInterner& symbols): Lexer(source, symbols, 0, source.text().size()) {}
+Lexer::Lexer(const SourceFile& source, SymbolInterner& _symbols, uint32_t begin, uint32_t end): symbols(_symbols), scanner(Scanner::best()) {
+  start = source.text().data();
+  remaining = start + begin;
+  this->end = start + end;
+  file = source.id();
+}
+
+char Lexer::current() { return *remaining; }
+char Lexer::next() { return *(remaining + 1); }
+// Only called after matching a non zero byte, so it never steps past the end
+void Lexer::advance() {
     remaining++;
 }
+void Lexer::advance_to(const char* target) {
+    remaining = target;
+}
 bool Lexer::matches(char ch) { 
     return current() == ch; 
 }
@@ -212,169 +364,259 @@ bool Lexer::consume_two(char first, char second) {
     return false;
 }
 bool Lexer::is_eof() { 
-    return current() == '\0'; 
+    return remaining >= end || current() == '\0'; 
 }
 
 void Lexer::white_space() {
-    while (matches('\n') || matches(' ')) {
-        advance();
-    }
+    advance_to(scanner.skip_white_space(remaining));
 }
 void Lexer::skip_to_next_line() {
-    while(!matches('\n')) {
-        advance();
-    }
+    advance_to(scanner.skip_line(remaining));
 }
 bool Lexer::is_digit(char ch) { 
-    return ch >= '0' && ch <= '9'; 
+    return LexerTables::CHAR_CLASSES[(uint8_t) ch] == LexerTables::CharClass::Digit;
 }
-bool Lexer::is_identifier_start(char ch) {
-    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <='Z') || (ch == '_');
+static bool is_hex_digit(char ch) {
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
 }
-bool Lexer::is_identifier(char ch) {
-    return is_identifier_start(ch) || is_digit(ch);
-}
-double Lexer::to_digit(char ch) { 
-    return ch - '0'; 
-}
-double Lexer::number_literal() {
-    double value;
+NumberLiteral Lexer::number_literal() {
+    const char* literal_start = remaining;
+    bool hex = matches('0') && (next() == 'x' || next() == 'X');
 
-    double whole_part = 0;
-    double fractional_part = 0;
-
-    while (is_digit(current())) {
-        double digit = to_digit(current());
-        whole_part = whole_part * 10 + digit;
+    if(hex) {
+        advance();
         advance();
+        const char* digits_start = remaining;
+        while(is_hex_digit(current())) {
+            advance();
+        }
+        if(consume('.')) {
+            while(is_hex_digit(current())) {
+                advance();
+            }
+        }
+        if(remaining == digits_start) {
+            lex_error(literal_start, "Expected hex digits after 0x");
+        }
+    } else {
+        while(is_digit(current())) {
+            advance();
+        }
+        if(consume('.')) {
+            while(is_digit(current())) {
+                advance();
+            }
+        }
+    }
+
+    // Exponent: e for decimal, p (binary) for hex
+    char exponent = hex ? 'p' : 'e';
+    bool has_exponent = false;
+    if(current() == exponent || current() == exponent - 'a' + 'A') {
+        const char* sign = remaining + 1;
+        const char* exponent_digits = (*sign == '+' || *sign == '-') ? sign + 1 : sign;
+        if(is_digit(*exponent_digits)) {
+            has_exponent = true;
+            advance_to(exponent_digits);
+            while(is_digit(current())) {
+                advance();
+            }
+        }
+    }
+    // f is a hex digit, so a suffix can only follow the exponent
+    if(hex && !has_exponent) {
+        lex_error(literal_start, std::format("Hex float literal needs a p exponent: {}", std::string_view(literal_start, remaining - literal_start)));
+    }
+
+    const char* digits_start = hex ? literal_start + 2 : literal_start;
+    std::string_view digits(digits_start, remaining - digits_start);
+
+    NumberKind kind = NumberKind::Float;
+    if(consume('h')) {
+        kind = NumberKind::Half;
+    } else {
+        consume('f');
+    }
+
+    auto literal = parse_number(digits, hex, kind);
+    if(!literal) {
+        lex_error(literal_start, std::format("Number literal out of range: {}", std::string_view(literal_start, remaining - literal_start)));
+    }
+
+    return *literal;
+}
+std::optional<TokenKind> Lexer::is_keyword(std::string_view identifier) {
+    const auto& candidate = LexerTables::KEYWORD_TABLE[LexerTables::keyword_hash(LexerTables::KEYWORD_SEED, identifier)];
+
+    if(candidate.text == identifier) {
+        return candidate.kind;
     }
 
-    if (consume('.')) {
-        double divider = 10;
-        while (is_digit(current())) {
-        double digit = to_digit(current());
-        fractional_part += digit / divider;
-        divider *= 10;
+    return std::nullopt;
+}
+TokenKind Lexer::operator_token() {
+    const auto& dfa = LexerTables::OPERATOR_DFA;
+
+    // Maximal munch: remember the last accepting state we walked through
+    size_t state = dfa.next[0][(uint8_t) current()];
+    size_t accepted = state;
+    const char* accepted_end = remaining + 1;
+    advance();
+
+    while(size_t next = dfa.next[state][(uint8_t) current()]) {
+        state = next;
         advance();
+        if(dfa.accepting[state]) {
+            accepted = state;
+            accepted_end = remaining;
         }
     }
+    remaining = accepted_end;
 
-    return whole_part + fractional_part;
-}
-std::optional<TokenKind> Lexer::is_keyword(const std::string& identifier) {
-    std::optional<TokenKind> ret = std::nullopt;
-
-    if(identifier == "fn") {
-        ret = TokenKind::KeywordFn;
-    } else if(identifier == "if") {
-        ret = TokenKind::KeywordIf;
-    } else if(identifier == "else") {
-        ret = TokenKind::KeywordElse;
-    } else if(identifier == "let") {
-        ret = TokenKind::KeywordLet;
-    } else if(identifier == "return") {
-        ret = TokenKind::KeywordReturn;
+    if(!dfa.accepting[accepted]) {
+        lex_error(accepted_end - 1, std::format("Unexpected token: {}", *(accepted_end - 1)));
     }
 
-    return ret;
+    return dfa.accept[accepted];
 }
 std::pair<TokenKind, TokenData> Lexer::identifier() {
-    std::string name;
-    Span span = current_span();
+    const char* name_start = remaining;
     
-    name+= current();
     advance();
+    advance_to(scanner.skip_identifier(remaining));
 
-    while(is_identifier(current())) {
-        name += current();
-        advance();
-    }
+    Span span = span_from(name_start);
+    // View into the source, only copied by the interner the first time it's seen
+    std::string_view name(name_start, remaining - name_start);
     std::optional<TokenKind> keyword = is_keyword(name);
 
     if(keyword.has_value()) {
         return std::make_pair<TokenKind, TokenData>(std::move(keyword.value()), NoTokenData());
     } else {
-        return std::make_pair<TokenKind, TokenData>(TokenKind::Identifier, Identifier {.name = name, .span = span});
+        return std::make_pair<TokenKind, TokenData>(TokenKind::Identifier, Identifier {.symbol = symbols.intern(name), .span = span});
     };
 }
 
 
-Span Lexer::current_span() { return Span{.line = line, .col = col}; }
+Span Lexer::span_from(const char* token_start) {
+    return Span {
+        .file = file,
+        .offset = (uint32_t) (token_start - start),
+        .length = (uint32_t) (remaining - token_start),
+    };
+}
 
 Token Lexer::token() {
+    Token token;
+    if(auto error = try_token(token)) {
+        HKSL_ERROR(error->message);
+    }
+
+    return token;
+}
+std::optional<LexError> Lexer::try_token(Token& token) {
+    try {
+        token = next_token();
+    } catch(LexError& error) {
+        return error;
+    }
+
+    return std::nullopt;
+}
+void Lexer::lex_error(const char* at, std::string message) {
+    throw LexError {.offset = (uint32_t) (at - start), .message = std::move(message)};
+}
+Token Lexer::next_token() {
     white_space();
     while(consume_two('/', '/')) {
         skip_to_next_line(); 
         white_space();
     } 
     Token token;
-    token.span = current_span();
+    const char* token_start = remaining;
 
-    if (is_eof()) {
+    // White space and comments may run past the end of a range, into bytes
+    // the next range lexes
+    if(remaining >= end) {
         token.kind = TokenKind::Eof;
-    } else if (consume_two('+', '=')) {
-        token.kind = TokenKind::PlusEqual;
-    } else if (consume_two('-', '=')) {
-        token.kind = TokenKind::MinusEqual;
-    } else if (consume_two('*', '=')) {
-        token.kind = TokenKind::StarEqual;
-    } else if (consume_two('/', '=')) {
-        token.kind = TokenKind::SlashEqual;
-    } else if (consume_two('=', '=')) {
-        token.kind = TokenKind::DoubleEquals;
-    }else if (consume_two('-', '>')) {
-        token.kind = TokenKind::RightArrow;
-    } else if (consume('+')) {
-        token.kind = TokenKind::Plus;
-    } else if (consume('-')) {
-        token.kind = TokenKind::Minus;
-    } else if (consume('*')) {
-        token.kind = TokenKind::Star;
-    } else if (consume('/')) {
-        token.kind = TokenKind::Slash;
-    } else if(consume(',')) {
-        token.kind = TokenKind::Comma;
-    } else if(consume('.')) {
-        token.kind = TokenKind::Dot;
-    } else if(consume(';')) {
-        token.kind = TokenKind::Semicolon;
-    } else if(consume(':')) {
-        token.kind = TokenKind::Colon;
-    }else if(consume('=')) {
-        token.kind = TokenKind::Equals;
-    } else if (consume('(')) {
-        token.kind = TokenKind::LeftRound;
-    } else if (consume(')')) {
-        token.kind = TokenKind::RightRound;
-    } else if (consume('[')) {
-        token.kind = TokenKind::LeftSquare;
-    } else if (consume(']')) {
-        token.kind = TokenKind::RightSquare;
-    } else if (consume('{')) {
-        token.kind = TokenKind::LeftCurly;
-    } else if (consume('}')) {
-        token.kind = TokenKind::RightCurly;
-    } else if (is_digit(current())) {
-        double value = number_literal();
-        token.kind = TokenKind::Number;
-        token.data = NumberLiteral{.value = value};
-    } else if (is_identifier_start(current())){
-        auto [kind, data] = identifier();
-        token.kind = kind;
-        token.data = data;
-    } else {
-        HKSL_ERROR(std::format("Unexpected token: {}", current()));
+        token.span = Span {.file = file, .offset = (uint32_t) (end - start), .length = 0};
+        return token;
+    }
+
+    switch(LexerTables::CHAR_CLASSES[(uint8_t) current()]) {
+        case LexerTables::CharClass::End:
+            token.kind = TokenKind::Eof;
+            break;
+        case LexerTables::CharClass::Operator:
+            token.kind = operator_token();
+            break;
+        case LexerTables::CharClass::Digit:
+            token.kind = TokenKind::Number;
+            token.data = number_literal();
+            break;
+        case LexerTables::CharClass::IdentifierStart: {
+            auto [kind, data] = identifier();
+            token.kind = kind;
+            token.data = data;
+            break;
+        }
+        default:
+            lex_error(remaining, std::format("Unexpected token: {}", current()));
     }
+    token.span = span_from(token_start);
 
     return token;
 }
 
-std::vector<Token> Lexer::collect_tokens() {
-    std::vector<Token> tokens;
+TokenStream::TokenStream(Lexer& lexer) {
+    this->lexer = &lexer;
+    this->tokens = nullptr;
+    this->position = 0;
+    this->head = 0;
+    for(auto& token: window) {
+        token = pull();
+    }
+}
+TokenStream::TokenStream(const TokenBuffer& tokens): TokenStream(tokens, 0) {}
+TokenStream::TokenStream(const TokenBuffer& tokens, size_t begin) {
+    this->lexer = nullptr;
+    this->tokens = &tokens;
+    this->position = begin;
+    this->head = 0;
+    for(auto& token: window) {
+        token = pull();
+    }
+}
+const Token& TokenStream::current() const {
+    return window[head];
+}
+const Token& TokenStream::next() const {
+    return window[(head + 1) % WINDOW_SIZE];
+}
+void TokenStream::advance() {
+    // The slot of the current token is free to take the one after `next`
+    window[head] = pull();
+    head = (head + 1) % WINDOW_SIZE;
+}
+Token TokenStream::pull() {
+    if(lexer) {
+        return lexer->token();
+    }
+
+    // The buffer ends with Eof, hold on to it
+    Token token = tokens->token(position);
+    if(position + 1 < tokens->size()) {
+        position++;
+    }
+    return token;
+}
+
+TokenBuffer Lexer::collect_tokens() {
+    TokenBuffer tokens(file);
 
     while(true) {
         auto toke = token();
-        tokens.push_back(toke);
+        tokens.push(toke);
         if(toke.kind == TokenKind::Eof) {
             break;
         }
@@ -0,0 +1,269 @@
+#include <Parse/Numeric.h>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <string>
+
+namespace HKSL {
+static constexpr int HALF_MANTISSA_BITS = 10;
+static constexpr int HALF_MIN_EXPONENT = -14;
+static constexpr int HALF_MAX_EXPONENT = 15;
+
+float half_bits_to_float(uint16_t bits) {
+    float sign = (bits & 0x8000) ? -1.0f : 1.0f;
+    int exponent = (bits >> HALF_MANTISSA_BITS) & 0x1F;
+    int mantissa = bits & 0x3FF;
+
+    if(exponent == 0) {
+        return sign * std::ldexp((float) mantissa, HALF_MIN_EXPONENT - HALF_MANTISSA_BITS);
+    }
+    if(exponent == 0x1F) {
+        return mantissa ? NAN : sign * INFINITY;
+    }
+
+    return sign * std::ldexp((float) (mantissa | 0x400), exponent - 15 - HALF_MANTISSA_BITS);
+}
+
+// Scales |value| so that one half ulp is 1.0, every step is exact
+static double half_ulps(double value, int* exponent) {
+    double magnitude = std::fabs(value);
+    if(magnitude < std::ldexp(1.0, HALF_MIN_EXPONENT)) {
+        *exponent = HALF_MIN_EXPONENT - 1;
+        return std::ldexp(magnitude, -HALF_MIN_EXPONENT + HALF_MANTISSA_BITS);
+    }
+
+    std::frexp(magnitude, exponent);
+    (*exponent)--;
+    return std::ldexp(magnitude, HALF_MANTISSA_BITS - *exponent);
+}
+static uint16_t encode_half(bool negative, int exponent, double mantissa) {
+    uint16_t sign = negative ? 0x8000 : 0;
+    uint32_t units = (uint32_t) mantissa;
+
+    // Rounding carried into the next binade
+    if(units == 0x800) {
+        units = 0x400;
+        exponent++;
+    }
+    if(exponent > HALF_MAX_EXPONENT) {
+        return sign | 0x7C00;
+    }
+    if(exponent < HALF_MIN_EXPONENT) {
+        // Subnormal, or rounded up into the smallest normal (units == 0x400)
+        return sign | units;
+    }
+
+    return sign | ((exponent + 15) << HALF_MANTISSA_BITS) | (units & 0x3FF);
+}
+uint16_t double_to_half_bits(double value) {
+    if(std::isnan(value)) {
+        return 0x7E00;
+    }
+
+    int exponent;
+    double mantissa = std::nearbyint(half_ulps(value, &exponent));
+    return encode_half(std::signbit(value), exponent, mantissa);
+}
+
+// Significant digits and the decimal exponent of the first one
+struct Decimal {
+    std::string digits;
+    int exponent;
+};
+static Decimal normalize_decimal(std::string_view text) {
+    std::string all;
+    size_t point = std::string_view::npos;
+    size_t i = 0;
+
+    for(; i < text.size() && text[i] != 'e' && text[i] != 'E'; i++) {
+        if(text[i] == '.') {
+            point = all.size();
+        } else {
+            all += text[i];
+        }
+    }
+    if(point == std::string_view::npos) {
+        point = all.size();
+    }
+
+    int written_exponent = 0;
+    if(i + 1 < text.size()) {
+        const char* exponent_start = text.data() + i + 1;
+        if(*exponent_start == '+') {
+            exponent_start++;
+        }
+        std::from_chars(exponent_start, text.data() + text.size(), written_exponent);
+    }
+
+    size_t leading_zeros = all.find_first_not_of('0');
+    if(leading_zeros == std::string::npos) {
+        return Decimal { .digits = "", .exponent = 0 };
+    }
+    size_t last_digit = all.find_last_not_of('0');
+
+    return Decimal {
+        .digits = all.substr(leading_zeros, last_digit - leading_zeros + 1),
+        .exponent = (int) point - 1 - (int) leading_zeros + written_exponent,
+    };
+}
+// Sign of (text - value), exact
+static int compare_decimal(std::string_view text, double value) {
+    char buffer[64];
+    // Halfway points between halves are multiples of 2^-25 below 2^16, they
+    // have well under 45 significant digits, so this expansion is exact
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific, 45);
+    Decimal exact = normalize_decimal(std::string_view(buffer, result.ptr - buffer));
+    Decimal literal = normalize_decimal(text);
+
+    if(literal.exponent != exact.exponent) {
+        return literal.exponent < exact.exponent ? -1 : 1;
+    }
+    int order = literal.digits.compare(exact.digits);
+    return order < 0 ? -1 : (order > 0 ? 1 : 0);
+}
+
+// Significant bits and the binary exponent of the first one
+struct Binary {
+    std::string bits;
+    long long exponent;
+};
+static Binary normalize_hex(std::string_view text) {
+    std::string all;
+    size_t point = std::string_view::npos;
+    size_t i = 0;
+
+    for(; i < text.size() && text[i] != 'p' && text[i] != 'P'; i++) {
+        if(text[i] == '.') {
+            point = all.size();
+            continue;
+        }
+        int digit = 0;
+        std::from_chars(&text[i], &text[i] + 1, digit, 16);
+        for(int bit = 3; bit >= 0; bit--) {
+            all += (digit >> bit) & 1 ? '1' : '0';
+        }
+    }
+    if(point == std::string_view::npos) {
+        point = all.size();
+    }
+
+    long long written_exponent = 0;
+    if(i + 1 < text.size()) {
+        const char* exponent_start = text.data() + i + 1;
+        if(*exponent_start == '+') {
+            exponent_start++;
+        }
+        std::from_chars(exponent_start, text.data() + text.size(), written_exponent);
+    }
+
+    size_t leading_zeros = all.find('1');
+    if(leading_zeros == std::string::npos) {
+        return Binary { .bits = "", .exponent = 0 };
+    }
+    size_t last_bit = all.find_last_of('1');
+
+    return Binary {
+        .bits = all.substr(leading_zeros, last_bit - leading_zeros + 1),
+        .exponent = (long long) point - 1 - (long long) leading_zeros + written_exponent,
+    };
+}
+// Sign of (text - value) for a hex literal, exact
+static int compare_hex(std::string_view text, double value) {
+    char buffer[64];
+    // Hex output of a double is always exact
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::hex);
+    Binary exact = normalize_hex(std::string_view(buffer, result.ptr - buffer));
+    Binary literal = normalize_hex(text);
+
+    if(literal.exponent != exact.exponent) {
+        return literal.exponent < exact.exponent ? -1 : 1;
+    }
+    int order = literal.bits.compare(exact.bits);
+    return order < 0 ? -1 : (order > 0 ? 1 : 0);
+}
+
+// from_chars reports both overflow and underflow as out of range. A literal
+// underflows if it's below 1, i.e. its leading digit sits below the point.
+static bool is_below_one(std::string_view text, bool hex) {
+    long long position = 0;
+    size_t i = 0;
+    bool seen_digit = false;
+    bool seen_point = false;
+    for(; i < text.size() && text[i] != (hex ? 'p' : 'e') && text[i] != (hex ? 'P' : 'E'); i++) {
+        if(text[i] == '.') {
+            seen_point = true;
+        } else if(seen_digit || text[i] != '0') {
+            seen_digit = true;
+            position += seen_point ? 0 : 1;
+        } else if(seen_point) {
+            position--;
+        }
+    }
+
+    long long written_exponent = 0;
+    if(i + 1 < text.size()) {
+        const char* exponent_start = text.data() + i + 1;
+        bool negative = *exponent_start == '-';
+        if(*exponent_start == '+' || negative) {
+            exponent_start++;
+        }
+        auto result = std::from_chars(exponent_start, text.data() + text.size(), written_exponent);
+        if(result.ec != std::errc()) {
+            return negative;
+        }
+        written_exponent = negative ? -written_exponent : written_exponent;
+    }
+
+    // Hex digits are 4 bits each, the p exponent is in bits
+    return (hex ? position * 4 : position) + written_exponent <= 0;
+}
+
+std::optional<NumberLiteral> parse_number(std::string_view digits, bool hex, NumberKind kind) {
+    auto format = hex ? std::chars_format::hex : std::chars_format::general;
+    const char* first = digits.data();
+    const char* last = digits.data() + digits.size();
+
+    if(kind == NumberKind::Float) {
+        float value;
+        auto result = std::from_chars(first, last, value, format);
+        if(result.ec == std::errc::result_out_of_range && is_below_one(digits, hex)) {
+            value = 0.0f;
+        } else if(result.ec != std::errc()) {
+            return std::nullopt;
+        }
+
+        return NumberLiteral { .kind = kind, .bits = std::bit_cast<uint32_t>(value) };
+    }
+
+    // There's no binary16 from_chars. Round the correctly rounded double
+    // instead, which only differs from rounding the literal directly when
+    // the double lands exactly halfway between two halves. Decimal and hex
+    // literals longer than a double can both do that.
+    double value;
+    auto result = std::from_chars(first, last, value, format);
+    if(result.ec == std::errc::result_out_of_range && is_below_one(digits, hex)) {
+        value = 0.0;
+    } else if(result.ec != std::errc()) {
+        return std::nullopt;
+    }
+
+    int exponent;
+    double scaled = half_ulps(value, &exponent);
+    double mantissa = std::nearbyint(scaled);
+    if(scaled - std::floor(scaled) == 0.5) {
+        // Break the tie with the literal itself, which has more significant
+        // bits than the double if they differ
+        int order = hex ? compare_hex(digits, value) : compare_decimal(digits, value);
+        if(order != 0) {
+            mantissa = order > 0 ? std::ceil(scaled) : std::floor(scaled);
+        }
+    }
+
+    uint16_t bits = encode_half(false, exponent, mantissa);
+    if((bits & 0x7C00) == 0x7C00) {
+        return std::nullopt;
+    }
+
+    return NumberLiteral { .kind = kind, .bits = bits };
+}
+}
@@ -0,0 +1,85 @@
+#include <Parse/ParallelLexer.h>
+#include <cstring>
+
+namespace HKSL {
+// Start offsets of the chunks plus the end of the source, each chunk begins
+// at the start of a line
+static std::vector<uint32_t> chunk_bounds(std::string_view text, size_t n_chunks) {
+    std::vector<uint32_t> bounds = {0};
+    size_t chunk_size = text.size() / n_chunks;
+
+    for(size_t i = 1; i < n_chunks; i++) {
+        size_t target = std::max<size_t>(i * chunk_size, bounds.back());
+        const void* newline = std::memchr(text.data() + target, '\n', text.size() - target);
+        if(!newline) {
+            break;
+        }
+
+        uint32_t bound = (const char*) newline - text.data() + 1;
+        if(bound > bounds.back() && bound < text.size()) {
+            bounds.push_back(bound);
+        }
+    }
+    bounds.push_back(text.size());
+
+    return bounds;
+}
+
+TokenBuffer lex_parallel(const SourceFile& source, SymbolInterner& symbols, ThreadPool& pool) {
+    std::string_view text = source.text();
+    // A few chunks per thread evens out chunks that lex slower than others
+    size_t n_chunks = std::min(pool.size() * 4, std::max<size_t>(text.size() / PARALLEL_LEX_MIN_CHUNK, 1));
+    if(n_chunks == 1) {
+        Lexer lexer(source, symbols);
+        return lexer.collect_tokens();
+    }
+
+    auto bounds = chunk_bounds(text, n_chunks);
+    n_chunks = bounds.size() - 1;
+
+    std::vector<TokenBuffer> chunks(n_chunks, TokenBuffer(source.id()));
+    // Offset of each chunk's Eof, before the chunk's end only if it ran into
+    // a zero byte, which ends the source for the sequential lexer too
+    std::vector<uint32_t> stops(n_chunks);
+    // First malformed token of each chunk, where that chunk stops
+    std::vector<std::optional<LexError>> errors(n_chunks);
+    pool.parallel_for(n_chunks, [&] (size_t i) {
+        Lexer lexer(source, symbols, bounds[i], bounds[i + 1]);
+        while(true) {
+            Token token;
+            errors[i] = lexer.try_token(token);
+            if(errors[i]) {
+                break;
+            }
+            if(token.kind == TokenKind::Eof) {
+                stops[i] = token.span.offset;
+                break;
+            }
+            chunks[i].push(token);
+        }
+    });
+
+    // Chunks after one that hit a zero byte aren't part of the source. The
+    // chunks are in source order, so the first error found is the one the
+    // sequential lexer would stop at.
+    size_t n_used = 0;
+    while(n_used < n_chunks) {
+        if(errors[n_used]) {
+            HKSL_ERROR(errors[n_used]->message);
+        }
+        n_used++;
+        if(stops[n_used - 1] != bounds[n_used]) {
+            break;
+        }
+    }
+
+    auto tokens = TokenBuffer::concatenate(source.id(), std::span(chunks).first(n_used), pool);
+    tokens.push(Token {
+        .kind = TokenKind::Eof,
+        .data = NoTokenData(),
+        .span = Span {.file = source.id(), .offset = stops[n_used - 1], .length = 0},
+    });
+
+    return tokens;
+}
+}
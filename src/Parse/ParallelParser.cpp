@@ -0,0 +1,77 @@
+#include <Parse/ParallelParser.h>
+
+namespace HKSL {
+// First tokens of the chunks plus the buffer's Eof, roughly equal in token
+// count and each starting at a top level `fn`. Files declaring structs are
+// one chunk, a struct's type must be registered before anything after it
+// is parsed.
+static std::vector<size_t> chunk_bounds(const TokenBuffer& tokens, size_t n_chunks) {
+    std::vector<size_t> bounds = {0};
+    size_t eof = tokens.size() - 1;
+    size_t chunk_size = eof / n_chunks;
+
+    int depth = 0;
+    for(size_t i = 0; i < eof; i++) {
+        switch(tokens.kind(i)) {
+            case TokenKind::LeftCurly:
+            case TokenKind::LeftRound:
+                depth++;
+                break;
+            case TokenKind::RightCurly:
+            case TokenKind::RightRound:
+                depth--;
+                break;
+            case TokenKind::KeywordFn:
+                if(depth == 0 && i > 0 && i >= bounds.back() + chunk_size) {
+                    bounds.push_back(i);
+                }
+                break;
+            case TokenKind::KeywordStruct:
+                if(depth == 0) {
+                    return {0, eof};
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    bounds.push_back(eof);
+
+    return bounds;
+}
+
+AST parse_parallel(CompilationContext& context, const TokenBuffer& tokens, ThreadPool& pool) {
+    uint32_t file = tokens.span(0).file;
+    // A few chunks per thread evens out chunks that parse slower than others
+    size_t n_chunks = std::min(pool.size() * 4, std::max<size_t>(tokens.size() / PARALLEL_PARSE_MIN_CHUNK, 1));
+    std::vector<size_t> bounds;
+    if(n_chunks > 1) {
+        bounds = chunk_bounds(tokens, n_chunks);
+    }
+    if(bounds.size() <= 2) {
+        Parser parser(context, tokens);
+        return parser.program();
+    }
+    n_chunks = bounds.size() - 1;
+
+    std::vector<AST> chunks(n_chunks);
+    std::vector<std::optional<SyntaxError>> errors(n_chunks);
+    pool.parallel_for(n_chunks, [&] (size_t i) {
+        Parser parser(context, tokens, bounds[i], bounds[i + 1]);
+        errors[i] = parser.try_program(chunks[i]);
+    });
+
+    // Exiting is left to this thread, with the earliest error of any chunk
+    const SyntaxError* first = nullptr;
+    for(const auto& error: errors) {
+        if(error && (!first || error->offset < first->offset)) {
+            first = &*error;
+        }
+    }
+    if(first) {
+        HKSL_ERROR(first->message);
+    }
+
+    return AST::concatenate(file, chunks, pool);
+}
+}
@@ -1,43 +1,39 @@
 #include "AST.h"
 #include <Parse/Parser.h>
+#include <Parse/ParserTables.h>
+#include <cassert>
 #include <format>
 
 namespace HKSL {
-Parser::Parser(CompilationContext& _context, const Token* tokens): context(_context) {
-    remaining = tokens;
+Parser::Parser(CompilationContext& _context, Lexer& lexer): tokens(lexer), stop_offset(UINT32_MAX), ast(tokens.current().span.file), context(_context) {}
+Parser::Parser(CompilationContext& _context, const TokenBuffer& _tokens): tokens(_tokens), stop_offset(UINT32_MAX), ast(tokens.current().span.file), context(_context) {}
+Parser::Parser(CompilationContext& _context, const TokenBuffer& _tokens, size_t begin, size_t end): tokens(_tokens, begin), stop_offset(_tokens.offset(end)), ast(tokens.current().span.file), context(_context) {}
+TokenKind Parser::current() const {
+    return tokens.current().kind;
 }
-const Token& Parser::current() const {
-    return *remaining;
+TokenKind Parser::next() const {
+    return tokens.next().kind;
 }
-const Token& Parser::next() const {
-    return *(remaining + 1);
+Span Parser::current_span() const {
+    return tokens.current().span;
 }
 bool Parser::is_eof() {
-    return current().kind == TokenKind::Eof;
+    return current() == TokenKind::Eof;
 }
 void Parser::advance() {
     if(is_eof()) {
-        HKSL_ERROR("Reached EOF while parsing");
+        syntax_error(current_span(), "Reached EOF while parsing");
     }
 
-    remaining++;
+    tokens.advance();
 }
 bool Parser::matches(TokenKind kind) const {
-    return current().kind == kind;
+    return current() == kind;
 }
-bool Parser::consume(std::initializer_list<TokenKind> kinds, Token* out_consumed) {
-    for(auto kind: kinds) {
-        if(consume(kind, out_consumed)) {
-            return true;
-        }
-    }
-
-    return false;
-}
-bool Parser::consume(TokenKind kind, Token* out_consumed) {
+bool Parser::consume(TokenKind kind, Span* out_span) {
     if(matches(kind)) {
-        if(out_consumed) {
-            *out_consumed = current();
+        if(out_span) {
+            *out_span = current_span();
         }
 
         advance();
@@ -47,31 +43,66 @@ bool Parser::consume(TokenKind kind, Token* out_consumed) {
     return false;
 }
 void Parser::unexpected_token() {
-    Span span = current().span;
-    std::string token = token_kind_to_string(current().kind);
-    HKSL_ERROR(std::format("Unexpected token: {} on line {}:{}", token, span.line, span.col));
+    SourceLocation location = context.locate(current_span());
+    std::string token = token_kind_to_string(current());
+    syntax_error(current_span(), std::format("Unexpected token: {} on line {}:{}", token, location.line, location.col));
+}
+void Parser::expect(TokenKind kind, Span* out_span, const char* error) {
+    require(kind, error);
+    if(out_span) {
+        *out_span = current_span();
+    }
+    advance();
 }
-void Parser::expect(TokenKind kind, Token* out_consumed, const char* error) {
-    if(!consume(kind, out_consumed)) {
-        Span span = current().span;
+void Parser::require(TokenKind kind, const char* error) {
+    if(!matches(kind)) {
+        SourceLocation location = context.locate(current_span());
         std::string token = token_kind_to_string(kind);
         if(error) {
-            HKSL_ERROR(std::format("{} on line {}:{}", error, span.line, span.col));  
+            syntax_error(current_span(), std::format("{} on line {}:{}", error, location.line, location.col));
         } else {
-            HKSL_ERROR(std::format("Expected {} on line {}:{}", token, span.line, span.col));
+            syntax_error(current_span(), std::format("Expected {} on line {}:{}", token, location.line, location.col));
         }
     }
 }
-std::unique_ptr<AST> Parser::program() {
-    std::vector<std::unique_ptr<Statement>> statements;
+void Parser::syntax_error(Span span, std::string message) {
+    throw SyntaxError {.offset = span.offset, .message = std::move(message)};
+}
+AST Parser::program() {
+    AST program;
+    if(auto error = try_program(program)) {
+        HKSL_ERROR(error->message);
+    }
+
+    return program;
+}
+std::optional<SyntaxError> Parser::try_program(AST& program) {
+    try {
+        program = statements();
+    } catch(SyntaxError& error) {
+        return std::move(error);
+    }
+
+    return std::nullopt;
+}
+AST Parser::statements() {
+    size_t top = scratch.size();
 
-    while(!is_eof()) {
-        statements.push_back(statement());
+    while(!is_eof() && current_span().offset < stop_offset) {
+        if(matches(TokenKind::KeywordStruct)) {
+            scratch.push_back(struct_decl());
+        } else if(matches(TokenKind::KeywordUniform)) {
+            scratch.push_back(uniform_decl());
+        } else {
+            scratch.push_back(statement());
+        }
     }
 
-    return std::make_unique<AST>(statements);
+    ast.set_top_level(std::span(scratch).subspan(top));
+    scratch.resize(top);
+    return std::move(ast);
 }
-std::unique_ptr<Statement> Parser::statement() {
+NodeId Parser::statement() {
     if(matches(TokenKind::KeywordFn)) {
         return function();
     } else if(matches(TokenKind::LeftCurly)) {
@@ -84,41 +115,43 @@ std::unique_ptr<Statement> Parser::statement() {
         return expr_statement();
     }
 }
-std::unique_ptr<Statement> Parser::return_statement() {
-    Token ret_token;
-    expect(TokenKind::KeywordReturn, &ret_token);
-
-    auto ret = std::make_unique<ReturnStatement>(std::nullopt, ret_token);
+NodeId Parser::return_statement() {
+    Span ret_span;
+    expect(TokenKind::KeywordReturn, &ret_span);
 
+    NodeId value = NO_NODE;
     if(!consume(TokenKind::Semicolon)) {
-        ret->value = expr();
+        value = expr();
         expect(TokenKind::Semicolon);
     }
 
-    return std::move(ret);
+    return ast.add_return_statement(value, ret_span);
 }
-std::unique_ptr<Statement> Parser::expr_statement() {
+NodeId Parser::expr_statement() {
     auto inner = expr();
     expect(TokenKind::Semicolon);
 
-    return std::make_unique<ExprStatement>(std::move(inner));
+    return ast.add_expr_statement(inner);
 }
-std::unique_ptr<BlockStatement> Parser::block() {
-    expect(TokenKind::LeftCurly);
-    std::vector<std::unique_ptr<Statement>> inner_statements;
+NodeId Parser::block() {
+    Span left_curly;
+    expect(TokenKind::LeftCurly, &left_curly);
+    size_t top = scratch.size();
 
     while(!consume(TokenKind::RightCurly)) {
-        inner_statements.push_back(statement());
+        scratch.push_back(statement());
     }
 
-    return std::make_unique<BlockStatement>(inner_statements);
+    NodeId block = ast.add_block_statement(std::span(scratch).subspan(top), left_curly);
+    scratch.resize(top);
+    return block;
 }
-std::unique_ptr<Statement> Parser::function() {
+NodeId Parser::function() {
     expect(TokenKind::KeywordFn);
     
     const auto name = identifier();
 
-    FunctionArgs args = function_args();
+    size_t args = function_args();
 
     Type* return_type = context.type_registry().get_void();
 
@@ -126,23 +159,25 @@ std::unique_ptr<Statement> Parser::function() {
         return_type = type();
     }
 
-    std::unique_ptr<BlockStatement> block_stmt = block();
+    NodeId block_stmt = block();
 
-    return std::make_unique<Function>(name, args, std::move(block_stmt), return_type);
+    NodeId function = ast.add_function(name, std::span(scratch).subspan(args), block_stmt, return_type);
+    scratch.resize(args);
+    return function;
+}
+size_t Parser::function_args() {
+    return typed_names(TokenKind::LeftRound, TokenKind::RightRound);
 }
-FunctionArgs Parser::function_args() {
-    FunctionArgs args;
-    expect(TokenKind::LeftRound);
+size_t Parser::typed_names(TokenKind open, TokenKind close) {
+    size_t names = scratch.size();
+    expect(open);
 
     while(true) {
-        const auto& maybe_name= current();
-        if(consume(TokenKind::Identifier)) {
-            const auto& name = maybe_name.unwrap_identifier();
+        if(matches(TokenKind::Identifier)) {
+            const auto name = identifier();
             expect(TokenKind::Colon);
 
-            auto ty = std::make_optional<Type*>(type());
-
-            args.push_back(VarDecl(name, ty));
+            scratch.push_back(ast.add_var_decl(name, type()));
 
             if(!consume(TokenKind::Comma)) {
                 break;
@@ -152,33 +187,79 @@ FunctionArgs Parser::function_args() {
         }
     }
 
-    expect(TokenKind::RightRound);
+    expect(close);
 
-    return args;
+    return names;
 }
-std::unique_ptr<Statement> Parser::if_statement() {
-    expect(TokenKind::KeywordIf);
-    auto condition = expr();
+NodeId Parser::struct_decl() {
+    expect(TokenKind::KeywordStruct);
 
-    {
-    ASTPrinter printer;
-    condition->print(printer);
+    const auto name = identifier();
+    size_t fields = typed_names(TokenKind::LeftCurly, TokenKind::RightCurly);
+    auto field_decls = std::span(scratch).subspan(fields);
+
+    std::vector<StructField> struct_fields;
+    for(NodeId field: field_decls) {
+        auto decl = ast.var_decl(field);
+        struct_fields.push_back(StructField {.name = decl.name.symbol, .type = decl.type});
     }
-    auto block_stmt = block();
-    {
-        ASTPrinter printer;
-        block_stmt->print(printer);
+
+    // Writes to the shared registry, safe since the parallel parser keeps a
+    // file with struct declarations in a single chunk
+    Type* type = context.type_registry().add_struct(name.symbol, std::move(struct_fields));
+    if(!type) {
+        SourceLocation location = context.locate(name.span);
+        syntax_error(name.span, std::format("Redefinition of type {} on line {}:{}", context.symbols().str(name.symbol), location.line, location.col));
     }
-    std::optional<std::unique_ptr<ElseStatement>> else_stmt = std::nullopt;
+
+    NodeId decl = ast.add_struct_decl(name, field_decls, type);
+    scratch.resize(fields);
+    return decl;
+}
+NodeId Parser::uniform_decl() {
+    Span uniform_span;
+    expect(TokenKind::KeywordUniform, &uniform_span);
+
+    UpdateFrequency frequency = UpdateFrequency::Draw;
+    if(consume(TokenKind::LeftRound)) {
+        const auto name = identifier();
+        std::string_view frequency_name = context.symbols().str(name.symbol);
+        if(frequency_name == "frame") {
+            frequency = UpdateFrequency::Frame;
+        } else if(frequency_name == "material") {
+            frequency = UpdateFrequency::Material;
+        } else if(frequency_name == "draw") {
+            frequency = UpdateFrequency::Draw;
+        } else {
+            SourceLocation location = context.locate(name.span);
+            syntax_error(name.span, std::format("Unknown update frequency {} on line {}:{}, expected frame, material or draw", frequency_name, location.line, location.col));
+        }
+        expect(TokenKind::RightRound);
+    }
+
+    const auto name = identifier();
+    expect(TokenKind::Colon, nullptr, "Uniforms need a type");
+    NodeId decl = ast.add_var_decl(name, type());
+    expect(TokenKind::Semicolon);
+
+    return ast.add_uniform_decl(decl, frequency, uniform_span);
+}
+NodeId Parser::if_statement() {
+    Span if_span;
+    expect(TokenKind::KeywordIf, &if_span);
+    auto condition = expr();
+    auto block_stmt = block();
+    NodeId else_stmt = NO_NODE;
     if(matches(TokenKind::KeywordElse)) {
         else_stmt = else_statement();
     }
 
-    return std::make_unique<IfStatement>(std::move(condition), std::move(block_stmt), std::move(else_stmt));
+    return ast.add_if_statement(condition, block_stmt, else_stmt, if_span);
 }
-std::unique_ptr<ElseStatement> Parser::else_statement() {
-    expect(TokenKind::KeywordElse);
-    std::unique_ptr<Statement> statement;
+NodeId Parser::else_statement() {
+    Span else_span;
+    expect(TokenKind::KeywordElse, &else_span);
+    NodeId statement;
     if(matches(TokenKind::KeywordIf)) {
         // else if
         statement = if_statement();
@@ -186,143 +267,166 @@ std::unique_ptr<ElseStatement> Parser::else_statement() {
         statement = block();
     }
 
-    return std::make_unique<ElseStatement>(std::move(statement));
-}
-std::unique_ptr<Expr> Parser::expr() {
-    return let();
+    return ast.add_else_statement(statement, else_span);
 }
-
-std::unique_ptr<Expr> Parser::let() {
-    if(consume(TokenKind::KeywordLet)) {
+NodeId Parser::expr() {
+    Span let_span;
+    if(consume(TokenKind::KeywordLet, &let_span)) {
         auto var_decl_expr = var_decl();
-        auto let_expr = std::make_unique<LetExpr>(std::move(var_decl_expr), std::nullopt, std::nullopt);
-        
+
+        NodeId rhs = NO_NODE;
         if(consume(TokenKind::Equals)) {
-            auto rhs = expr();
-            let_expr->rhs = std::move(rhs);
+            rhs = expr();
         }
 
-        return let_expr;
+        return ast.add_let_expr(var_decl_expr, rhs, let_span);
     }
 
-    return assignment();
+    return operator_expr();
 }
-std::unique_ptr<Expr> Parser::assignment() {
-    std::unique_ptr<Expr> lhs = equality();
+NodeId Parser::operator_expr() {
+    using namespace ParserTables;
 
-    Token op_token;
-    if(consume(TokenKind::Equals, &op_token)) {
+    size_t operator_base = operators.size();
+    size_t operand_base = operands.size();
+    size_t open_groups = 0;
 
-        if(!expr_kind_is_place(lhs->kind())) {
-            HKSL_ERROR(std::format("Target of assignment can only be a variable, found: {}: {}:{}", expr_kind_to_string(lhs->kind()), op_token.span.line, op_token.span.col));
+    while(true) {
+        // Prefix position, then an operand
+        while(true) {
+            if(matches(TokenKind::LeftRound)) {
+                operators.push_back({PendingOperator::Kind::Group, current(), current_span()});
+                open_groups++;
+                advance();
+            } else if(prefix(current()).is_prefix) {
+                operators.push_back({PendingOperator::Kind::Prefix, current(), current_span()});
+                advance();
+            } else {
+                break;
+            }
         }
-        std::unique_ptr<Expr> rhs = assignment();
-        
-        lhs = std::make_unique<AssignmentExpr>(std::move(lhs), std::move(rhs), op_token);
-    }
 
-    return lhs;
-}
-std::unique_ptr<Expr> Parser::equality() {
-    auto left = term();
-    Token op_token;
-    if(consume(TokenKind::DoubleEquals, &op_token)) {
-        auto right = term();
-        BinOp op = BinOp::Equals;
+        if(matches(TokenKind::KeywordLet) && open_groups > 0 && operators.back().kind == PendingOperator::Kind::Group) {
+            // A parenthesized expression starts a new expression
+            operands.push_back(expr());
+        } else {
+            operands.push_back(operand());
+        }
 
-        left = std::make_unique<BinExpr>(op, std::move(left), std::move(right), op_token);
-    }
+        // Infix position
+        while(open_groups > 0 && matches(TokenKind::RightRound)) {
+            while(operators.back().kind != PendingOperator::Kind::Group) {
+                reduce();
+            }
+            operators.pop_back();
+            open_groups--;
+            advance();
+        }
 
-    return left;
-}
-std::unique_ptr<Expr> Parser::term() {
-    auto left = factor();
+        const InfixOperator& op = infix(current());
+        if(op.kind == InfixKind::None) {
+            break;
+        }
+
+        bool chained = false;
+        while(operators.size() > operator_base) {
+            const PendingOperator& top = operators.back();
+            Precedence top_precedence;
+            if(top.kind == PendingOperator::Kind::Group) {
+                break;
+            } else if(top.kind == PendingOperator::Kind::Prefix) {
+                top_precedence = Precedence::Prefix;
+            } else {
+                top_precedence = infix(top.token).precedence;
+            }
 
-    Token op_token;
-    while(consume({TokenKind::Plus, TokenKind::Minus}, &op_token)) {
-        BinOp op;
-        switch(op_token.kind) {
-            case TokenKind::Plus:
-                op = BinOp::Add;
+            if(top_precedence == op.precedence && op.associativity == Associativity::None) {
+                chained = true;
                 break;
-            case TokenKind::Minus:
-                op = BinOp::Subtract;
+            } else if(top_precedence > op.precedence || (top_precedence == op.precedence && op.associativity == Associativity::Left)) {
+                reduce();
+            } else {
                 break;
-            default:
-                HKSL_UNREACHABLE();
+            }
+        }
+
+        if(chained) {
+            break;
         }
 
-        auto right = factor();
+        if(op.kind == InfixKind::Assignment) {
+            NodeId lhs = operands.back();
+            if(!node_kind_is_place(ast.kind(lhs))) {
+                SourceLocation location = context.locate(current_span());
+                syntax_error(current_span(), std::format("Target of assignment can only be a variable, found: {}: {}:{}", node_kind_to_string(ast.kind(lhs)), location.line, location.col));
+            }
+        }
 
-        left = std::make_unique<BinExpr>(op, std::move(left), std::move(right), op_token);
+        operators.push_back({PendingOperator::Kind::Infix, current(), current_span()});
+        advance();
     }
 
-    return left;
-}
-std::unique_ptr<Expr> Parser::factor() {
-    auto left = unary();
+    if(open_groups > 0) {
+        expect(TokenKind::RightRound);
+    }
+    while(operators.size() > operator_base) {
+        reduce();
+    }
 
-    Token op_token;
-    while(consume({TokenKind::Star, TokenKind::Slash}, &op_token)) {
-        BinOp op;
-        switch(op_token.kind) {
-            case TokenKind::Star:
-                op = BinOp::Multiply;
-                break;
-            case TokenKind::Slash:
-                op = BinOp::Divide;
-                break;
-            default:
-                HKSL_UNREACHABLE();
-        }
+    NodeId result = operands.back();
+    operands.resize(operand_base);
+    return result;
+}
+void Parser::reduce() {
+    using namespace ParserTables;
 
-        auto right = unary();
+    PendingOperator pending = operators.back();
+    operators.pop_back();
 
-        left = std::make_unique<BinExpr>(op, std::move(left), std::move(right), op_token);
+    if(pending.kind == PendingOperator::Kind::Prefix) {
+        NodeId inner = operands.back();
+        operands.back() = ast.add_unary_expr(prefix(pending.token).op, inner, pending.span);
+        return;
     }
 
-    return left;
-}
-std::unique_ptr<Expr> Parser::unary() {
-    Token op_token;
-    if(consume(TokenKind::Minus, &op_token)) {
-        std::unique_ptr<Expr> inner_expr = unary();
-        return std::make_unique<UnaryExpr>(UnaryOp::Negate, std::move(inner_expr), op_token);
-    } 
+    assert(pending.kind == PendingOperator::Kind::Infix);
+    NodeId rhs = operands.back();
+    operands.pop_back();
+    NodeId lhs = operands.back();
 
-    return primary();
-}
-std::unique_ptr<Expr> Parser::primary() {
-    if(consume(TokenKind::LeftRound)) {
-        auto inner = expr();
-        expect(TokenKind::RightRound);
-        return inner;
+    const InfixOperator& op = infix(pending.token);
+    if(op.kind == InfixKind::Assignment) {
+        operands.back() = ast.add_assignment_expr(lhs, rhs, pending.span);
+    } else {
+        operands.back() = ast.add_bin_expr(op.op, lhs, rhs, pending.span);
     }
-    const Token& last = current();
-    if(consume(TokenKind::Number)) {
-        return std::make_unique<NumberConstant>(last.unwrap_number_literal());
+}
+NodeId Parser::operand() {
+    if(matches(TokenKind::Number)) {
+        const Token& literal = tokens.current();
+        NodeId constant = ast.add_number_constant(literal.unwrap_number_literal(), literal.span);
+        advance();
+        return constant;
     }
 
     return place();
 }
 
-std::unique_ptr<Expr> Parser::place() {
+NodeId Parser::place() {
     if(matches(TokenKind::Identifier)) {
         return call_expr();
     }
 
     unexpected_token();
-    return nullptr;
+    return NO_NODE;
 }
-std::unique_ptr<Expr> Parser::call_expr() {
+NodeId Parser::call_expr() {
     auto name = identifier();
     if(consume(TokenKind::LeftRound)) {
-
-        CallArgs args;
+        size_t top = scratch.size();
         while(true) {
             if(!consume(TokenKind::RightRound)) {
-                auto arg = expr();
-                args.push_back(std::move(arg));
+                scratch.push_back(expr());
                 if(!consume(TokenKind::Comma)) {
                     expect(TokenKind::RightRound);
                     break;
@@ -331,39 +435,43 @@ std::unique_ptr<Expr> Parser::call_expr() {
                 break;
             }
         }
-        return std::make_unique<CallExpr>(name, args);
+        NodeId call = ast.add_call_expr(name, std::span(scratch).subspan(top));
+        scratch.resize(top);
+        return call;
     } else {
-        return std::make_unique<Variable>(name);
+        return ast.add_variable(name);
     }
 }
-std::unique_ptr<Variable> Parser::variable() {
-    return std::make_unique<Variable>(identifier());
+NodeId Parser::variable() {
+    return ast.add_variable(identifier());
 }
-std::unique_ptr<VarDecl> Parser::var_decl() {
+NodeId Parser::var_decl() {
     auto name = identifier();
 
-    std::optional<Type*> type_ = std::nullopt;
+    Type* type_ = nullptr;
     if(consume(TokenKind::Colon)) {
         // Is explictly typed
         type_ = type();
     }
 
-    return std::make_unique<VarDecl>(name, type_);
+    return ast.add_var_decl(name, type_);
 }
 Identifier Parser::identifier() {
-    const auto& maybe_identifier = current();
-    expect(TokenKind::Identifier);
-    return maybe_identifier.unwrap_identifier();
+    // Read in place, advancing reuses the token's slot
+    require(TokenKind::Identifier);
+    Identifier identifier = tokens.current().unwrap_identifier();
+    advance();
+    return identifier;
 }
 Type* Parser::type() {
-    const auto& maybe_identifier = current();
-    expect(TokenKind::Identifier, nullptr, "Expected type");
-    auto type_name = maybe_identifier.unwrap_identifier();
+    require(TokenKind::Identifier, "Expected type");
+    Identifier type_name = tokens.current().unwrap_identifier();
+    advance();
 
-    auto type = context.type_registry().get(type_name.name);
+    auto type = context.type_registry().get(type_name.symbol);
 
     if(!type) {
-        HKSL_ERROR(std::format("Unknown type: {}", type_name.name));
+        syntax_error(type_name.span, std::format("Unknown type: {}", context.symbols().str(type_name.symbol)));
     }
 
     return type;
@@ -0,0 +1,189 @@
+#include <Parse/Scan.h>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HKSL_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace HKSL {
+static inline bool is_white_space(char ch) {
+    return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r';
+}
+static inline bool is_identifier_char(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+static const char* scalar_skip_white_space(const char* p) {
+    while(is_white_space(*p)) {
+        p++;
+    }
+    return p;
+}
+static const char* scalar_skip_line(const char* p) {
+    while(*p != '\n' && *p != '\0') {
+        p++;
+    }
+    return p;
+}
+static const char* scalar_skip_identifier(const char* p) {
+    while(is_identifier_char(*p)) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef HKSL_SCAN_X86
+// All byte classes we look for are ASCII, so signed compares are safe: bytes
+// >= 0x80 are negative and never fall inside a range.
+static inline __m128i sse2_in_range(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+static inline __m128i sse2_white_space(__m128i v) {
+    __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    __m128i other = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    return _mm_or_si128(space, other);
+}
+static inline __m128i sse2_identifier(__m128i v) {
+    // Folding case with | 0x20 maps no non-letter into 'a'..'z'
+    __m128i alpha = sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i digit = sse2_in_range(v, '0', '9');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+}
+static inline __m128i sse2_line_end(__m128i v) {
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+}
+// The padding after the source ends every run within one 16 byte load of
+// the end, so none of the loops below need a bounds check
+static const char* sse2_skip_white_space(const char* p) {
+    while(true) {
+        __m128i v = _mm_loadu_si128((const __m128i*) p);
+        uint32_t mask = _mm_movemask_epi8(sse2_white_space(v));
+        if(mask != 0xFFFF) {
+            return p + __builtin_ctz(~mask);
+        }
+        p += 16;
+    }
+}
+static const char* sse2_skip_line(const char* p) {
+    while(true) {
+        __m128i v = _mm_loadu_si128((const __m128i*) p);
+        uint32_t mask = _mm_movemask_epi8(sse2_line_end(v));
+        if(mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+}
+static const char* sse2_skip_identifier(const char* p) {
+    while(true) {
+        __m128i v = _mm_loadu_si128((const __m128i*) p);
+        uint32_t mask = _mm_movemask_epi8(sse2_identifier(v));
+        if(mask != 0xFFFF) {
+            return p + __builtin_ctz(~mask);
+        }
+        p += 16;
+    }
+}
+
+#define HKSL_AVX2 __attribute__((target("avx2")))
+HKSL_AVX2 static inline __m256i avx2_in_range(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+HKSL_AVX2 static inline __m256i avx2_white_space(__m256i v) {
+    __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+    __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+    return _mm256_or_si256(space, other);
+}
+HKSL_AVX2 static inline __m256i avx2_identifier(__m256i v) {
+    __m256i alpha = avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+    __m256i digit = avx2_in_range(v, '0', '9');
+    __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+}
+HKSL_AVX2 static inline __m256i avx2_line_end(__m256i v) {
+    return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+}
+HKSL_AVX2 static const char* avx2_skip_white_space(const char* p) {
+    while(true) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) p);
+        uint32_t mask = _mm256_movemask_epi8(avx2_white_space(v));
+        if(mask != 0xFFFFFFFF) {
+            return p + __builtin_ctz(~mask);
+        }
+        p += 32;
+    }
+}
+HKSL_AVX2 static const char* avx2_skip_line(const char* p) {
+    while(true) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) p);
+        uint32_t mask = _mm256_movemask_epi8(avx2_line_end(v));
+        if(mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+}
+HKSL_AVX2 static const char* avx2_skip_identifier(const char* p) {
+    while(true) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) p);
+        uint32_t mask = _mm256_movemask_epi8(avx2_identifier(v));
+        if(mask != 0xFFFFFFFF) {
+            return p + __builtin_ctz(~mask);
+        }
+        p += 32;
+    }
+}
+#endif
+
+const Scanner& Scanner::scalar() {
+    static const Scanner scanner {
+        .name = "scalar",
+        .skip_white_space = scalar_skip_white_space,
+        .skip_line = scalar_skip_line,
+        .skip_identifier = scalar_skip_identifier,
+    };
+    return scanner;
+}
+const Scanner* Scanner::sse2() {
+#ifdef HKSL_SCAN_X86
+    static const Scanner scanner {
+        .name = "sse2",
+        .skip_white_space = sse2_skip_white_space,
+        .skip_line = sse2_skip_line,
+        .skip_identifier = sse2_skip_identifier,
+    };
+    if(__builtin_cpu_supports("sse2")) {
+        return &scanner;
+    }
+#endif
+    return nullptr;
+}
+const Scanner* Scanner::avx2() {
+#ifdef HKSL_SCAN_X86
+    static const Scanner scanner {
+        .name = "avx2",
+        .skip_white_space = avx2_skip_white_space,
+        .skip_line = avx2_skip_line,
+        .skip_identifier = avx2_skip_identifier,
+    };
+    if(__builtin_cpu_supports("avx2")) {
+        return &scanner;
+    }
+#endif
+    return nullptr;
+}
+const Scanner& Scanner::best() {
+    static const Scanner& scanner = [] () -> const Scanner& {
+        if(auto avx2_scanner = avx2()) {
+            return *avx2_scanner;
+        }
+        if(auto sse2_scanner = sse2()) {
+            return *sse2_scanner;
+        }
+        return scalar();
+    }();
+    return scanner;
+}
+}
@@ -0,0 +1,253 @@
+#include <ReflectionWriter.h>
+#include <cassert>
+#include <cstring>
+#include <format>
+#include <optional>
+#include <unordered_map>
+
+namespace HKSL {
+using namespace Reflection;
+
+std::optional<Stage> entry_point_stage(std::string_view name) {
+    if(name == "vertex_main") {
+        return Stage::Vertex;
+    } else if(name == "fragment_main") {
+        return Stage::Fragment;
+    } else if(name == "compute_main") {
+        return Stage::Compute;
+    }
+    return std::nullopt;
+}
+static const char* stage_to_string(Stage stage) {
+    switch(stage) {
+        case Stage::Vertex:
+            return "vertex";
+        case Stage::Fragment:
+            return "fragment";
+        case Stage::Compute:
+            return "compute";
+    }
+    HKSL_UNREACHABLE();
+}
+
+static_assert((uint8_t) HKSL::TypeKind::Struct == (uint8_t) Reflection::TypeKind::Struct);
+static_assert((uint8_t) HKSL::ScalarKind::Half == (uint8_t) Reflection::ScalarKind::Half);
+static_assert((uint8_t) HKSL::BlockKind::UniformBuffer == (uint8_t) Reflection::BlockKind::UniformBuffer);
+static_assert((uint8_t) HKSL::UpdateFrequency::Draw == (uint8_t) Reflection::UpdateFrequency::Draw);
+
+// Collects the records of each section, strings and types are deduplicated
+class ReflectionBuilder {
+    public:
+        uint32_t string(std::string_view text) {
+            auto it = string_offsets.find(text);
+            if(it != string_offsets.end()) {
+                return it->second;
+            }
+            uint32_t offset = strings.size();
+            strings.insert(strings.end(), text.begin(), text.end());
+            strings.push_back('\0');
+            string_offsets.emplace(text, offset);
+            return offset;
+        }
+        uint32_t type(const HKSL::Type* type) {
+            auto it = type_indices.find(type);
+            if(it != type_indices.end()) {
+                return it->second;
+            }
+            const TypeDesc& desc = type->desc();
+            types.push_back(TypeRecord {
+                .name = string(type->name()),
+                .kind = (Reflection::TypeKind) desc.kind,
+                .scalar = (Reflection::ScalarKind) desc.scalar,
+                .columns = desc.columns,
+                .rows = desc.rows,
+                .struct_index = desc.kind == HKSL::TypeKind::Struct ? desc.struct_id : NO_INDEX,
+                .size = (uint32_t) type->size_of(),
+            });
+            type_indices.emplace(type, types.size() - 1);
+            return types.size() - 1;
+        }
+        std::vector<uint8_t> finish() {
+            std::vector<uint8_t> blob(sizeof(Header));
+            Header header = {.magic = MAGIC, .version = VERSION, .size = 0, .section_count = (uint32_t) Section::Count, .sections = {}};
+            auto append = [&] (Section section, const void* records, size_t count, size_t record_size) {
+                blob.resize((blob.size() + 3) / 4 * 4);
+                header.sections[(size_t) section] = SectionRecord {.offset = (uint32_t) blob.size(), .count = (uint32_t) count};
+                const uint8_t* bytes = static_cast<const uint8_t*>(records);
+                blob.insert(blob.end(), bytes, bytes + count * record_size);
+            };
+            append(Section::Types, types.data(), types.size(), sizeof(TypeRecord));
+            append(Section::Structs, structs.data(), structs.size(), sizeof(StructRecord));
+            append(Section::Fields, fields.data(), fields.size(), sizeof(FieldRecord));
+            append(Section::EntryPoints, entry_points.data(), entry_points.size(), sizeof(EntryPointRecord));
+            append(Section::Inputs, inputs.data(), inputs.size(), sizeof(InputRecord));
+            append(Section::UniformBlocks, blocks.data(), blocks.size(), sizeof(BlockRecord));
+            append(Section::Uniforms, uniforms.data(), uniforms.size(), sizeof(UniformRecord));
+            append(Section::Strings, strings.data(), strings.size(), 1);
+            blob.resize((blob.size() + 3) / 4 * 4);
+
+            header.size = blob.size();
+            std::memcpy(blob.data(), &header, sizeof(Header));
+            return blob;
+        }
+
+        std::vector<StructRecord> structs;
+        std::vector<FieldRecord> fields;
+        std::vector<EntryPointRecord> entry_points;
+        std::vector<InputRecord> inputs;
+        std::vector<BlockRecord> blocks;
+        std::vector<UniformRecord> uniforms;
+    private:
+        std::vector<char> strings;
+        std::unordered_map<std::string_view, uint32_t> string_offsets;
+        std::vector<TypeRecord> types;
+        std::unordered_map<const HKSL::Type*, uint32_t> type_indices;
+};
+
+std::vector<uint8_t> write_reflection(CompilationContext& context, std::span<const StructReport> structs, std::span<const UniformBlock> uniform_blocks) {
+    static_assert(LAYOUT_COUNT == LAYOUT_RULE_COUNT);
+    ReflectionBuilder builder;
+    AST& ast = context.get_ast();
+
+    for(NodeId statement: ast.top_level()) {
+        if(ast.kind(statement) == NodeKind::Struct) {
+            auto decl = ast.struct_decl(statement);
+            // Structs are registered in declaration order, so a struct's id is
+            // its report's index
+            const StructReport& report = structs[builder.structs.size()];
+            assert(decl.type->desc().struct_id == builder.structs.size());
+
+            StructRecord record = {
+                .name = builder.string(report.name),
+                .first_field = (uint32_t) builder.fields.size(),
+                .field_count = (uint32_t) decl.fields.size(),
+                .size = {},
+                .alignment = {},
+                .padding = {},
+            };
+            for(NodeId field: decl.fields) {
+                auto var = ast.var_decl(field);
+                builder.fields.push_back(FieldRecord {
+                    .name = builder.string(context.symbols().str(var.name.symbol)),
+                    .type = builder.type(var.type),
+                    .offset = {},
+                });
+            }
+            for(size_t rule = 0; rule < LAYOUT_COUNT; rule++) {
+                const StructLayout& layout = report.layouts[rule];
+                record.size[rule] = layout.size;
+                record.alignment[rule] = layout.alignment;
+                record.padding[rule] = layout.padding;
+                for(const auto& field: layout.fields) {
+                    builder.fields[record.first_field + field.field].offset[rule] = field.offset;
+                }
+            }
+            builder.structs.push_back(record);
+        } else if(ast.kind(statement) == NodeKind::Function) {
+            auto function = ast.function(statement);
+            std::string_view name = context.symbols().str(function.name.symbol);
+            auto stage = entry_point_stage(name);
+            if(!stage) {
+                continue;
+            }
+
+            EntryPointRecord record = {
+                .name = builder.string(name),
+                .stage = *stage,
+                .first_input = (uint32_t) builder.inputs.size(),
+                .input_count = (uint32_t) function.args.size(),
+                .output_type = builder.type(function.return_type),
+            };
+            for(size_t i = 0; i < function.args.size(); i++) {
+                auto arg = ast.var_decl(function.args[i]);
+                builder.inputs.push_back(InputRecord {
+                    .name = builder.string(context.symbols().str(arg.name.symbol)),
+                    .type = builder.type(arg.type),
+                    .location = (uint32_t) i,
+                });
+            }
+            builder.entry_points.push_back(record);
+        }
+    }
+
+    for(const auto& block: uniform_blocks) {
+        builder.blocks.push_back(BlockRecord {
+            .kind = (Reflection::BlockKind) block.kind,
+            .frequency = (Reflection::UpdateFrequency) block.frequency,
+            .binding = block.binding,
+            .size = block.size,
+            .first_member = (uint32_t) builder.uniforms.size(),
+            .member_count = (uint32_t) block.members.size(),
+        });
+        for(const auto& member: block.members) {
+            builder.uniforms.push_back(UniformRecord {
+                .name = builder.string(member.name),
+                .type = builder.type(ast.var_decl(ast.uniform_decl(member.decl).var_decl).type),
+                .block = (uint32_t) builder.blocks.size() - 1,
+                .offset = member.offset,
+                .accesses = member.accesses,
+                .frequency = (Reflection::UpdateFrequency) member.frequency,
+            });
+        }
+    }
+
+    return builder.finish();
+}
+
+std::string reflection_to_json(const Reader& reader) {
+    static const char* LAYOUT_NAMES[LAYOUT_COUNT] = {"std140", "std430", "scalar"};
+    auto type_name = [&] (uint32_t type) {
+        return reader.string(reader.types()[type].name);
+    };
+
+    std::string json = std::format("{{\n  \"version\": {},\n  \"entry_points\": [", reader.header().version);
+    const char* separator = "\n";
+    for(const auto& entry: reader.entry_points()) {
+        json += std::format("{}    {{\"name\": \"{}\", \"stage\": \"{}\", \"output\": \"{}\", \"inputs\": [", separator, reader.string(entry.name), stage_to_string(entry.stage), type_name(entry.output_type));
+        const char* input_separator = "";
+        for(const auto& input: reader.inputs(entry)) {
+            json += std::format("{}{{\"name\": \"{}\", \"type\": \"{}\", \"location\": {}, \"size\": {}}}", input_separator, reader.string(input.name), type_name(input.type), input.location, reader.types()[input.type].size);
+            input_separator = ", ";
+        }
+        json += "]}";
+        separator = ",\n";
+    }
+    json += "\n  ],\n  \"structs\": [";
+
+    separator = "\n";
+    for(const auto& record: reader.structs()) {
+        json += std::format("{}    {{\"name\": \"{}\", \"layouts\": {{", separator, reader.string(record.name));
+        for(size_t rule = 0; rule < LAYOUT_COUNT; rule++) {
+            json += std::format("{}\"{}\": {{\"size\": {}, \"alignment\": {}, \"padding\": {}}}", rule ? ", " : "", LAYOUT_NAMES[rule], record.size[rule], record.alignment[rule], record.padding[rule]);
+        }
+        json += "},\n      \"fields\": [";
+        const char* field_separator = "";
+        for(const auto& field: reader.fields(record)) {
+            json += std::format("{}{{\"name\": \"{}\", \"type\": \"{}\", \"offsets\": {{", field_separator, reader.string(field.name), type_name(field.type));
+            for(size_t rule = 0; rule < LAYOUT_COUNT; rule++) {
+                json += std::format("{}\"{}\": {}", rule ? ", " : "", LAYOUT_NAMES[rule], field.offset[rule]);
+            }
+            json += "}}";
+            field_separator = ", ";
+        }
+        json += "]}";
+        separator = ",\n";
+    }
+    json += "\n  ],\n  \"uniform_blocks\": [";
+
+    separator = "\n";
+    for(const auto& block: reader.uniform_blocks()) {
+        json += std::format("{}    {{\"kind\": \"{}\", \"frequency\": \"{}\", \"binding\": {}, \"size\": {},\n      \"members\": [", separator, block_kind_to_string((HKSL::BlockKind) block.kind), update_frequency_to_string((HKSL::UpdateFrequency) block.frequency), block.binding, block.size);
+        const char* member_separator = "";
+        for(const auto& uniform: reader.uniforms(block)) {
+            json += std::format("{}{{\"name\": \"{}\", \"type\": \"{}\", \"offset\": {}, \"accesses\": {}, \"frequency\": \"{}\"}}", member_separator, reader.string(uniform.name), type_name(uniform.type), uniform.offset, uniform.accesses, update_frequency_to_string((HKSL::UpdateFrequency) uniform.frequency));
+            member_separator = ", ";
+        }
+        json += "]}";
+        separator = ",\n";
+    }
+    json += "\n  ]\n}\n";
+
+    return json;
+}
+}
@@ -0,0 +1,81 @@
+#include <Source.h>
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+namespace HKSL {
+std::string SourceLocation::to_string() const {
+    return std::format("{}:{}", line, col);
+}
+
+LineTable::LineTable(std::string_view text): text(text) {}
+void LineTable::build() {
+    line_starts.push_back(0);
+
+    const char* start = text.data();
+    const char* end = start + text.size();
+    const char* newline = start;
+    while((newline = (const char*) std::memchr(newline, '\n', end - newline))) {
+        newline++;
+        line_starts.push_back(newline - start);
+    }
+}
+SourceLocation LineTable::locate(uint32_t offset) {
+    std::call_once(built, [this] {
+        build();
+    });
+
+    // First line starting after the offset, the offset is on the line before it
+    auto it = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+    uint32_t line = it - line_starts.begin();
+
+    return SourceLocation {.line = line, .col = offset - *(it - 1) + 1};
+}
+
+SourceFile::SourceFile(uint32_t id, const std::string& name, MappedFile mapping): m_id(id), m_name(name), mapping(std::move(mapping)), m_text(this->mapping->data(), this->mapping->size()), lines(m_text) {}
+static std::string padded(std::string buffer) {
+    buffer.resize(buffer.size() + SourceManager::PADDING, '\0');
+    return buffer;
+}
+SourceFile::SourceFile(uint32_t id, const std::string& name, std::string buffer): m_id(id), m_name(name), buffer(padded(std::move(buffer))), m_text(this->buffer.data(), this->buffer.size() - SourceManager::PADDING), lines(m_text) {}
+uint32_t SourceFile::id() const {
+    return m_id;
+}
+const std::string& SourceFile::name() const {
+    return m_name;
+}
+std::string_view SourceFile::text() const {
+    return m_text;
+}
+SourceLocation SourceFile::locate(uint32_t offset) {
+    return lines.locate(offset);
+}
+
+uint32_t SourceManager::load_file(const std::string& path) {
+    MappedFile mapping(path.c_str(), PADDING);
+
+    std::lock_guard lock(mutex);
+    uint32_t id = files.size();
+    files.push_back(std::make_unique<SourceFile>(id, path, std::move(mapping)));
+
+    return id;
+}
+uint32_t SourceManager::add_buffer(const std::string& name, std::string text) {
+    std::lock_guard lock(mutex);
+    uint32_t id = files.size();
+    files.push_back(std::make_unique<SourceFile>(id, name, std::move(text)));
+
+    return id;
+}
+SourceFile& SourceManager::file(uint32_t id) {
+    std::lock_guard lock(mutex);
+    return *files[id];
+}
+size_t SourceManager::size() {
+    std::lock_guard lock(mutex);
+    return files.size();
+}
+SourceLocation SourceManager::locate(uint32_t file, uint32_t offset) {
+    return this->file(file).locate(offset);
+}
+}
@@ -0,0 +1,68 @@
+#include <Symbol.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace HKSL {
+static constexpr size_t SYMBOL_BLOCK_SIZE = 64 * 1024;
+
+SymbolInterner::SymbolInterner() {
+    block_used = 0;
+    block_capacity = 0;
+}
+SymbolInterner& SymbolInterner::global() {
+    static SymbolInterner interner;
+    return interner;
+}
+Symbol SymbolInterner::intern(std::string_view name) {
+    {
+        std::shared_lock lock(mutex);
+        auto it = lookup.find(name);
+        if(it != lookup.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    // Another thread may have interned the same name in between
+    auto it = lookup.find(name);
+    if(it != lookup.end()) {
+        return it->second;
+    }
+
+    auto stored = store(name);
+    Symbol symbol { .id = (uint32_t) names.size() };
+    names.push_back(stored);
+    lookup.emplace(stored, symbol);
+
+    return symbol;
+}
+std::string_view SymbolInterner::str(Symbol symbol) const {
+    std::shared_lock lock(mutex);
+    return names[symbol.id];
+}
+const char* SymbolInterner::c_str(Symbol symbol) const {
+    // Stored names are always null terminated
+    return str(symbol).data();
+}
+size_t SymbolInterner::size() const {
+    std::shared_lock lock(mutex);
+    return names.size();
+}
+std::string_view SymbolInterner::store(std::string_view name) {
+    size_t needed = name.size() + 1;
+
+    if(block_used + needed > block_capacity) {
+        block_capacity = std::max(SYMBOL_BLOCK_SIZE, needed);
+        block_used = 0;
+        blocks.push_back(std::make_unique<char[]>(block_capacity));
+    }
+
+    char* dst = blocks.back().get() + block_used;
+    std::memcpy(dst, name.data(), name.size());
+    dst[name.size()] = '\0';
+    block_used += needed;
+
+    return std::string_view(dst, name.size());
+}
+}
@@ -0,0 +1,88 @@
+#include <ThreadPool.h>
+
+namespace HKSL {
+ThreadPool::ThreadPool(size_t n_threads) {
+    if(n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for(size_t i = 1; i < n_threads; i++) {
+        threads.emplace_back([this] { worker(); });
+    }
+}
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+}
+size_t ThreadPool::size() const {
+    return threads.size() + 1;
+}
+void ThreadPool::parallel_for(size_t n_tasks, const std::function<void(size_t)>& task) {
+    if(n_tasks == 0) {
+        return;
+    }
+
+    {
+        // A worker that woke up after the last batch finished may still be
+        // on its way out of it
+        std::unique_lock lock(mutex);
+        work_done.wait(lock, [this] { return n_active == 0; });
+        this->task = &task;
+        this->n_tasks = n_tasks;
+        next_task = 0;
+        n_finished = 0;
+        generation++;
+    }
+    work_ready.notify_all();
+
+    run_tasks();
+
+    // Workers may still be finishing their last task
+    std::unique_lock lock(mutex);
+    work_done.wait(lock, [this] { return n_finished == this->n_tasks && n_active == 0; });
+    this->task = nullptr;
+}
+void ThreadPool::run_tasks() {
+    while(true) {
+        size_t i = next_task++;
+        if(i >= n_tasks) {
+            return;
+        }
+
+        (*task)(i);
+        if(++n_finished == n_tasks) {
+            std::lock_guard lock(mutex);
+            work_done.notify_all();
+        }
+    }
+}
+void ThreadPool::worker() {
+    uint64_t seen_generation = 0;
+    std::unique_lock lock(mutex);
+    while(true) {
+        work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+        if(stopping) {
+            return;
+        }
+
+        seen_generation = generation;
+        n_active++;
+        lock.unlock();
+
+        run_tasks();
+
+        lock.lock();
+        n_active--;
+        if(n_active == 0) {
+            work_done.notify_all();
+        }
+    }
+}
+}
@@ -1,72 +1,156 @@
 #include <Typing.h>
+#include <Util.h>
 #include <cassert>
 
 namespace HKSL {
-uint64_t Void::id() const { return HKSL_VOID_TYPE_ID; }
-const char *Void::name() const { return "void"; }
-TypeKind Void::kind() const { return TypeKind::Void; }
-size_t Void::size_of() const { return 0; }
+Type::Type(const TypeDesc& desc, uint32_t id, const char* name, uint32_t size) {
+    this->m_desc = desc;
+    this->m_id = id;
+    this->m_name = name;
+    this->m_size = size;
+}
+uint32_t Type::id() const { return m_id; }
+const char* Type::name() const { return m_name; }
+TypeKind Type::kind() const { return m_desc.kind; }
+ScalarKind Type::scalar() const { return m_desc.scalar; }
+const TypeDesc& Type::desc() const { return m_desc; }
+size_t Type::size_of() const { return m_size; }
+uint32_t scalar_size_of(ScalarKind scalar) {
+    switch(scalar) {
+        case ScalarKind::Float:
+            return 4;
+        case ScalarKind::Half:
+            return 2;
+        case ScalarKind::None:
+            return 0;
+    }
+    HKSL_UNREACHABLE();
+}
+size_t TypeDescHash::operator()(const TypeDesc& desc) const noexcept {
+    uint64_t packed = (uint64_t) desc.kind
+        | (uint64_t) desc.scalar << 8
+        | (uint64_t) desc.columns << 16
+        | (uint64_t) desc.rows << 24
+        | (uint64_t) desc.struct_id << 32;
+    return std::hash<uint64_t>{}(packed);
+}
 
-uint64_t Float::id() const { return HKSL_FLOAT_TYPE_ID; }
-const char *Float::name() const { return "float"; }
-TypeKind Float::kind() const { return TypeKind::Float; }
-size_t Float::size_of() const { return 4; }
+TypeRegistry::TypeRegistry(SymbolInterner& _symbols): symbols(_symbols) {
+    void_type = intern(TypeDesc {.kind = TypeKind::Void, .scalar = ScalarKind::None, .columns = 1, .rows = 1, .struct_id = 0});
+    float_type = scalar(ScalarKind::Float);
+    half_type = scalar(ScalarKind::Half);
 
-uint64_t Float2::id() const { return HKSL_FLOAT2_TYPE_ID; }
-const char *Float2::name() const { return "float2"; }
-TypeKind Float2::kind() const { return TypeKind::Float2; }
-size_t Float2::size_of() const { return 4 * 2; }
+    add_name(void_type);
+    add_name(float_type);
+    add_name(half_type);
+    for(uint8_t width = 2; width <= 4; width++) {
+        add_name(vector(ScalarKind::Float, width));
+    }
+}
+std::string TypeRegistry::make_name(const TypeDesc& desc) {
+    std::string name;
+    switch(desc.scalar) {
+        case ScalarKind::Float:
+            name = "float";
+            break;
+        case ScalarKind::Half:
+            name = "half";
+            break;
+        case ScalarKind::None:
+            break;
+    }
+    switch(desc.kind) {
+        case TypeKind::Void:
+            return "void";
+        case TypeKind::Scalar:
+            return name;
+        case TypeKind::Vector:
+            return name + std::to_string(desc.columns);
+        case TypeKind::Matrix:
+            return name + std::to_string(desc.columns) + "x" + std::to_string(desc.rows);
+        case TypeKind::Struct:
+            // Structs are named by their declaration
+            break;
+    }
+    HKSL_UNREACHABLE();
+}
+Type* TypeRegistry::intern(const TypeDesc& desc) {
+    auto it = interned.find(desc);
+    if(it != interned.end()) {
+        return it->second;
+    }
 
-uint64_t Float3::id() const { return HKSL_FLOAT3_TYPE_ID; }
-const char *Float3::name() const { return "float3"; }
-TypeKind Float3::kind() const { return TypeKind::Float3; }
-size_t Float3::size_of() const { return 4 * 3; }
+    const char* name = symbols.c_str(symbols.intern(make_name(desc)));
+    return create(desc, name, scalar_size_of(desc.scalar) * desc.columns * desc.rows);
+}
+Type* TypeRegistry::create(const TypeDesc& desc, const char* name, uint32_t size) {
+    Type* type = &types.emplace_back(Type(desc, types.size(), name, size));
+    interned.emplace(desc, type);
 
-uint64_t Float4::id() const { return HKSL_FLOAT4_TYPE_ID; }
-const char *Float4::name() const { return "float4"; }
-TypeKind Float4::kind() const { return TypeKind::Float4; }
-size_t Float4::size_of() const { return 4 * 4; }
+    return type;
+}
+Type* TypeRegistry::add_struct(Symbol name, std::vector<StructField> fields) {
+    if(get(name)) {
+        return nullptr;
+    }
 
-TypeRegistry::TypeRegistry() {
-  register_type(std::make_unique<Void>());
-  register_type(std::make_unique<Float>());
-  register_type(std::make_unique<Float2>());
-  register_type(std::make_unique<Float3>());
-  register_type(std::make_unique<Float4>());
-}
-bool TypeRegistry::is_primitive(const Type &type) {
-  return type.kind() != TypeKind::Struct;
-}
-bool TypeRegistry::register_type(std::unique_ptr<Type> type) {
-  // Non primitive types disabled for now
-  assert(is_primitive(*type));
+    uint32_t size = 0;
+    for(const auto& field: fields) {
+        size += field.type->size_of();
+    }
+    auto desc = TypeDesc {.kind = TypeKind::Struct, .scalar = ScalarKind::None, .columns = 1, .rows = 1, .struct_id = (uint32_t) structs.size()};
+    structs.push_back(StructInfo {.name = name, .fields = std::move(fields)});
 
-  std::string type_name = type->name();
-  bool exists = !(types.find(type_name) == types.end());
-  types[type_name] = std::move(type);
+    Type* type = create(desc, symbols.c_str(name), size);
+    names.emplace(name, type);
+    return type;
+}
+const StructInfo& TypeRegistry::struct_info(const Type* type) const {
+    assert(type->kind() == TypeKind::Struct);
+    return structs[type->desc().struct_id];
+}
+Type* TypeRegistry::scalar(ScalarKind scalar) {
+    return intern(TypeDesc {.kind = TypeKind::Scalar, .scalar = scalar, .columns = 1, .rows = 1, .struct_id = 0});
+}
+Type* TypeRegistry::vector(ScalarKind scalar, uint8_t width) {
+    assert(width >= 2 && width <= 4);
+    return intern(TypeDesc {.kind = TypeKind::Vector, .scalar = scalar, .columns = width, .rows = 1, .struct_id = 0});
+}
+Type* TypeRegistry::matrix(ScalarKind scalar, uint8_t columns, uint8_t rows) {
+    assert(columns >= 2 && columns <= 4 && rows >= 2 && rows <= 4);
+    return intern(TypeDesc {.kind = TypeKind::Matrix, .scalar = scalar, .columns = columns, .rows = rows, .struct_id = 0});
+}
+void TypeRegistry::add_name(Type* type) {
+    names.emplace(symbols.intern(type->name()), type);
+}
+Type* TypeRegistry::get(Symbol name) {
+    auto it = names.find(name);
+    if(it == names.end()) {
+        return nullptr;
+    }
 
-  return exists;
+    return it->second;
 }
 Type* TypeRegistry::get(const std::string& name) {
     return get(name.c_str());
 }
-Type* TypeRegistry::get(const char *name) { return types[name].get(); }
-Type* TypeRegistry::get_float() { return get("float"); }
-Type* TypeRegistry::get_float2() { return get("float2"); }
-Type* TypeRegistry::get_float3() { return get("float3"); }
-Type* TypeRegistry::get_void() { return get("void"); }
+Type* TypeRegistry::get(const char *name) { return get(symbols.intern(name)); }
+Type* TypeRegistry::get_float() { return float_type; }
+Type* TypeRegistry::get_float2() { return vector(ScalarKind::Float, 2); }
+Type* TypeRegistry::get_float3() { return vector(ScalarKind::Float, 3); }
+Type* TypeRegistry::get_half() { return half_type; }
+Type* TypeRegistry::get_void() { return void_type; }
 
-void TypeResolver::register_expr(const Expr *expr, Type *type) {
-    type_map[expr] = type;
+void TypeResolver::resize(size_t node_count) {
+    types.assign(node_count, nullptr);
+}
+void TypeResolver::register_expr(NodeId expr, Type *type) {
+    assert(expr < types.size());
+    types[expr] = type;
 }
 
-Type* TypeResolver::type_of(const Expr *expr) {
-    auto it= type_map.find(expr);
-
-    if(it != type_map.end()) {
-        return it->second;
-    }
-
-    return nullptr;
+Type* TypeResolver::type_of(NodeId expr) {
+    assert(expr < types.size());
+    return types[expr];
 }
 }
\ No newline at end of file
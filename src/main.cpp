@@ -1,28 +1,68 @@
 #include "Compiler.h"
-#include "FSUtil.h"
+#include "ReflectionWriter.h"
+#include <cstring>
+#include <fstream>
 
 struct CLIArgs {
-    const char* src_path;
+    const char* src_path = nullptr;
+    // Where to write the reflection blob and its JSON dump, if asked to
+    const char* reflect_path = nullptr;
+    const char* reflect_json_path = nullptr;
+    // Where to write the SPIR-V binary, if asked to. Only builds with the
+    // experimental backend take --spv.
+    const char* spv_path = nullptr;
     void parse(int argc, const char** argv) {
-        if(argc != 2) {
-            HKSL_ERROR("Please provide a source file path");
+        for(int i = 1; i < argc; i++) {
+            if(std::strcmp(argv[i], "--reflect") == 0 && i + 1 < argc) {
+                reflect_path = argv[++i];
+            } else if(std::strcmp(argv[i], "--reflect-json") == 0 && i + 1 < argc) {
+                reflect_json_path = argv[++i];
+#ifdef HKSL_SPIRV
+            } else if(std::strcmp(argv[i], "--spv") == 0 && i + 1 < argc) {
+                spv_path = argv[++i];
+#endif
+            } else if(!src_path) {
+                src_path = argv[i];
+            } else {
+#ifdef HKSL_SPIRV
+                HKSL_ERROR("Usage: hksl <source> [--reflect <path>] [--reflect-json <path>] [--spv <path>]");
+#else
+                HKSL_ERROR("Usage: hksl <source> [--reflect <path>] [--reflect-json <path>]");
+#endif
+            }
         }
 
-        src_path = argv[1];
+        if(!src_path) {
+            HKSL_ERROR("Please provide a source file path");
+        }
     }
 };
 int main(int argc, const char** argv) {
     CLIArgs args;
     args.parse(argc, argv);
-    std::string code = HKSL::read_to_string(args.src_path);
 
     HKSL::Compiler compiler;
-    auto result = compiler.compile(args.src_path, code);
+    compiler.set_emit_spirv(args.spv_path != nullptr);
+    uint32_t file = compiler.sources().load_file(args.src_path);
+    auto result = compiler.compile(file);
 
     if(!result.is_success()) {
         for(auto error: result.errors) {
             std::cout << error << std::endl;
             std::exit(-1);
-        }    
+        }
+    }
+
+    if(args.reflect_path) {
+        std::ofstream out(args.reflect_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(result.reflection.data()), result.reflection.size());
+    }
+    if(args.reflect_json_path) {
+        std::ofstream out(args.reflect_json_path);
+        out << HKSL::reflection_to_json(HKSL::Reflection::Reader(result.reflection.data(), result.reflection.size()));
+    }
+    if(args.spv_path) {
+        std::ofstream out(args.spv_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(result.spirv.data()), result.spirv.size() * sizeof(uint32_t));
     }
-}
\ No newline at end of file
+}
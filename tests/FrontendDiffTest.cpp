@@ -0,0 +1,217 @@
+#include "TestUtil.h"
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+// Random programs that always parse. `error_rate` 0 gives programs that
+// check, higher rates mix in undeclared names, redefinitions, wrong
+// argument counts and type mismatches.
+class ProgramGenerator {
+    public:
+        ProgramGenerator(uint32_t seed, double error_rate): rng(seed), error_rate(error_rate) {}
+        std::string generate() {
+            size_t function_count = range(1, 12);
+            for(size_t i = 0; i < function_count; i++) {
+                function(i);
+            }
+            return out.str();
+        }
+    private:
+        struct Var {
+            std::string name;
+            std::string type;
+        };
+        struct Fn {
+            std::string name;
+            std::vector<std::string> params;
+            // Empty for void
+            std::string ret;
+        };
+
+        bool chance(double p) {
+            return std::uniform_real_distribution<double>(0, 1)(rng) < p;
+        }
+        size_t range(size_t low, size_t high) {
+            return std::uniform_int_distribution<size_t>(low, high)(rng);
+        }
+        template<typename T>
+        const T& pick(const std::vector<T>& items) {
+            return items[range(0, items.size() - 1)];
+        }
+        std::string type() {
+            return chance(0.5) ? "float" : "float3";
+        }
+        // Literals are floats, float3 values come from variables and calls
+        std::string leaf(const std::vector<Var>& scope, const std::string& want) {
+            if(chance(error_rate * 0.3)) {
+                return pick(std::vector<std::string> {"q", "zz", "w9"});
+            }
+            std::vector<Var> candidates;
+            for(const auto& var: scope) {
+                if(var.type == want || chance(error_rate)) {
+                    candidates.push_back(var);
+                }
+            }
+            if(!candidates.empty() && (want == "float3" || chance(0.6))) {
+                return pick(candidates).name;
+            }
+            if(want == "float3") {
+                return "float3(1.0, 2.0, 3.0)";
+            }
+            return "1.5";
+        }
+        std::string expr(const std::vector<Var>& scope, std::string want, int depth = 0) {
+            if(want.empty()) {
+                want = type();
+            }
+            double kind = std::uniform_real_distribution<double>(0, 1)(rng);
+            if(depth > 2 || kind < 0.3) {
+                return leaf(scope, want);
+            }
+            if(kind < 0.6) {
+                const char* op = pick(std::vector<const char*> {" + ", " - ", " * ", " / "});
+                return expr(scope, want, depth + 1) + op + expr(scope, want, depth + 1);
+            }
+            if(kind < 0.7) {
+                return "-" + expr(scope, want, depth + 1);
+            }
+            std::vector<Fn> callees;
+            for(const auto& fn: functions) {
+                if(fn.ret == want || chance(error_rate)) {
+                    callees.push_back(fn);
+                }
+            }
+            if(kind < 0.85 && !callees.empty()) {
+                const Fn& fn = pick(callees);
+                std::string call = chance(error_rate * 0.2) ? "nofn(" : fn.name + "(";
+                for(size_t i = 0; i < fn.params.size(); i++) {
+                    call += (i ? ", " : "") + expr(scope, fn.params[i], depth + 1);
+                }
+                if(chance(error_rate * 0.2)) {
+                    call += fn.params.empty() ? "1.0" : ", 1.0";
+                }
+                return call + ")";
+            }
+            return "(" + expr(scope, want, depth + 1) + ")";
+        }
+        void block(std::vector<Var> scope, const std::string& ret, const std::string& indent, int depth) {
+            size_t statement_count = range(1, 6);
+            for(size_t i = 0; i < statement_count; i++) {
+                double kind = std::uniform_real_distribution<double>(0, 1)(rng);
+                if(kind < 0.4) {
+                    std::string name = "v" + std::to_string(var_count++);
+                    if(chance(error_rate * 0.1) && !scope.empty()) {
+                        name = scope.back().name;
+                    }
+                    std::string var_type = type();
+                    if(chance(0.5)) {
+                        out << indent << "let " << name << " = " << expr(scope, var_type) << ";\n";
+                    } else if(chance(0.8)) {
+                        out << indent << "let " << name << ": " << var_type << " = " << expr(scope, var_type) << ";\n";
+                    } else if(chance(error_rate)) {
+                        out << indent << "let " << name << ";\n";
+                    } else {
+                        out << indent << "let " << name << ": " << var_type << ";\n";
+                        out << indent << name << " = " << expr(scope, var_type) << ";\n";
+                    }
+                    scope.push_back(Var {.name = name, .type = var_type});
+                } else if(kind < 0.6 && !scope.empty()) {
+                    const Var& var = pick(scope);
+                    out << indent << var.name << " = " << expr(scope, var.type) << ";\n";
+                } else if(kind < 0.75 && depth < 3) {
+                    out << indent << "if " << expr(scope, "float") << " {\n";
+                    block(scope, ret, indent + "    ", depth + 1);
+                    if(chance(0.4)) {
+                        out << indent << "} else {\n";
+                        block(scope, ret, indent + "    ", depth + 1);
+                    }
+                    out << indent << "}\n";
+                } else if(kind < 0.85) {
+                    out << indent << expr(scope, "") << ";\n";
+                } else if(!ret.empty()) {
+                    out << indent << "return " << expr(scope, ret) << ";\n";
+                } else {
+                    out << indent << "return;\n";
+                }
+            }
+        }
+        void function(size_t index) {
+            std::string name = "f" + std::to_string(index);
+            if(chance(error_rate * 0.1) && !functions.empty()) {
+                name = functions.back().name;
+            }
+            std::vector<Var> params;
+            size_t param_count = range(0, 3);
+            for(size_t i = 0; i < param_count; i++) {
+                params.push_back(Var {.name = std::format("a{}_{}", index, i), .type = type()});
+            }
+            std::string ret = chance(0.3) ? "" : type();
+
+            out << "fn " << name << "(";
+            for(size_t i = 0; i < params.size(); i++) {
+                out << (i ? ", " : "") << params[i].name << ": " << params[i].type;
+            }
+            out << ")" << (ret.empty() ? "" : " -> " + ret) << " {\n";
+            block(params, ret, "    ", 0);
+            out << "    return" << (ret.empty() ? "" : " " + expr(params, ret)) << ";\n}\n";
+
+            Fn fn {.name = name, .params = {}, .ret = ret};
+            for(const auto& param: params) {
+                fn.params.push_back(param.type);
+            }
+            functions.push_back(fn);
+        }
+
+        std::mt19937 rng;
+        double error_rate;
+        std::ostringstream out;
+        std::vector<Fn> functions;
+        size_t var_count = 0;
+};
+
+// The fused pass has to report what the two passes report, in the same
+// order, and infer the same types
+static void expect_same_output(const std::string& source) {
+    for(size_t n_threads: {1, 4}) {
+        auto separate = Testing::check(source, false, n_threads);
+        auto fused = Testing::check(source, true, n_threads);
+        ASSERT_EQ(separate.errors, fused.errors) << "with " << n_threads << " threads:\n" << source;
+        if(separate.errors.empty()) {
+            ASSERT_EQ(separate.types, fused.types) << "with " << n_threads << " threads:\n" << source;
+        }
+    }
+}
+
+TEST(FrontendDiff, Examples) {
+    for(const auto& entry: std::filesystem::directory_iterator(HKSL_EXAMPLES_DIR)) {
+        if(entry.path().extension() != ".hksl") {
+            continue;
+        }
+        std::ifstream file(entry.path());
+        std::stringstream source;
+        source << file.rdbuf();
+        // Examples may not parse, which exits
+        for(size_t n_threads: {1, 4}) {
+            EXPECT_EQ(Testing::check_isolated(source.str(), false, n_threads), Testing::check_isolated(source.str(), true, n_threads))
+                << entry.path() << " with " << n_threads << " threads";
+        }
+    }
+}
+TEST(FrontendDiff, GeneratedPrograms) {
+    const double error_rates[] = {0, 0, 0.02, 0.1, 0.5, 1};
+    size_t failing = 0;
+    for(uint32_t seed = 0; seed < 600; seed++) {
+        std::string source = ProgramGenerator(seed, error_rates[seed % std::size(error_rates)]).generate();
+        SCOPED_TRACE(std::format("seed {}", seed));
+        expect_same_output(source);
+        failing += !Testing::errors_of(source).empty();
+    }
+    // Both kinds of programs have to be covered
+    EXPECT_GT(failing, 100u);
+    EXPECT_LT(failing, 500u);
+}
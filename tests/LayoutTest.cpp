@@ -0,0 +1,88 @@
+#include "TestUtil.h"
+#include <Layout.h>
+#include <format>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+using testing::ElementsAre;
+
+class Layout: public testing::Test {
+    protected:
+        Layout(): registry(symbols) {}
+
+        // Fields by offset as `field@offset`, then size and padding
+        static std::string describe(const StructLayout& layout) {
+            std::string text;
+            for(const auto& field: layout.fields) {
+                text += std::format("{}@{} ", field.field, field.offset);
+            }
+            return text + std::format("size {} padding {}", layout.size, layout.padding);
+        }
+        std::string members(std::vector<const Type*> fields, LayoutRule rule, bool reorder_fields = false) {
+            return describe(layout_members(registry, fields, rule, reorder_fields));
+        }
+        Type* add_struct(const char* name, std::vector<std::pair<const char*, Type*>> fields) {
+            std::vector<StructField> struct_fields;
+            for(const auto& [field, type]: fields) {
+                struct_fields.push_back(StructField {.name = symbols.intern(field), .type = type});
+            }
+            return registry.add_struct(symbols.intern(name), std::move(struct_fields));
+        }
+
+        SymbolInterner symbols;
+        TypeRegistry registry;
+        Type* f = registry.get_float();
+        Type* f3 = registry.vector(ScalarKind::Float, 3);
+};
+
+// float3 aligns like float4 except in the scalar layout, a float after it
+// fills the hole either way
+TEST_F(Layout, Float3ThenFloat) {
+    EXPECT_EQ(members({f3, f}, LayoutRule::Std140), "0@0 1@12 size 16 padding 0");
+    EXPECT_EQ(members({f3, f}, LayoutRule::Std430), "0@0 1@12 size 16 padding 0");
+    EXPECT_EQ(members({f3, f}, LayoutRule::Scalar), "0@0 1@12 size 16 padding 0");
+
+    EXPECT_EQ(members({f, f3}, LayoutRule::Std140), "0@0 1@16 size 32 padding 16");
+    EXPECT_EQ(members({f, f3}, LayoutRule::Std430), "0@0 1@16 size 32 padding 16");
+    EXPECT_EQ(members({f, f3}, LayoutRule::Scalar), "0@0 1@4 size 16 padding 0");
+}
+// Structs align to 16 in std140 and take their padded size
+TEST_F(Layout, NestedStruct) {
+    Type* inner = add_struct("Inner", {{"x", f}});
+    Type* outer = add_struct("Outer", {{"a", f}, {"i", inner}, {"b", f}});
+
+    EXPECT_EQ(layout_align_of(registry, inner, LayoutRule::Std140), 16u);
+    EXPECT_EQ(layout_size_of(registry, inner, LayoutRule::Std140), 16u);
+    EXPECT_EQ(describe(layout_struct(registry, outer, LayoutRule::Std140)), "0@0 1@16 2@32 size 48 padding 24");
+    EXPECT_EQ(describe(layout_struct(registry, outer, LayoutRule::Std430)), "0@0 1@4 2@8 size 12 padding 0");
+}
+// half3 aligns to 8 and takes 6 bytes
+TEST_F(Layout, HalfVectors) {
+    Type* h = registry.get_half();
+    Type* h2 = registry.vector(ScalarKind::Half, 2);
+    Type* h3 = registry.vector(ScalarKind::Half, 3);
+
+    EXPECT_EQ(members({h, h3, h2}, LayoutRule::Std140), "0@0 1@8 2@16 size 32 padding 20");
+    EXPECT_EQ(members({h, h3, h2}, LayoutRule::Std430), "0@0 1@8 2@16 size 24 padding 12");
+    EXPECT_EQ(members({h, h3, h2}, LayoutRule::Scalar), "0@0 1@2 2@8 size 12 padding 0");
+}
+// The floats fill the holes after the float3s once reordered
+TEST_F(Layout, Reordering) {
+    Type* s = add_struct("S", {{"a", f}, {"p", f3}, {"b", f}, {"q", f3}});
+
+    EXPECT_EQ(describe(layout_struct(registry, s, LayoutRule::Std140)), "0@0 1@16 2@28 3@32 size 48 padding 16");
+    EXPECT_EQ(describe(layout_struct(registry, s, LayoutRule::Std140, true)), "1@0 0@12 3@16 2@28 size 32 padding 0");
+    EXPECT_EQ(layout_size_of(registry, s, LayoutRule::Std140), 48u);
+    EXPECT_EQ(layout_size_of(registry, s, LayoutRule::Std140, true), 32u);
+}
+
+TEST(StructDecl, NoFields) {
+    EXPECT_THAT(Testing::errors_of("struct S {}"), ElementsAre("1:8: Struct S has no fields"));
+}
+TEST(StructDecl, VoidField) {
+    EXPECT_THAT(Testing::errors_of("struct S { a: float, b: void }"), ElementsAre("1:22: Field b can't be void"));
+}
+TEST(StructDecl, FieldRedefinition) {
+    EXPECT_THAT(Testing::errors_of("struct S { a: float, b: float3, a: float3 }"), ElementsAre("1:33: Redefinition of field a"));
+}
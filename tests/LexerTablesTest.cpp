@@ -0,0 +1,98 @@
+#include <Parse/LexerTables.h>
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+// What the perfect hash has to agree with
+static std::optional<TokenKind> linear_keyword(std::string_view text) {
+    for(const auto& keyword: LexerTables::KEYWORDS) {
+        if(keyword.text == text) {
+            return keyword.kind;
+        }
+    }
+    return std::nullopt;
+}
+// What the lexer makes of each of `names`, nullopt for identifiers. Lexed
+// as one source, so the lookup runs as it does in Lexer::token().
+static std::vector<std::optional<TokenKind>> lexed_keywords(const std::vector<std::string>& names) {
+    std::string source;
+    for(const auto& name: names) {
+        source += name + " ";
+    }
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("keywords.hksl", source);
+    Lexer lexer(sources.file(file), symbols);
+
+    std::vector<std::optional<TokenKind>> kinds;
+    for(size_t i = 0; i < names.size(); i++) {
+        TokenKind kind = lexer.token().kind;
+        kinds.push_back(kind == TokenKind::Identifier ? std::nullopt : std::optional(kind));
+    }
+    EXPECT_EQ(lexer.token().kind, TokenKind::Eof);
+    return kinds;
+}
+
+TEST(LexerTables, EveryKeywordHasItsOwnSlot) {
+    size_t filled = 0;
+    for(const auto& slot: LexerTables::KEYWORD_TABLE) {
+        if(!slot.text.empty()) {
+            EXPECT_EQ(linear_keyword(slot.text), slot.kind) << slot.text;
+            filled++;
+        }
+    }
+    EXPECT_EQ(filled, std::size(LexerTables::KEYWORDS));
+    for(const auto& keyword: LexerTables::KEYWORDS) {
+        EXPECT_EQ(Lexer::is_keyword(keyword.text), keyword.kind) << keyword.text;
+    }
+}
+TEST(LexerTables, NearMissesAreIdentifiers) {
+    for(const auto& keyword: LexerTables::KEYWORDS) {
+        std::string text(keyword.text);
+        for(std::string near: {text + "s", "_" + text, text.substr(1), text.substr(0, text.size() - 1), text + text}) {
+            EXPECT_EQ(Lexer::is_keyword(near), linear_keyword(near)) << near;
+        }
+        // Same first char, last char and length, so the same slot
+        std::string middle = text;
+        if(middle.size() > 2) {
+            middle[1] = 'z';
+            EXPECT_EQ(Lexer::is_keyword(middle), std::nullopt) << middle;
+        }
+        std::string upper = text;
+        upper[0] -= 'a' - 'A';
+        EXPECT_EQ(Lexer::is_keyword(upper), std::nullopt) << upper;
+    }
+}
+// Every name of up to 3 characters, and random longer ones built from the
+// keywords' letters, through the lexer. Names starting with a digit would
+// lex as numbers.
+TEST(LexerTables, AgreesWithKeywordList) {
+    const std::string letters = "abcdefghijklmnopqrstuvwxyz_0";
+    std::vector<std::string> names;
+    for(char a: letters) {
+        names.push_back({a});
+        for(char b: letters) {
+            names.push_back({a, b});
+            for(char c: letters) {
+                names.push_back({a, b, c});
+            }
+        }
+    }
+    std::mt19937 rng(3);
+    const std::string keyword_letters = "efilmnorstucf";
+    for(int i = 0; i < 100000; i++) {
+        std::string name;
+        for(size_t n = rng() % 8 + 1; n > 0; n--) {
+            name += keyword_letters[rng() % keyword_letters.size()];
+        }
+        names.push_back(name);
+    }
+    std::erase_if(names, [] (const std::string& name) {
+        return name[0] == '0';
+    });
+    auto lexed = lexed_keywords(names);
+    for(size_t i = 0; i < names.size(); i++) {
+        ASSERT_EQ(lexed[i], linear_keyword(names[i])) << names[i];
+    }
+}
@@ -0,0 +1,92 @@
+#include "TestUtil.h"
+#include <Parse/Numeric.h>
+#include <format>
+#include <iostream>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+static uint32_t half_bits(std::string_view digits, bool hex) {
+    auto literal = parse_number(digits, hex, NumberKind::Half);
+    EXPECT_TRUE(literal.has_value()) << digits;
+    return literal ? literal->bits : 0;
+}
+// Bits of a float literal, or "out of range"
+static std::string float_bits(std::string_view digits, bool hex = false) {
+    auto literal = parse_number(digits, hex, NumberKind::Float);
+    return literal ? std::format("{:#010x}", literal->bits) : "out of range";
+}
+// The one number literal in `source`, as "kind bits", or the lexer's error
+static std::string lex_number(const std::string& source) {
+    return Testing::run_isolated([&] {
+        SymbolInterner symbols;
+        SourceManager sources;
+        uint32_t file = sources.add_buffer("test.hksl", source);
+        Lexer lexer(sources.file(file), symbols);
+        Token token = lexer.token();
+        const NumberLiteral& literal = token.unwrap_number_literal();
+        std::cout << (literal.kind == NumberKind::Half ? "half " : "float ") << std::format("{:#x}", literal.bits) << " " << token.span.length << "\n";
+    });
+}
+
+TEST(Numeric, DecimalFloats) {
+    EXPECT_EQ(float_bits("0.1"), "0x3dcccccd");
+    EXPECT_EQ(float_bits("1.0"), "0x3f800000");
+    EXPECT_EQ(float_bits("2.5e3"), "0x451c4000");
+    EXPECT_EQ(float_bits("0.0"), "0x00000000");
+    // 2^24 + 1 is a tie, to even
+    EXPECT_EQ(float_bits("16777217.0"), "0x4b800000");
+    EXPECT_EQ(float_bits("16777219.0"), "0x4b800002");
+}
+TEST(Numeric, SubnormalFloats) {
+    // Smallest and largest subnormal
+    EXPECT_EQ(float_bits("1.4e-45"), "0x00000001");
+    EXPECT_EQ(float_bits("1.1754942e-38"), "0x007fffff");
+    EXPECT_EQ(float_bits("1p-149", true), "0x00000001");
+    // Smallest normal
+    EXPECT_EQ(float_bits("1.17549435e-38"), "0x00800000");
+    // Below half the smallest subnormal rounds to zero
+    EXPECT_EQ(float_bits("1e-46"), "0x00000000");
+    EXPECT_EQ(float_bits("1e-400"), "0x00000000");
+}
+// Literals past the largest float are rejected rather than made infinite
+TEST(Numeric, FloatOverflow) {
+    EXPECT_EQ(float_bits("3.4028234e38"), "0x7f7fffff");
+    EXPECT_EQ(float_bits("3.4028236e38"), "out of range");
+    EXPECT_EQ(float_bits("1e39"), "out of range");
+    EXPECT_EQ(float_bits("1p128", true), "out of range");
+    EXPECT_EQ(lex_number("1e39;"), "Number literal out of range: 1e39\nexit status: 65280\n");
+    // 65520 is the tie between the largest half and infinity
+    EXPECT_EQ(half_bits("65504", false), 0x7BFFu);
+    EXPECT_FALSE(parse_number("65520", false, NumberKind::Half).has_value());
+}
+
+// The double nearest to these literals lies exactly halfway between two
+// halves, only the bits past the double's precision tell which way to round
+TEST(Numeric, LongHexRoundsOnceToHalf) {
+    // 1 + 2^-11 + 2^-60, just above the tie between 1.0 and 1 + 2^-10
+    EXPECT_EQ(half_bits("1.00200000000001p0", true), 0x3C01u);
+    // 1 + 3 * 2^-11 - 2^-60, just below the tie between 1 + 2^-10 and 1 + 2^-9
+    EXPECT_EQ(half_bits("1.005fffffffffffffp0", true), 0x3C01u);
+    // The ties themselves go to even
+    EXPECT_EQ(half_bits("1.002p0", true), 0x3C00u);
+    EXPECT_EQ(half_bits("1.006p0", true), 0x3C02u);
+    // Same bits, spelled with the point elsewhere
+    EXPECT_EQ(half_bits("100.200000000001p-8", true), 0x3C01u);
+    EXPECT_EQ(half_bits("0.0100200000000001p8", true), 0x3C01u);
+}
+TEST(Numeric, LongDecimalRoundsOnceToHalf) {
+    // 1 + 2^-11 = 1.00048828125, plus a digit past the double's precision
+    EXPECT_EQ(half_bits("1.000488281250000000000001", false), 0x3C01u);
+    EXPECT_EQ(half_bits("1.00048828125", false), 0x3C00u);
+}
+
+// f is a hex digit, without an exponent 0x1.8f would be ambiguous
+TEST(Numeric, HexFloatsNeedAnExponent) {
+    EXPECT_EQ(lex_number("0x1.8p0f;"), "float 0x3fc00000 8\nexit status: 0\n");
+    EXPECT_EQ(lex_number("0x1.8p0h;"), "half 0x3e00 8\nexit status: 0\n");
+    EXPECT_EQ(lex_number("0x1fp0;"), "float 0x41f80000 6\nexit status: 0\n");
+    EXPECT_EQ(lex_number("0x1.8f;"), "Hex float literal needs a p exponent: 0x1.8f\nexit status: 65280\n");
+    EXPECT_EQ(lex_number("0x1.8h;"), "Hex float literal needs a p exponent: 0x1.8\nexit status: 65280\n");
+    EXPECT_EQ(lex_number("0x1.8p;"), "Hex float literal needs a p exponent: 0x1.8\nexit status: 65280\n");
+}
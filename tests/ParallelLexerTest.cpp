@@ -0,0 +1,77 @@
+#include "TestUtil.h"
+#include <Parse/ParallelLexer.h>
+#include <format>
+#include <iostream>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+// About 1.5MB, several lex chunks, with `insert` spliced in at each of
+// `at` (fractions of the size, rounded to the next line)
+static std::string source_with(std::initializer_list<std::pair<double, std::string>> inserts = {}) {
+    std::string source;
+    for(size_t i = 0; source.size() < 1536 * 1024; i++) {
+        source += std::format(
+            "// function {}\n"
+            "fn f{}(a: float, b: float3) -> float3 {{\n"
+            "    let c = a * {}.25e-1 + 0x1.8p{} - 3.0h;\n"
+            "    b += float3(c, c, c); return b;\n"
+            "}}\n", i, i, i, i % 8);
+    }
+    size_t shift = 0;
+    for(const auto& [at, insert]: inserts) {
+        size_t line = source.find('\n', at * source.size() + shift) + 1;
+        source.insert(line, insert);
+        shift += insert.size();
+    }
+    return source;
+}
+// Every token as text, symbols by name since their ids depend on the order
+// they were interned in. With Lexer::collect_tokens() if `n_threads` is 0.
+static std::string lex(const std::string& source, size_t n_threads) {
+    return Testing::run_isolated([&] {
+        SymbolInterner symbols;
+        SourceManager sources;
+        uint32_t file = sources.add_buffer("test.hksl", source);
+        TokenBuffer tokens(file);
+        if(n_threads == 0) {
+            Lexer lexer(sources.file(file), symbols);
+            tokens = lexer.collect_tokens();
+        } else {
+            ThreadPool pool(n_threads);
+            tokens = lex_parallel(sources.file(file), symbols, pool);
+        }
+        for(size_t i = 0; i < tokens.size(); i++) {
+            Token token = tokens.token(i);
+            std::cout << token.to_string(symbols);
+            if(token.kind == TokenKind::Number) {
+                std::cout << " bits " << token.unwrap_number_literal().bits;
+            }
+            std::cout << "\n";
+        }
+    });
+}
+
+TEST(ParallelLexer, SameTokensAsSequential) {
+    std::string source = source_with();
+    std::string sequential = lex(source, 0);
+    ASSERT_NE(sequential.find("exit status: 0"), std::string::npos);
+    for(size_t n_threads: {1, 2, 4, 8}) {
+        EXPECT_EQ(lex(source, n_threads), sequential) << "with " << n_threads << " threads";
+    }
+}
+// A zero byte ends the source, chunks after it are dropped
+TEST(ParallelLexer, StopsAtZeroByte) {
+    std::string source = source_with({{0.5, std::string("let x = 1.0;\n\0", 14)}});
+    EXPECT_EQ(lex(source, 4), lex(source, 0));
+}
+// Every chunk stops at its own first error, the earliest in the file is
+// reported no matter which chunk finishes first
+TEST(ParallelLexer, ReportsEarliestError) {
+    std::string source = source_with({{0.3, "let x = 0x;\n"}, {0.6, "let $ = 1.0;\n"}, {0.9, "0x;\n"}});
+    std::string sequential = lex(source, 0);
+    ASSERT_NE(sequential.find("Expected hex digits after 0x"), std::string::npos);
+    for(int run = 0; run < 10; run++) {
+        EXPECT_EQ(lex(source, 4), sequential);
+    }
+}
@@ -0,0 +1,131 @@
+#include "TestUtil.h"
+#include <AST/Printer.h>
+#include <Context.h>
+#include <Parse/ParallelParser.h>
+#include <Parse/Parser.h>
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <span>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+// Enough functions for several parse chunks, with `bad` replaced by
+// `broken` at the given function indexes
+static std::string functions(size_t count, std::span<const size_t> bad, const std::string& broken) {
+    std::string source;
+    for(size_t i = 0; i < count; i++) {
+        if(std::find(bad.begin(), bad.end(), i) != bad.end()) {
+            source += broken;
+            continue;
+        }
+        source += std::format("fn f{}(a: float, b: float) -> float {{\n    let c = a * b + {}.0;\n    return c - a / b;\n}}\n", i, i);
+    }
+    return source;
+}
+// With Parser::program() if `n_threads` is 0
+static std::string parse(const std::string& source, size_t n_threads) {
+    return Testing::run_isolated([&] {
+        SymbolInterner symbols;
+        SourceManager sources;
+        uint32_t file = sources.add_buffer("test.hksl", source);
+        CompilationContext context(symbols, sources);
+        Lexer lexer(sources.file(file), symbols);
+        TokenBuffer tokens = lexer.collect_tokens();
+        AST ast;
+        if(n_threads == 0) {
+            Parser parser(context, tokens);
+            ast = parser.program();
+        } else {
+            ThreadPool pool(n_threads);
+            ast = parse_parallel(context, tokens, pool);
+        }
+        std::cout << ast.top_level().size() << " statements\n";
+    });
+}
+
+// Functions with nested ifs, calls and lets, each calling the one before
+static std::string nested_functions(size_t count) {
+    std::string source;
+    for(size_t i = 0; i < count; i++) {
+        size_t callee = i == 0 ? 0 : i - 1;
+        source += std::format(
+            "fn g{}(a: float, b: float3) -> float3 {{\n"
+            "    let c: float = a * {}.5;\n"
+            "    if c {{\n"
+            "        let d = g{}(c, b * c);\n"
+            "        if a - c {{\n            return d;\n        }} else if a {{\n            c = -a;\n        }}\n"
+            "    }} else {{\n        c = 1.0;\n    }}\n"
+            "    return -b * g{}(a + c, float3(a, c, 1.0));\n"
+            "}}\n", i, i % 100, callee, callee);
+    }
+    return source;
+}
+// Every node by id with its kind, span and type, then the printed tree
+static std::string dump(const std::string& source, size_t n_threads) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("test.hksl", source);
+    CompilationContext context(symbols, sources);
+    Lexer lexer(sources.file(file), symbols);
+    TokenBuffer tokens = lexer.collect_tokens();
+    AST ast;
+    if(n_threads == 0) {
+        Parser parser(context, tokens);
+        ast = parser.program();
+    } else {
+        // Enough tokens for several chunks
+        EXPECT_GT(tokens.size(), 4 * PARALLEL_PARSE_MIN_CHUNK);
+        ThreadPool pool(n_threads);
+        ast = parse_parallel(context, tokens, pool);
+    }
+
+    auto type_name = [] (const Type* type) {
+        return type ? type->name() : "-";
+    };
+    std::string nodes;
+    for(NodeId node = 0; node < ast.size(); node++) {
+        Span span = ast.span(node);
+        nodes += std::format("{} {} {}+{}", node, node_kind_to_string(ast.kind(node)), span.offset, span.length);
+        if(ast.kind(node) == NodeKind::VarDecl) {
+            nodes += std::format(" : {}", type_name(ast.var_decl(node).type));
+        } else if(ast.kind(node) == NodeKind::Function) {
+            nodes += std::format(" -> {}", type_name(ast.function(node).return_type));
+        }
+        nodes += "\n";
+    }
+
+    ASTPrinter printer(symbols);
+    testing::internal::CaptureStdout();
+    ast.print(printer);
+    return nodes + testing::internal::GetCapturedStdout();
+}
+
+TEST(ParallelParser, SameTreeAsSequential) {
+    std::string source = functions(5000, {}, "");
+    EXPECT_EQ(parse(source, 0), "5000 statements\nexit status: 0\n");
+    EXPECT_EQ(parse(source, 4), parse(source, 0));
+}
+// Ids, spans, child lists and type slots are all remapped when the chunks
+// are joined
+TEST(ParallelParser, SameNodesAsSequential) {
+    std::string source = nested_functions(2000);
+    std::string sequential = dump(source, 0);
+    std::string parallel = dump(source, 4);
+    // The dumps are megabytes, show where they start to differ
+    auto diverge = std::mismatch(sequential.begin(), sequential.end(), parallel.begin(), parallel.end());
+    size_t line_start = sequential.rfind('\n', diverge.first - sequential.begin()) + 1;
+    EXPECT_EQ(parallel.substr(line_start, 200), sequential.substr(line_start, 200));
+}
+// Every chunk stops at its own first error, the earliest in the file is
+// reported no matter which chunk finishes first
+TEST(ParallelParser, ReportsEarliestSyntaxError) {
+    const size_t bad[] = {1200, 2600, 4100};
+    std::string source = functions(5000, bad, "fn broken() {\n    let = 1.0;\n}\n");
+    std::string sequential = parse(source, 0);
+    ASSERT_NE(sequential.find("Expected Identifier on line 4802:9"), std::string::npos) << sequential;
+    for(int run = 0; run < 20; run++) {
+        EXPECT_EQ(parse(source, 4), sequential);
+    }
+}
@@ -0,0 +1,75 @@
+#include <Parse/Parser.h>
+#include <cstdlib>
+#include <format>
+#include <new>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+// Replaces the global allocator for the whole test binary, allocations are
+// only counted on the thread that sets `counting`
+static thread_local bool counting = false;
+static thread_local size_t allocation_count = 0;
+
+void* operator new(size_t size) {
+    if(counting) {
+        allocation_count++;
+    }
+    if(void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Allocations made by Parser::program() alone, on a function returning
+// one expression of `n_terms` operands mixing every precedence level,
+// prefix operators, parentheses and calls
+static size_t parse_allocations(size_t n_terms) {
+    std::string source = "fn g(x: float) -> float {\n    return x;\n}\nfn f(a: float, b: float) -> float {\n    return a";
+    for(size_t i = 0; i < n_terms; i++) {
+        const char* terms[] = {" + b", " * -a", " - (a / b)", " / g(a + 1.0)", " + 2.5 * -(b - a)"};
+        source += terms[i % std::size(terms)];
+    }
+    source += ";\n}\n";
+
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("test.hksl", source);
+    CompilationContext context(symbols, sources);
+    Lexer lexer(sources.file(file), symbols);
+    TokenBuffer tokens = lexer.collect_tokens();
+    Parser parser(context, tokens);
+
+    allocation_count = 0;
+    counting = true;
+    AST ast = parser.program();
+    counting = false;
+    return allocation_count;
+}
+
+// Node storage and the operator stacks grow geometrically, so 100 times the
+// nodes only adds a few reallocations per array, not one per node
+TEST(ParserAllocation, ExpressionsDontAllocatePerNode) {
+    size_t small = parse_allocations(1000);
+    size_t large = parse_allocations(100000);
+    RecordProperty("allocations_1k", small);
+    RecordProperty("allocations_100k", large);
+    // The replaced allocator has to be the one in use
+    ASSERT_GT(small, 0u);
+    EXPECT_LT(large, small + 200) << small << " allocations for 1k terms, " << large << " for 100k";
+}
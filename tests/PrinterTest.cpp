@@ -0,0 +1,36 @@
+#include <AST/Printer.h>
+#include <Parse/Parser.h>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+static std::string print(const std::string& source) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("test.hksl", source);
+    CompilationContext context(symbols, sources);
+    Lexer lexer(sources.file(file), symbols);
+    Parser parser(context, lexer);
+    AST ast = parser.program();
+
+    ASTPrinter printer(symbols);
+    testing::internal::CaptureStdout();
+    ast.print(printer);
+    return testing::internal::GetCapturedStdout();
+}
+static size_t count(const std::string& text, const std::string& part) {
+    size_t n = 0;
+    for(size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + 1)) {
+        n++;
+    }
+    return n;
+}
+
+// Every field of a node is printed under its own label
+TEST(Printer, FieldLabels) {
+    std::string printed = print("fn f(a: float) {\n    let x: float;\n    x = a;\n    if x {\n        x = 1.0;\n    }\n}\n");
+    EXPECT_EQ(count(printed, "lhs: "), 2u) << printed;
+    EXPECT_EQ(count(printed, "rhs: "), 2u) << printed;
+    EXPECT_EQ(count(printed, "condition: "), 1u) << printed;
+    EXPECT_EQ(count(printed, "then_block: "), 1u) << printed;
+}
@@ -0,0 +1,179 @@
+#include <ReflectionWriter.h>
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+static const char* SOURCE = R"(struct Light {
+    color: float3,
+    intensity: float,
+}
+uniform(frame) time: float;
+uniform(frame) light: Light;
+uniform(material) tint: float3;
+uniform scale: float;
+
+fn vertex_main(p: float4, uv: float2) -> float4 {
+    return p * float4(scale, scale, scale, 1.0) + float4(uv, time, 0.0);
+}
+fn fragment_main(n: float3) -> float3 {
+    return n * tint;
+}
+fn helper(x: float) -> float {
+    return x;
+}
+)";
+
+// Blob and what it was written from
+struct Compiled {
+    SymbolInterner symbols;
+    CompilationResult result;
+    Compiled(uint32_t push_constant_budget) {
+        Compiler compiler(symbols, 1);
+        compiler.set_push_constant_budget(push_constant_budget);
+        result = compiler.compile("test.hksl", SOURCE);
+    }
+};
+
+// Every section read back matches what the compiler reported
+TEST(Reflection, RoundTrip) {
+    for(uint32_t budget: {0, 128}) {
+        Compiled compiled(budget);
+        const CompilationResult& result = compiled.result;
+        ASSERT_TRUE(result.errors.empty());
+        Reflection::Reader reader(result.reflection.data(), result.reflection.size());
+        ASSERT_TRUE(reader.valid());
+        EXPECT_EQ(reader.header().size, result.reflection.size());
+        auto type_name = [&] (uint32_t type) {
+            return std::string(reader.string(reader.types()[type].name));
+        };
+
+        ASSERT_EQ(reader.structs().size(), 1u);
+        const auto& light = reader.structs()[0];
+        const StructReport& report = result.structs[0];
+        EXPECT_STREQ(reader.string(light.name), "Light");
+        ASSERT_EQ(reader.fields(light).size(), 2u);
+        for(size_t rule = 0; rule < Reflection::LAYOUT_COUNT; rule++) {
+            EXPECT_EQ(light.size[rule], report.layouts[rule].size);
+            EXPECT_EQ(light.alignment[rule], report.layouts[rule].alignment);
+            EXPECT_EQ(light.padding[rule], report.layouts[rule].padding);
+            for(const auto& field: report.layouts[rule].fields) {
+                EXPECT_EQ(reader.fields(light)[field.field].offset[rule], field.offset);
+            }
+        }
+        EXPECT_STREQ(reader.string(reader.fields(light)[0].name), "color");
+        EXPECT_EQ(type_name(reader.fields(light)[0].type), "float3");
+        EXPECT_STREQ(reader.string(reader.fields(light)[1].name), "intensity");
+        EXPECT_EQ(type_name(reader.fields(light)[1].type), "float");
+        for(const auto& type: reader.types()) {
+            bool is_struct = type.kind == Reflection::TypeKind::Struct;
+            EXPECT_EQ(type.struct_index, is_struct ? 0 : Reflection::NO_INDEX) << reader.string(type.name);
+        }
+
+        // helper isn't an entry point
+        ASSERT_EQ(reader.entry_points().size(), 2u);
+        const auto& vertex = reader.entry_points()[0];
+        EXPECT_STREQ(reader.string(vertex.name), "vertex_main");
+        EXPECT_EQ(vertex.stage, Reflection::Stage::Vertex);
+        EXPECT_EQ(type_name(vertex.output_type), "float4");
+        ASSERT_EQ(reader.inputs(vertex).size(), 2u);
+        EXPECT_STREQ(reader.string(reader.inputs(vertex)[1].name), "uv");
+        EXPECT_EQ(type_name(reader.inputs(vertex)[1].type), "float2");
+        EXPECT_EQ(reader.inputs(vertex)[1].location, 1u);
+        const auto& fragment = reader.entry_points()[1];
+        EXPECT_STREQ(reader.string(fragment.name), "fragment_main");
+        EXPECT_EQ(fragment.stage, Reflection::Stage::Fragment);
+        ASSERT_EQ(reader.inputs(fragment).size(), 1u);
+        EXPECT_STREQ(reader.string(reader.inputs(fragment)[0].name), "n");
+
+        ASSERT_EQ(reader.uniform_blocks().size(), result.uniform_blocks.size());
+        size_t n_uniforms = 0;
+        for(size_t i = 0; i < result.uniform_blocks.size(); i++) {
+            const UniformBlock& block = result.uniform_blocks[i];
+            const auto& record = reader.uniform_blocks()[i];
+            EXPECT_EQ((uint8_t) record.kind, (uint8_t) block.kind);
+            EXPECT_EQ((uint8_t) record.frequency, (uint8_t) block.frequency);
+            EXPECT_EQ(record.binding, block.binding);
+            EXPECT_EQ(record.size, block.size);
+            ASSERT_EQ(reader.uniforms(record).size(), block.members.size());
+            for(size_t j = 0; j < block.members.size(); j++) {
+                const auto& uniform = reader.uniforms(record)[j];
+                EXPECT_EQ(reader.string(uniform.name), block.members[j].name);
+                EXPECT_EQ(uniform.block, i);
+                EXPECT_EQ(uniform.offset, block.members[j].offset);
+                EXPECT_EQ(uniform.accesses, block.members[j].accesses);
+                EXPECT_EQ((uint8_t) uniform.frequency, (uint8_t) block.members[j].frequency);
+            }
+            n_uniforms += block.members.size();
+        }
+        EXPECT_EQ(n_uniforms, 4u);
+        EXPECT_EQ(reader.uniforms().size(), 4u);
+
+        std::string json = reflection_to_json(reader);
+        for(const char* part: {"\"name\": \"vertex_main\"", "\"name\": \"Light\"", "\"name\": \"uv\", \"type\": \"float2\", \"location\": 1", "\"name\": \"tint\""}) {
+            EXPECT_NE(json.find(part), std::string::npos) << part << " in\n" << json;
+        }
+    }
+}
+
+// A blob cut short anywhere, even inside the last section's padding, is
+// rejected before any section is read
+TEST(Reflection, TruncatedBlobIsInvalid) {
+    Compiled compiled(DEFAULT_PUSH_CONSTANT_BUDGET);
+    const auto& blob = compiled.result.reflection;
+    for(size_t size = 0; size < blob.size(); size++) {
+        // A fresh copy, so reads past `size` would be caught by sanitizers
+        std::vector<uint8_t> truncated(blob.begin(), blob.begin() + size);
+        EXPECT_FALSE(Reflection::Reader(truncated.data(), truncated.size()).valid()) << size << " of " << blob.size() << " bytes";
+    }
+}
+// Sections pointing outside the blob are rejected too
+TEST(Reflection, CorruptHeaderIsInvalid) {
+    Compiled compiled(DEFAULT_PUSH_CONSTANT_BUDGET);
+    auto corrupt = [&] (auto&& change) {
+        std::vector<uint8_t> blob = compiled.result.reflection;
+        Reflection::Header header;
+        std::memcpy(&header, blob.data(), sizeof(header));
+        change(header);
+        std::memcpy(blob.data(), &header, sizeof(header));
+        return Reflection::Reader(blob.data(), blob.size()).valid();
+    };
+    EXPECT_TRUE(corrupt([] (Reflection::Header&) {}));
+    EXPECT_FALSE(corrupt([] (Reflection::Header& header) { header.magic++; }));
+    EXPECT_FALSE(corrupt([] (Reflection::Header& header) { header.version++; }));
+    EXPECT_FALSE(corrupt([] (Reflection::Header& header) { header.section_count--; }));
+    EXPECT_FALSE(corrupt([] (Reflection::Header& header) { header.sections[(size_t) Reflection::Section::Fields].count += 1000; }));
+    EXPECT_FALSE(corrupt([] (Reflection::Header& header) { header.sections[(size_t) Reflection::Section::Types].offset = header.size + 4; }));
+    EXPECT_FALSE(corrupt([] (Reflection::Header& header) { header.sections[(size_t) Reflection::Section::Uniforms].offset += 2; }));
+}
+// Whether `blob` is still valid with the first record of `section`, a T,
+// changed by `change`
+template<typename T, typename F>
+static bool valid_with_record(std::vector<uint8_t> blob, Reflection::Section section, F&& change) {
+    Reflection::Header header;
+    std::memcpy(&header, blob.data(), sizeof(header));
+    uint8_t* at = blob.data() + header.sections[(size_t) section].offset;
+    T record;
+    std::memcpy(&record, at, sizeof(record));
+    change(record);
+    std::memcpy(at, &record, sizeof(record));
+    return Reflection::Reader(blob.data(), blob.size()).valid();
+}
+// So are records naming strings, records or ranges outside their sections
+TEST(Reflection, CorruptRecordIsInvalid) {
+    using namespace Reflection;
+    Compiled compiled(DEFAULT_PUSH_CONSTANT_BUDGET);
+    const auto& blob = compiled.result.reflection;
+    EXPECT_TRUE(valid_with_record<TypeRecord>(blob, Section::Types, [] (TypeRecord&) {}));
+    EXPECT_FALSE(valid_with_record<TypeRecord>(blob, Section::Types, [] (TypeRecord& type) { type.name = 1u << 20; }));
+    EXPECT_FALSE(valid_with_record<TypeRecord>(blob, Section::Types, [] (TypeRecord& type) { type.struct_index = 1; }));
+    EXPECT_FALSE(valid_with_record<StructRecord>(blob, Section::Structs, [] (StructRecord& record) { record.field_count = 3; }));
+    EXPECT_FALSE(valid_with_record<StructRecord>(blob, Section::Structs, [] (StructRecord& record) { record.first_field = UINT32_MAX; }));
+    EXPECT_FALSE(valid_with_record<FieldRecord>(blob, Section::Fields, [] (FieldRecord& field) { field.type = 1000; }));
+    EXPECT_FALSE(valid_with_record<EntryPointRecord>(blob, Section::EntryPoints, [] (EntryPointRecord& entry_point) { entry_point.input_count = UINT32_MAX; }));
+    EXPECT_FALSE(valid_with_record<EntryPointRecord>(blob, Section::EntryPoints, [] (EntryPointRecord& entry_point) { entry_point.output_type = 1000; }));
+    EXPECT_FALSE(valid_with_record<InputRecord>(blob, Section::Inputs, [] (InputRecord& input) { input.type = 1000; }));
+    EXPECT_FALSE(valid_with_record<BlockRecord>(blob, Section::UniformBlocks, [] (BlockRecord& block) { block.member_count = 5; }));
+    EXPECT_FALSE(valid_with_record<UniformRecord>(blob, Section::Uniforms, [] (UniformRecord& uniform) { uniform.block = 7; }));
+    EXPECT_FALSE(valid_with_record<UniformRecord>(blob, Section::Uniforms, [] (UniformRecord& uniform) { uniform.name = UINT32_MAX; }));
+}
@@ -0,0 +1,109 @@
+#include <Parse/Scan.h>
+#include <Source.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+using ScanFn = const char* (*)(const char*);
+// The functions of `scanner`, named for failure messages
+static std::vector<std::pair<std::string, ScanFn>> scan_functions(const Scanner& scanner) {
+    return {
+        {std::string(scanner.name) + ".skip_white_space", scanner.skip_white_space},
+        {std::string(scanner.name) + ".skip_line", scanner.skip_line},
+        {std::string(scanner.name) + ".skip_identifier", scanner.skip_identifier},
+    };
+}
+// The vector scanners the CPU supports
+static std::vector<const Scanner*> simd_scanners() {
+    std::vector<const Scanner*> scanners;
+    for(const Scanner* scanner: {Scanner::sse2(), Scanner::avx2()}) {
+        if(scanner) {
+            scanners.push_back(scanner);
+        }
+    }
+    return scanners;
+}
+
+// Random bytes, mostly the classes the scanners look for in runs long
+// enough to cross vector loads, every other non-zero byte mixed in
+TEST(Scan, SimdMatchesScalar) {
+    std::mt19937 rng(7);
+    const std::string classes[] = {" \t\r\n", "abcxyzABCXYZ0189_", "+-*/(){};:=.,"};
+    std::string text;
+    while(text.size() < 64 * 1024) {
+        std::uniform_int_distribution<size_t> run(1, 80);
+        if(rng() % 8 == 0) {
+            text += (char) std::uniform_int_distribution<int>(1, 255)(rng);
+            continue;
+        }
+        const std::string& chars = classes[rng() % std::size(classes)];
+        for(size_t n = run(rng); n > 0; n--) {
+            text += chars[rng() % chars.size()];
+        }
+    }
+    SourceManager sources;
+    std::string_view padded = sources.file(sources.add_buffer("scan.hksl", text)).text();
+
+    auto scalar = scan_functions(Scanner::scalar());
+    for(const Scanner* scanner: simd_scanners()) {
+        auto simd = scan_functions(*scanner);
+        for(size_t f = 0; f < simd.size(); f++) {
+            for(size_t i = 0; i <= padded.size(); i++) {
+                const char* p = padded.data() + i;
+                ASSERT_EQ(simd[f].second(p) - p, scalar[f].second(p) - p) << simd[f].first << " at " << i;
+            }
+        }
+    }
+}
+
+// Runs up to the last byte of the source have to stop at the padding, the
+// only thing ending them, including when the run starts within a vector
+// load of the end
+static void expect_stops_at_end(std::string_view text) {
+    const char* end = text.data() + text.size();
+    for(size_t i = 0; i < SourceManager::PADDING; i++) {
+        ASSERT_EQ(end[i], '\0') << "padding byte " << i;
+    }
+
+    std::vector<const Scanner*> scanners = simd_scanners();
+    scanners.push_back(&Scanner::scalar());
+    for(const Scanner* scanner: scanners) {
+        for(size_t start = text.size() > 100 ? text.size() - 100 : 0; start <= text.size(); start++) {
+            const char* p = text.data() + start;
+            if(text.back() == ' ') {
+                EXPECT_EQ(scanner->skip_white_space(p), end) << scanner->name << " from " << start;
+                EXPECT_EQ(scanner->skip_line(p), end) << scanner->name << " from " << start;
+            } else {
+                EXPECT_EQ(scanner->skip_identifier(p), end) << scanner->name << " from " << start;
+            }
+        }
+    }
+}
+TEST(Scan, BufferPadding) {
+    for(size_t size = 1; size <= 130; size++) {
+        for(char ch: {' ', 'a'}) {
+            SourceManager sources;
+            expect_stops_at_end(sources.file(sources.add_buffer("scan.hksl", std::string(size, ch))).text());
+        }
+    }
+}
+// A mapped file ending exactly on a page boundary has its padding in the
+// separately mapped zero page after it
+TEST(Scan, MappedFilePadding) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    auto path = std::filesystem::temp_directory_path() / ("hksl_scan_" + std::to_string(getpid()) + ".hksl");
+    for(size_t size: {page_size - 1, page_size, page_size + 1, 2 * page_size - SourceManager::PADDING / 2}) {
+        for(char ch: {' ', 'a'}) {
+            std::ofstream(path, std::ios::binary) << std::string(size, ch);
+            SourceManager sources;
+            std::string_view text = sources.file(sources.load_file(path)).text();
+            ASSERT_EQ(text.size(), size);
+            expect_stops_at_end(text);
+        }
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,86 @@
+#include "TestUtil.h"
+#include <Context.h>
+#include <Parser.h>
+#include <Semantics.h>
+#include <TypeCheck.h>
+#include <ThreadPool.h>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace HKSL::Testing {
+CheckResult check(const std::string& source, bool fused, size_t n_threads) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("test.hksl", source);
+    CompilationContext context(symbols, sources);
+    ThreadPool pool(n_threads);
+
+    Lexer lexer(sources.file(file), symbols);
+    Parser parser(context, lexer);
+    context.set_ast(parser.program());
+
+    SemanticsVisitor semantics(context);
+    if(fused) {
+        semantics.run_fused(pool);
+    } else if(semantics.run(pool)) {
+        TypeInferenceVisitor type_inference(context);
+        type_inference.run(pool);
+    }
+
+    CheckResult result;
+    result.errors = context.errors();
+    AST& ast = context.get_ast();
+    for(NodeId node = 0; node < ast.size(); node++) {
+        Type* type = ast.kind(node) == NodeKind::VarDecl
+            ? ast.var_decl(node).type
+            : context.type_resolver().type_of(node);
+        result.types.push_back(type ? type->name() : "-");
+    }
+
+    return result;
+}
+std::vector<std::string> errors_of(const std::string& source) {
+    return check(source, false).errors;
+}
+std::string run_isolated(const std::function<void()>& body) {
+    int fds[2];
+    if(pipe(fds) != 0) {
+        return "pipe failed";
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if(pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        body();
+        std::cout.flush();
+        _exit(0);
+    }
+    close(fds[1]);
+
+    std::string output;
+    char buffer[4096];
+    ssize_t n;
+    while((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, n);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    return output + "exit status: " + std::to_string(status) + "\n";
+}
+std::string check_isolated(const std::string& source, bool fused, size_t n_threads) {
+    return run_isolated([&] {
+        CheckResult result = check(source, fused, n_threads);
+        for(const auto& error: result.errors) {
+            std::cout << "error: " << error << "\n";
+        }
+        // Types are only meaningful for sources that check
+        for(size_t node = 0; result.errors.empty() && node < result.types.size(); node++) {
+            std::cout << node << ": " << result.types[node] << "\n";
+        }
+    });
+}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace HKSL::Testing {
+// What the front end concluded about a source
+struct CheckResult {
+    std::vector<std::string> errors;
+    // Inferred type of every node in id order, "-" where there's none
+    std::vector<std::string> types;
+
+    bool operator==(const CheckResult& other) const = default;
+};
+// Parses and checks `source` the way Compiler::compile does, but returns
+// the errors instead of exiting. The source must parse.
+CheckResult check(const std::string& source, bool fused, size_t n_threads = 1);
+// Errors only, for tests of a single diagnostic
+std::vector<std::string> errors_of(const std::string& source);
+// Runs `body` in a child process, for code that may exit. Whatever it
+// printed to stdout, then its exit status.
+std::string run_isolated(const std::function<void()>& body);
+// Runs check in a child process, for sources the front end may exit on.
+// Whatever the child printed, its exit status and the result if it got
+// that far as text, types only if there were no errors.
+std::string check_isolated(const std::string& source, bool fused, size_t n_threads = 1);
+}
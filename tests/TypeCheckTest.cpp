@@ -0,0 +1,63 @@
+#include "TestUtil.h"
+#include <Context.h>
+#include <Parser.h>
+#include <TypeCheck.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+using testing::ElementsAre;
+
+TEST(TypeCheck, BareReturnReturnsVoid) {
+    EXPECT_TRUE(Testing::errors_of("fn f() { return; }").empty());
+    EXPECT_THAT(Testing::errors_of("fn f() -> float { return; }"),
+        ElementsAre("1:19: Incorrect return type, expected: float, got: void"));
+}
+TEST(TypeCheck, BareReturnFused) {
+    EXPECT_TRUE(Testing::check("fn f() { return; }", true).errors.empty());
+}
+TEST(TypeCheck, ArgumentCountIsCheckedFirst) {
+    const char* source =
+        "fn g(a: float, b: float) -> float { return a; }\n"
+        "fn f() -> float { return g(1.0); }\n";
+    EXPECT_THAT(Testing::errors_of(source),
+        ElementsAre("1:4: Incorrect no. of args of function call, provided 1, expected 2"));
+    EXPECT_EQ(Testing::check(source, true).errors, Testing::errors_of(source));
+}
+// The let is reported along with the error in its rhs
+TEST(TypeCheck, LetOfUntypedRhsCantBeInferred) {
+    EXPECT_THAT(Testing::errors_of("fn f(a: float, b: float3) { let x = a + b; }"), ElementsAre(
+        "1:39: Types of left and right side of binary expression don't match, left: float, right: float3",
+        "1:33: Couldn't infer type for variable x, please specify its manually"));
+}
+
+// Types the expression statement `source` with a single visitor, returns
+// how often a node was typed per node of the expression
+static double typings_per_node(const std::string& source) {
+    SymbolInterner symbols;
+    SourceManager sources;
+    uint32_t file = sources.add_buffer("typings.hksl", source);
+    CompilationContext context(symbols, sources);
+    Lexer lexer(sources.file(file), symbols);
+    Parser parser(context, lexer);
+    context.set_ast(parser.program());
+
+    AST& ast = context.get_ast();
+    NodeId root = ast.expr_statement(ast.top_level().front()).expr;
+    TypeInferenceVisitor type_inference(context);
+    EXPECT_EQ(type_inference.infer(ast, root), context.type_registry().get_float());
+    EXPECT_TRUE(context.is_success());
+
+    // Every node but the statement belongs to the expression
+    return (double) type_inference.typed_nodes() / (ast.size() - 1);
+}
+// Inference is one bottom-up walk typing each node once, whatever the
+// shape of the tree. Timings are in bench/TypeInferenceBench.cpp.
+TEST(TypeCheck, InferenceTypesEachNodeOnce) {
+    std::string sum = "1.0";
+    for(size_t i = 1; i < 100'000; i++) {
+        sum += " + 1.0";
+    }
+    EXPECT_EQ(typings_per_node(sum + ";"), 1.0);
+    EXPECT_EQ(typings_per_node("-(1.0 + 2.0) * (3.0 - -(4.0 / 5.0));"), 1.0);
+}
@@ -0,0 +1,98 @@
+#include <Compiler.h>
+#include <format>
+#include <gtest/gtest.h>
+
+using namespace HKSL;
+
+// Reads per byte in std430: c and f 3/4, b 4/12, a 1/4, d 2/16, e is never
+// read. c and f tie, c is updated more often so it ranks first, although f
+// is declared first.
+static const char* SOURCE = R"(uniform(frame) a: float;
+uniform(material) b: float3;
+uniform(material) f: float;
+uniform c: float;
+uniform(frame) d: float4;
+uniform e: float;
+
+fn vertex_main(p: float4) -> float4 {
+    let x = a + c + c + c + f + f + f;
+    let y = b + b + b + b;
+    return p * d + d * float4(y, x);
+}
+)";
+
+// One line per block, members by offset
+static std::vector<std::string> place(uint32_t budget) {
+    SymbolInterner symbols;
+    Compiler compiler(symbols, 1);
+    compiler.set_push_constant_budget(budget);
+    auto result = compiler.compile("test.hksl", SOURCE);
+
+    std::vector<std::string> blocks;
+    for(const auto& block: result.uniform_blocks) {
+        std::string text = std::format("{} {} binding {} size {}:", block_kind_to_string(block.kind), update_frequency_to_string(block.frequency), block.binding, block.size);
+        for(const auto& member: block.members) {
+            text += std::format(" {}@{}", member.name, member.offset);
+        }
+        blocks.push_back(text);
+    }
+    return blocks;
+}
+
+TEST(UniformPlacement, Budget0) {
+    EXPECT_EQ(place(0), (std::vector<std::string> {
+        "uniform_buffer frame binding 0 size 32: d@0 a@16",
+        "uniform_buffer material binding 1 size 16: b@0 f@12",
+        "uniform_buffer draw binding 2 size 16: c@0 e@4",
+    }));
+}
+// b doesn't fit next to c and f, a does
+TEST(UniformPlacement, Budget16) {
+    EXPECT_EQ(place(16), (std::vector<std::string> {
+        "push_constant draw binding 0 size 12: c@0 f@4 a@8",
+        "uniform_buffer frame binding 0 size 16: d@0",
+        "uniform_buffer material binding 1 size 16: b@0",
+        "uniform_buffer draw binding 2 size 16: e@0",
+    }));
+}
+TEST(UniformPlacement, Budget32) {
+    EXPECT_EQ(place(32), (std::vector<std::string> {
+        "push_constant draw binding 0 size 32: b@0 c@12 f@16 a@20",
+        "uniform_buffer frame binding 0 size 16: d@0",
+        "uniform_buffer draw binding 1 size 16: e@0",
+    }));
+}
+// The floats filling the holes are placed in ranking order, c before f
+TEST(UniformPlacement, Budget128) {
+    EXPECT_EQ(place(128), (std::vector<std::string> {
+        "push_constant draw binding 0 size 48: d@0 b@16 c@28 f@32 a@36",
+        "uniform_buffer draw binding 0 size 16: e@0",
+    }));
+}
+// A struct uniform is placed with the layout its reflection reports, p b q
+// keep their declared order unless struct fields are reordered
+TEST(UniformPlacement, StructMemberLayout) {
+    static const char* source = R"(struct S {
+    a: float,
+    p: float3,
+    b: float,
+    q: float3,
+}
+uniform(frame) s: S;
+)";
+    for(bool reorder: {false, true}) {
+        SymbolInterner symbols;
+        Compiler compiler(symbols, 1);
+        compiler.set_push_constant_budget(0);
+        compiler.set_reorder_struct_fields(reorder);
+        auto result = compiler.compile("test.hksl", source);
+        ASSERT_TRUE(result.is_success());
+
+        ASSERT_EQ(result.structs.size(), 1u);
+        ASSERT_EQ(result.uniform_blocks.size(), 1u);
+        const StructLayout& layout = result.structs[0].layouts[(size_t) LayoutRule::Std140];
+        EXPECT_EQ(layout.size, reorder ? 32u : 48u);
+        EXPECT_EQ(result.uniform_blocks[0].size, layout.size) << "reorder " << reorder;
+        EXPECT_EQ(result.uniform_blocks[0].members[0].size, layout.size) << "reorder " << reorder;
+    }
+}
@@ -0,0 +1,19 @@
+# Compiles SOURCE to OUTPUT with HKSL and checks the binary with SPIRV_VAL.
+# Run by ctest, see tests/CMakeLists.txt.
+execute_process(
+    COMMAND ${HKSL} ${SOURCE} --spv ${OUTPUT}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "hksl failed on ${SOURCE}:\n${output}")
+endif()
+
+execute_process(
+    COMMAND ${SPIRV_VAL} --target-env vulkan1.0 ${OUTPUT}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "spirv-val rejected ${OUTPUT}:\n${output}")
+endif()